@@ -0,0 +1,383 @@
+/*
+ * Microbenchmarks of the math, pose and skinning hot paths.
+ * Human readable table goes to stderr, JSON results to stdout (or --json FILE).
+ */
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "Matrix.h"
+#include "Skeleton.h"
+#include "Animation.h"
+#include "Geometry.h"
+#include "SMDLoader.h"
+#include "Pose.h"
+#include "PoseBatch.h"
+#include "LocalPose.h"
+#include "WalkRunBlending.h"
+#include "LinearBlending.h"
+#include "MeshClusters.h"
+#include "Camera.h"
+#include "Frustum.h"
+#include "Benchmark.h"
+
+//fixed seed random numbers, so every run measures the same data
+static unsigned int bench_seed = 12345;
+
+static float RandomFloat() {
+    bench_seed = bench_seed * 1664525u + 1013904223u;
+    return (bench_seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+}
+
+static Matrix_4x4 RandomTransform() {
+    Vector3 axis = Vector3::Normalize(Vector3(RandomFloat(), RandomFloat(), RandomFloat()));
+    Vector3 trans = Vector3(RandomFloat(), RandomFloat(), RandomFloat()) * 10.0f;
+    return Matrix_4x4::Translation(trans) * Matrix_4x4::RotationAngleAxis(axis, RandomFloat() * 3.14f);
+}
+
+static bool FileExists(std::string filename) {
+    std::ifstream f(filename.c_str());
+    return f.good();
+}
+
+//MATH ==========================================================================================
+
+static const int NUM_MATRICES = 1024;
+
+class MatrixMultiplyBench : public BenchCase {
+    public:
+        MatrixMultiplyBench() : BenchCase("Matrix_4x4::operator*", NUM_MATRICES) {
+            for (int i = 0; i < NUM_MATRICES + 1; i++) {
+                matrices.push_back(RandomTransform());
+            }
+        }
+        void Run() {
+            float sum = 0;
+            for (int i = 0; i < NUM_MATRICES; i++) {
+                Matrix_4x4 m = matrices[i] * matrices[i + 1];
+                sum += m.xw;
+            }
+            bench_sink = sum;
+        }
+        std::vector<Matrix_4x4> matrices;
+};
+
+class MatrixInverseBench : public BenchCase {
+    public:
+        MatrixInverseBench() : BenchCase("Matrix_4x4::Inverse", NUM_MATRICES) {
+            for (int i = 0; i < NUM_MATRICES; i++) {
+                matrices.push_back(RandomTransform());
+            }
+        }
+        void Run() {
+            float sum = 0;
+            for (int i = 0; i < NUM_MATRICES; i++) {
+                sum += Matrix_4x4::Inverse(matrices[i]).xw;
+            }
+            bench_sink = sum;
+        }
+        std::vector<Matrix_4x4> matrices;
+};
+
+//POSE ==========================================================================================
+
+class JointTransformBench : public BenchCase {
+    public:
+        JointTransformBench(const Skeleton* skel) : BenchCase("Skeleton::JointTransform/all_joints", skel->NumJoints()), skel(skel) {}
+        void Run() {
+            float sum = 0;
+            for (int i = 0; i < skel->NumJoints(); i++) {
+                sum += skel->JointTransform(i).xw;
+            }
+            bench_sink = sum;
+        }
+        const Skeleton* skel;
+};
+
+class TransPerFrameBench : public BenchCase {
+    public:
+        TransPerFrameBench(Animation* anim) : BenchCase("ComputeTransPerFrameGB/run", anim->NumFrames()), anim(anim) {}
+        void Run() {
+            ComputeTransPerFrameGB(tpf_gb, anim);
+            bench_sink = tpf_gb[0][0].xw;
+        }
+        Animation* anim;
+        std::vector<std::vector<Matrix_4x4> > tpf_gb;
+};
+
+//one skeleton composed on its own, per skeleton
+class TransGBBench : public BenchCase {
+    public:
+        TransGBBench(const Skeleton* skel) : BenchCase("ComputeTransGB/skeleton", 1), skel(skel) {}
+        void Run() {
+            ComputeTransGB(trans_gb, skel);
+            bench_sink = trans_gb[0].xw;
+        }
+        const Skeleton* skel;
+        std::vector<Matrix_4x4> trans_gb;
+};
+
+//the same skeletons composed in SoA lanes, per skeleton
+class PoseBatchBench : public BenchCase {
+    public:
+        PoseBatchBench(const Animation* anim)
+            : BenchCase("PoseBatch::Compose/" + LanesName(), SKIN_POSE_LANES), batch(anim->Topology()) {
+            for (int lane = 0; lane < SKIN_POSE_LANES; lane++) {
+                batch.SetLocal(lane, anim->GetFrame(lane % anim->NumFrames()));
+            }
+        }
+        void Run() {
+            batch.Compose();
+            bench_sink = batch.Global(0, 0).xw;
+        }
+        static std::string LanesName() {
+            char name[32];
+            sprintf(name, "%d_lanes", SKIN_POSE_LANES);
+            return name;
+        }
+        PoseBatch batch;
+};
+
+//one whole pose blended from the first num_poses frames of the clip, per pose
+class BlendLocalPosesBench : public BenchCase {
+    public:
+        BlendLocalPosesBench(std::string name, const std::vector<LocalPose>& local_poses, int num_poses) : BenchCase(name, 1) {
+            for (int p = 0; p < num_poses; p++) {
+                poses.Add(&local_poses[p % local_poses.size()], 1.0f / num_poses);
+            }
+        }
+        void Run() {
+            BlendLocalPoses(poses, out);
+            bench_sink = out.qw[0];
+        }
+        LocalPoses poses;
+        LocalPose out;
+};
+
+class WalkRunDistsBench : public BenchCase {
+    public:
+        WalkRunDistsBench(std::vector<std::vector<Matrix_4x4> >& walk_tpf_gb, std::vector<std::vector<Matrix_4x4> >& run_tpf_gb)
+            : BenchCase("ComputeWalkRunDists", 1), walk_tpf_gb(walk_tpf_gb), run_tpf_gb(run_tpf_gb) {}
+        void Run() {
+            std::vector<std::vector<float> > dists;
+            ComputeWalkRunDists(dists, walk_tpf_gb, run_tpf_gb);
+            bench_sink = dists[0][0];
+        }
+        std::vector<std::vector<Matrix_4x4> >& walk_tpf_gb;
+        std::vector<std::vector<Matrix_4x4> >& run_tpf_gb;
+};
+
+//SKINNING ======================================================================================
+
+class LinearBlendingBench : public BenchCase {
+    public:
+        LinearBlendingBench(std::string name, Mesh* mesh, std::vector<Matrix_4x4>& pose_gb, std::vector<Matrix_4x4>& rest_trans_lc, int output)
+            : BenchCase(name, mesh->NumVertices()), mesh(mesh), pose_gb(pose_gb), rest_trans_lc(rest_trans_lc), output(output) {}
+        void Run() {
+            float sum = 0;
+            for (int i = 0; i < mesh->NumVertices(); i++) {
+                Vertex vrtx = LinearBlending(mesh->m_vertices[i], pose_gb, rest_trans_lc, output);
+                sum += vrtx.position.x + vrtx.normal.x;
+            }
+            bench_sink = sum;
+        }
+        Mesh* mesh;
+        std::vector<Matrix_4x4>& pose_gb;
+        std::vector<Matrix_4x4>& rest_trans_lc;
+        int output;
+};
+
+//palette blended from 2 poses and the mesh skinned with it, one call per frame as the viewer does
+class SkinMeshPaletteBench : public BenchCase {
+    public:
+        SkinMeshPaletteBench(Mesh* mesh, std::vector<Matrix_4x4>& pose_1_gb, std::vector<Matrix_4x4>& pose_2_gb, std::vector<Matrix_4x4>& rest_trans_lc)
+            : BenchCase("SkinMeshPalette/2_poses", mesh->NumVertices()), mesh(mesh), rest_trans_lc(rest_trans_lc)
+            , palette(rest_trans_lc.size()), positions(mesh->NumVertices() * 3), normals(mesh->NumVertices() * 3) {
+            poses.Add(&pose_1_gb, 0.5f);
+            poses.Add(&pose_2_gb, 0.5f);
+        }
+        void Run() {
+            ComputeSkinPalette(poses, rest_trans_lc, &palette[0]);
+            SkinMeshPalette(mesh, &palette[0], SKIN_OUTPUT_ALL, &positions[0], &normals[0]);
+            bench_sink = positions[0] + normals[0];
+        }
+        Mesh* mesh;
+        std::vector<Matrix_4x4>& rest_trans_lc;
+        SkinPoses poses;
+        std::vector<Matrix_4x4> palette;
+        std::vector<float> positions;
+        std::vector<float> normals;
+};
+
+//cluster bounds of the character posed and tested against the view of the viewer
+class ClusterCullBench : public BenchCase {
+    public:
+        ClusterCullBench(Mesh* mesh, int num_joints, std::vector<Matrix_4x4>& pose_gb, std::vector<Matrix_4x4>& rest_trans_lc)
+            : BenchCase("MeshClusters::Cull", 1), palette(rest_trans_lc.size())
+            , eye(20, 30, 50), camera(eye, Vector3(0, 15, 0)) {
+            clusters.Build(mesh, num_joints);
+            runs.resize(clusters.NumClusters());
+            borrowed.resize(clusters.NumBorrowed() + 1);
+            SkinPoses poses;
+            poses.Add(&pose_gb, 1.0f);
+            ComputeSkinPalette(poses, rest_trans_lc, &palette[0]);
+            camera.SetFOV(40.0f * M_PI / 180.0f);
+            camera.SetNearClipPlane(1.0f);
+            camera.SetFarClipPlane(1000.0f);
+        }
+        void Run() {
+            Frustum frustum(camera, 800.0f / 600.0f);
+            ClusterSelection selection;
+            selection.runs = &runs[0];
+            selection.borrowed = &borrowed[0];
+            clusters.Cull(&palette[0], frustum, eye, selection);
+            bench_sink = selection.num_runs + selection.num_borrowed;
+        }
+        MeshClusters clusters;
+        std::vector<Matrix_4x4> palette;
+        std::vector<ClusterRun> runs;
+        std::vector<int> borrowed;
+        Vector3 eye;
+        Camera camera;
+};
+
+//LOADING =======================================================================================
+
+class LoadAnimationBench : public BenchCase {
+    public:
+        LoadAnimationBench(std::string filename) : BenchCase("LoadSMDAnimation/" + filename, 1), filename(filename) {}
+        void Run() {
+            Animation* anim = NULL;
+            LoadSMDAnimation(filename, &anim);
+            bench_sink = anim->NumFrames();
+            delete anim;
+        }
+        std::string filename;
+};
+
+class LoadCharacterBench : public BenchCase {
+    public:
+        LoadCharacterBench(std::string filename) : BenchCase("LoadSMDCharacter/" + filename, 1), filename(filename) {}
+        void Run() {
+            Mesh* mesh = NULL;
+            LoadSMDCharacter(filename, &mesh);
+            bench_sink = mesh->NumVertices();
+            delete mesh;
+        }
+        std::string filename;
+};
+
+static void PrintUsage() {
+    printf("usage: bench [options]\n");
+    printf("  --resources DIR  directory with smd files (./resources)\n");
+    printf("  --warmup N       unmeasured runs per benchmark (10)\n");
+    printf("  --reps N         measured runs per benchmark (100)\n");
+    printf("  --filter TEXT    run only benchmarks whose name contains TEXT\n");
+    printf("  --json FILE      write JSON results into FILE instead of stdout\n");
+}
+
+int main(int argc, char **argv) {
+
+    std::string resources = "./resources";
+    std::string filter = "";
+    std::string json_filename = "";
+    int warmup = 10;
+    int repetitions = 100;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--resources" && has_value) {
+            resources = argv[++i];
+        } else if (arg == "--warmup" && has_value) {
+            warmup = atoi(argv[++i]);
+        } else if (arg == "--reps" && has_value) {
+            repetitions = atoi(argv[++i]);
+        } else if (arg == "--filter" && has_value) {
+            filter = argv[++i];
+        } else if (arg == "--json" && has_value) {
+            json_filename = argv[++i];
+        } else {
+            PrintUsage();
+            return (arg == "--help" || arg == "-h") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (repetitions < 1) repetitions = 1;
+    if (warmup < 0) warmup = 0;
+
+    Animation* rest_animation = NULL;
+    Animation* run_animation = NULL;
+    Animation* walk_animation = NULL;
+    LoadSMDAnimation(resources + "/rest_animation.smd", &rest_animation);
+    LoadSMDAnimation(resources + "/run_animation.smd",  &run_animation);
+    LoadSMDAnimation(resources + "/walk_animation.smd", &walk_animation);
+
+    std::vector<Matrix_4x4> rest_trans_lc;
+    std::vector<std::vector<Matrix_4x4> > run_tpf_gb;
+    std::vector<std::vector<Matrix_4x4> > walk_tpf_gb;
+    std::vector<LocalPose> run_local;
+    ComputeRestTransLC(rest_trans_lc, rest_animation->GetFrame(0));
+    ComputeLocalPoses(run_local, run_animation);
+    ComputeTransPerFrameGB(run_tpf_gb, run_animation);
+    ComputeTransPerFrameGB(walk_tpf_gb, walk_animation);
+
+    std::vector<BenchCase*> cases;
+    cases.push_back(new MatrixMultiplyBench());
+    cases.push_back(new MatrixInverseBench());
+    cases.push_back(new JointTransformBench(run_animation->GetFrame(0)));
+    cases.push_back(new TransPerFrameBench(run_animation));
+    cases.push_back(new TransGBBench(run_animation->GetFrame(0)));
+    cases.push_back(new PoseBatchBench(run_animation));
+    cases.push_back(new BlendLocalPosesBench("BlendLocalPoses/2_poses", run_local, 2));
+    cases.push_back(new BlendLocalPosesBench("BlendLocalPoses/4_poses", run_local, 4));
+    cases.push_back(new WalkRunDistsBench(walk_tpf_gb, run_tpf_gb));
+
+    //the character isn't shipped with every checkout
+    Mesh* character = NULL;
+    std::string character_filename = resources + "/character.smd";
+    if (FileExists(character_filename)) {
+        LoadSMDCharacter(character_filename, &character);
+        cases.push_back(new LinearBlendingBench("LinearBlending/per_vertex", character, run_tpf_gb[0], rest_trans_lc, SKIN_OUTPUT_ALL));
+        cases.push_back(new LinearBlendingBench("LinearBlending/per_vertex_positions", character, run_tpf_gb[0], rest_trans_lc, SKIN_OUTPUT_POSITIONS));
+        cases.push_back(new SkinMeshPaletteBench(character, run_tpf_gb[0], run_tpf_gb[1], rest_trans_lc));
+        cases.push_back(new ClusterCullBench(character, rest_animation->Topology()->NumJoints(), run_tpf_gb[0], rest_trans_lc));
+        cases.push_back(new LoadCharacterBench(character_filename));
+    } else {
+        fprintf(stderr, "%s not found, skipping LinearBlending and LoadSMDCharacter\n", character_filename.c_str());
+    }
+    cases.push_back(new LoadAnimationBench(resources + "/rest_animation.smd"));
+    cases.push_back(new LoadAnimationBench(resources + "/run_animation.smd"));
+    cases.push_back(new LoadAnimationBench(resources + "/walk_animation.smd"));
+
+    std::vector<BenchStats> stats;
+    for (size_t i = 0; i < cases.size(); i++) {
+        if (filter.empty() || cases[i]->name.find(filter) != std::string::npos) {
+            stats.push_back(RunBenchCase(*cases[i], warmup, repetitions));
+        }
+        delete cases[i];
+    }
+
+    PrintBenchTable(stderr, stats);
+
+    if (json_filename.empty()) {
+        WriteBenchJSON(stdout, stats, warmup, repetitions);
+    } else {
+        FILE* f = fopen(json_filename.c_str(), "w");
+        if (f == NULL) {
+            fprintf(stderr, "Failed to open %s\n", json_filename.c_str());
+            return EXIT_FAILURE;
+        }
+        WriteBenchJSON(f, stats, warmup, repetitions);
+        fclose(f);
+    }
+
+    delete character;
+    delete rest_animation;
+    delete run_animation;
+    delete walk_animation;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,354 @@
+/*
+ * Scaling scenarios on synthetic assets. Sweeps asset sizes and thread counts through
+ * the skinning, pose evaluation and walk/run blending pipelines and charts the throughput,
+ * so we can see where each path stops scaling. Raw numbers can be written as CSV.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "Skeleton.h"
+#include "Animation.h"
+#include "Geometry.h"
+#include "Pose.h"
+#include "WalkRunBlending.h"
+#include "LinearBlending.h"
+#include "WorkerPool.h"
+#include "Synthetic.h"
+#include "Timer.h"
+#include "Benchmark.h"
+
+struct ScenarioResult {
+    std::string scenario;
+    std::string unit;
+    int size;
+    int threads;
+    double seconds;     //median time of one run
+    double throughput;  //units per second
+};
+
+struct ScenarioConfig {
+    std::vector<int> threads;
+    int joints;         //skeleton of skinning and blending scenarios
+    int depth;          //max skeleton depth of all scenarios
+    int influences;
+    int clip_frames;    //frames of the clips used by pose scenario
+    double min_seconds; //measure every point at least that long
+};
+
+//Median seconds of one ParallelFor over count items
+static double MeasureParallel(WorkerPool& pool, int count, int chunk_size, RangeTask* task, double min_seconds) {
+    std::vector<double> samples;
+    double total = 0;
+    pool.ParallelFor(count, chunk_size, task); //warmup
+    while (samples.size() < 3 || total < min_seconds) {
+        double start = TimeSeconds();
+        pool.ParallelFor(count, chunk_size, task);
+        double elapsed = TimeSeconds() - start;
+        samples.push_back(elapsed);
+        total += elapsed;
+    }
+    return Percentile(samples, 0.5);
+}
+
+//split count items into about 4 chunks per thread, so uneven chunks still balance
+static int ChunkSize(int count, int threads) {
+    return std::max(1, count / (threads * 4));
+}
+
+//SKINNING ======================================================================================
+
+//vertices/sec of time interpolated skinning (two poses per vertex)
+static void SkinningScenario(std::vector<int>& sizes, ScenarioConfig& config, std::vector<ScenarioResult>& results) {
+    SkeletonPool skeletons;
+    Skeleton* rest = GenerateSkeleton(skeletons, config.joints, config.depth, 1);
+    Animation* clip = GenerateAnimation(rest, 2, 2);
+
+    std::vector<Matrix_4x4> rest_trans_lc;
+    std::vector<std::vector<Matrix_4x4> > tpf_gb;
+    ComputeRestTransLC(rest_trans_lc, rest);
+    ComputeTransPerFrameGB(tpf_gb, clip);
+
+    SkinPoses poses;
+    poses.Add(&tpf_gb[0], 0.5f);
+    poses.Add(&tpf_gb[1], 0.5f);
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        Mesh* mesh = GenerateMesh(rest, sizes[s], config.influences, 3);
+        std::vector<float> positions(mesh->NumVertices() * 3);
+        std::vector<float> normals(mesh->NumVertices() * 3);
+
+        for (size_t t = 0; t < config.threads.size(); t++) {
+            WorkerPool pool(config.threads[t]);
+            int chunk_size = ChunkSize(mesh->NumVertices(), pool.NumThreads());
+
+            std::vector<double> samples;
+            double total = 0;
+            while (samples.size() < 3 || total < config.min_seconds) {
+                double start = TimeSeconds();
+                SkinMeshParallel(pool, chunk_size, mesh, rest_trans_lc, poses, SKIN_OUTPUT_ALL, &positions[0], &normals[0]);
+                double elapsed = TimeSeconds() - start;
+                samples.push_back(elapsed);
+                total += elapsed;
+            }
+
+            ScenarioResult result;
+            result.scenario = "skinning";
+            result.unit = "vertices/s";
+            result.size = mesh->NumVertices();
+            result.threads = pool.NumThreads();
+            result.seconds = Percentile(samples, 0.5);
+            result.throughput = mesh->NumVertices() / result.seconds;
+            results.push_back(result);
+        }
+        delete mesh;
+    }
+
+    delete clip;
+}
+
+//POSE ==========================================================================================
+
+class PoseTask : public RangeTask {
+    public:
+        PoseTask(Animation* clip, std::vector<std::vector<Matrix_4x4> >& tpf_gb) : clip(clip), tpf_gb(tpf_gb) {}
+        void Run(int begin, int end, int worker_id) {
+            for (int f = begin; f < end; f++) {
+                ComputeTransGB(tpf_gb[f], clip->GetFrame(f));
+            }
+        }
+        Animation* clip;
+        std::vector<std::vector<Matrix_4x4> >& tpf_gb;
+};
+
+//joints/sec of global transforms evaluation, frames are spread across threads
+static void PoseScenario(std::vector<int>& sizes, ScenarioConfig& config, std::vector<ScenarioResult>& results) {
+    for (size_t s = 0; s < sizes.size(); s++) {
+        SkeletonPool skeletons;
+        Skeleton* rest = GenerateSkeleton(skeletons, sizes[s], config.depth, 4);
+        Animation* clip = GenerateAnimation(rest, config.clip_frames, 5);
+        std::vector<std::vector<Matrix_4x4> > tpf_gb(clip->NumFrames());
+        PoseTask task(clip, tpf_gb);
+
+        for (size_t t = 0; t < config.threads.size(); t++) {
+            WorkerPool pool(config.threads[t]);
+            ScenarioResult result;
+            result.scenario = "pose";
+            result.unit = "joints/s";
+            result.size = sizes[s];
+            result.threads = pool.NumThreads();
+            result.seconds = MeasureParallel(pool, clip->NumFrames(), ChunkSize(clip->NumFrames(), pool.NumThreads()),
+                                             &task, config.min_seconds);
+            result.throughput = (double)sizes[s] * clip->NumFrames() / result.seconds;
+            results.push_back(result);
+        }
+        delete clip;
+    }
+}
+
+//BLENDING ======================================================================================
+
+class DistsTask : public RangeTask {
+    public:
+        DistsTask(std::vector<std::vector<Matrix_4x4> >& walk_tpf_gb, std::vector<std::vector<Matrix_4x4> >& run_tpf_gb,
+                  std::vector<std::vector<float> >& dists)
+            : walk_tpf_gb(walk_tpf_gb), run_tpf_gb(run_tpf_gb), dists(dists) {}
+        void Run(int begin, int end, int worker_id) {
+            for (int walk_id = begin; walk_id < end; walk_id++) {
+                for (size_t run_id = 0; run_id < run_tpf_gb.size(); run_id++) {
+                    dists[walk_id][run_id] = ComputeDistSkel(run_tpf_gb[run_id], walk_tpf_gb[walk_id]);
+                }
+            }
+        }
+        std::vector<std::vector<Matrix_4x4> >& walk_tpf_gb;
+        std::vector<std::vector<Matrix_4x4> >& run_tpf_gb;
+        std::vector<std::vector<float> >& dists;
+};
+
+//frame pairs/sec of walk/run distance table, size is the length of both clips
+static void BlendingScenario(std::vector<int>& sizes, ScenarioConfig& config, std::vector<ScenarioResult>& results) {
+    SkeletonPool skeletons;
+    Skeleton* rest = GenerateSkeleton(skeletons, config.joints, config.depth, 6);
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        Animation* walk = GenerateAnimation(rest, sizes[s], 7);
+        Animation* run = GenerateAnimation(rest, sizes[s], 8);
+        std::vector<std::vector<Matrix_4x4> > walk_tpf_gb;
+        std::vector<std::vector<Matrix_4x4> > run_tpf_gb;
+        ComputeTransPerFrameGB(walk_tpf_gb, walk);
+        ComputeTransPerFrameGB(run_tpf_gb, run);
+        std::vector<std::vector<float> > dists(sizes[s], std::vector<float>(sizes[s]));
+        DistsTask task(walk_tpf_gb, run_tpf_gb, dists);
+
+        for (size_t t = 0; t < config.threads.size(); t++) {
+            WorkerPool pool(config.threads[t]);
+            ScenarioResult result;
+            result.scenario = "blending";
+            result.unit = "pairs/s";
+            result.size = sizes[s];
+            result.threads = pool.NumThreads();
+            result.seconds = MeasureParallel(pool, sizes[s], ChunkSize(sizes[s], pool.NumThreads()), &task, config.min_seconds);
+            result.throughput = (double)sizes[s] * sizes[s] / result.seconds;
+            results.push_back(result);
+        }
+        delete walk;
+        delete run;
+    }
+}
+
+//OUTPUT ========================================================================================
+
+//bars are relative to the best throughput of the scenario, speedup is relative to the first thread count
+static void PrintChart(std::vector<ScenarioResult>& results, std::string scenario) {
+    const int width = 50;
+    double best = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i].scenario == scenario) {
+            best = std::max(best, results[i].throughput);
+        }
+    }
+    if (best <= 0) {
+        return;
+    }
+
+    printf("\n%s\n", scenario.c_str());
+    int prev_size = -1;
+    double base = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        ScenarioResult& r = results[i];
+        if (r.scenario != scenario) {
+            continue;
+        }
+        if (r.size != prev_size) {
+            prev_size = r.size;
+            base = r.throughput;
+            printf("  size %d\n", r.size);
+        }
+        int bar = (int)(width * r.throughput / best + 0.5);
+        printf("    %3d thr |%-*s| %10.3g %s x%.2f\n", r.threads, width, std::string(bar, '#').c_str(),
+               r.throughput, r.unit.c_str(), r.throughput / base);
+    }
+}
+
+static void WriteCSV(FILE* f, std::vector<ScenarioResult>& results) {
+    fprintf(f, "scenario,size,threads,seconds,throughput,unit\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        fprintf(f, "%s,%d,%d,%.9f,%.1f,%s\n", results[i].scenario.c_str(), results[i].size, results[i].threads,
+                results[i].seconds, results[i].throughput, results[i].unit.c_str());
+    }
+}
+
+//comma separated integers
+static std::vector<int> ParseList(const char* text) {
+    std::vector<int> list;
+    std::string item;
+    for (const char* c = text; ; c++) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) {
+                list.push_back(atoi(item.c_str()));
+            }
+            item.clear();
+            if (*c == '\0') break;
+        } else {
+            item += *c;
+        }
+    }
+    return list;
+}
+
+static void PrintUsage() {
+    printf("usage: scenarios [options]\n");
+    printf("  --scenario NAME      skinning, pose, blending or all (all)\n");
+    printf("  --threads LIST       thread counts, e.g. 1,2,4 (powers of two up to hardware threads)\n");
+    printf("  --vertices LIST      mesh sizes of skinning scenario (1000,10000,100000,1000000)\n");
+    printf("  --joints-sweep LIST  skeleton sizes of pose scenario (32,128,512,2048)\n");
+    printf("  --frames-sweep LIST  clip lengths of blending scenario (50,100,200,400)\n");
+    printf("  --joints N           skeleton size of skinning and blending scenarios (64)\n");
+    printf("  --depth N            max skeleton depth (16)\n");
+    printf("  --influences N       joints per vertex, 1 to 3 (3)\n");
+    printf("  --clip-frames N      clip length of pose scenario (240)\n");
+    printf("  --min-time SEC       measure every point at least that long (0.2)\n");
+    printf("  --csv FILE           write raw results as CSV\n");
+}
+
+int main(int argc, char **argv) {
+
+    std::string scenario = "all";
+    std::string csv_filename = "";
+    std::vector<int> vertices = ParseList("1000,10000,100000,1000000");
+    std::vector<int> joints_sweep = ParseList("32,128,512,2048");
+    std::vector<int> frames_sweep = ParseList("50,100,200,400");
+
+    ScenarioConfig config;
+    config.joints = 64;
+    config.depth = 16;
+    config.influences = 3;
+    config.clip_frames = 240;
+    config.min_seconds = 0.2;
+    for (int t = 1; t <= WorkerPool::HardwareThreads(); t *= 2) {
+        config.threads.push_back(t);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--scenario" && has_value) {
+            scenario = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            config.threads = ParseList(argv[++i]);
+        } else if (arg == "--vertices" && has_value) {
+            vertices = ParseList(argv[++i]);
+        } else if (arg == "--joints-sweep" && has_value) {
+            joints_sweep = ParseList(argv[++i]);
+        } else if (arg == "--frames-sweep" && has_value) {
+            frames_sweep = ParseList(argv[++i]);
+        } else if (arg == "--joints" && has_value) {
+            config.joints = atoi(argv[++i]);
+        } else if (arg == "--depth" && has_value) {
+            config.depth = atoi(argv[++i]);
+        } else if (arg == "--influences" && has_value) {
+            config.influences = atoi(argv[++i]);
+        } else if (arg == "--clip-frames" && has_value) {
+            config.clip_frames = atoi(argv[++i]);
+        } else if (arg == "--min-time" && has_value) {
+            config.min_seconds = atof(argv[++i]);
+        } else if (arg == "--csv" && has_value) {
+            csv_filename = argv[++i];
+        } else {
+            PrintUsage();
+            return (arg == "--help" || arg == "-h") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (config.threads.empty()) {
+        config.threads.push_back(1);
+    }
+
+    std::vector<ScenarioResult> results;
+    if (scenario == "all" || scenario == "skinning") {
+        SkinningScenario(vertices, config, results);
+        PrintChart(results, "skinning");
+    }
+    if (scenario == "all" || scenario == "pose") {
+        PoseScenario(joints_sweep, config, results);
+        PrintChart(results, "pose");
+    }
+    if (scenario == "all" || scenario == "blending") {
+        BlendingScenario(frames_sweep, config, results);
+        PrintChart(results, "blending");
+    }
+
+    if (!csv_filename.empty()) {
+        FILE* f = fopen(csv_filename.c_str(), "w");
+        if (f == NULL) {
+            printf("Failed to open %s\n", csv_filename.c_str());
+            return EXIT_FAILURE;
+        }
+        WriteCSV(f, results);
+        fclose(f);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <string.h>
 #include <iostream>
@@ -9,6 +10,9 @@
 #include <map>
 
 #include <GL/glut.h>
+#ifdef __linux__
+#include <GL/glx.h>
+#endif
 
 #define GLUT_KEY_ESCAPE 27
 #ifndef GLUT_WHEEL_UP
@@ -23,6 +27,20 @@
 #include "Skeleton.h"
 #include "Animation.h"
 #include "Camera.h"
+#include "AnimationSet.h"
+#include "LinearBlending.h"
+#include "FrameProfiler.h"
+#include "Trace.h"
+#include "AllocTracker.h"
+#include "CharacterContext.h"
+#include "Crowd.h"
+#include "Frustum.h"
+#include "MeshClusters.h"
+#include "WorkerPool.h"
+#include "Simulation.h"
+#include "Autotune.h"
+#include "FramePacer.h"
+#include "Timer.h"
 
 #include <sstream>
 
@@ -39,64 +57,61 @@ static int last_y = -1;
 static Camera* camera = NULL;
 
 
-static Mesh* character = NULL;
-
-//animations
-static Animation* rest_animation = NULL;
-static Animation* run_animation = NULL;
-static Animation* walk_animation = NULL;
-
-static Animation* current_animation = NULL;//either walk or run
-
-/*
- *Compute joint transformations in advance to save CPU
- *b - global frame
- *lc - local frame
- *tpf - transforms per frame
- *we need  local only for rest pose
- */
-static std::vector<Matrix_4x4> rest_trans_lc;
-static std::vector<std::vector<Matrix_4x4> > rest_tpf_gb;
-static std::vector<std::vector<Matrix_4x4> > run_tpf_gb;
-static std::vector<std::vector<Matrix_4x4> > walk_tpf_gb;
-static std::vector<std::vector<Matrix_4x4> > current_tpf_gb;
-
-//matches between walk and run frames
-std::vector<std::pair<int, int> > matches;
-
-/* This timer can be used to cycle through the frames of animation */
-/*all of them calculated in the update function */
-static float timer = 0;
-static float timer_glut = 0;
-static float global_frame = 0.0f;
+//character, animations and transforms computed in advance, read only after loading
+static AnimationSet* anims = NULL;
+//playback (clip, time, speed, walk/run mix, selected frame) and frame scratch of the character
+static CharacterContext* character = NULL;
+//--crowd N: many instances of the character instead of the single one, playback keys don't apply to them
+static Crowd* crowd = NULL;
+//poses and skins the next frame while the current one is drawn, the simulation thread is its worker 0
+static JobSystem* jobs = NULL;
+//poses and skins the character or the crowd on a thread of its own, the callbacks below only send
+//it input and draw the latest frame it finished. --no-sim-thread steps it in the frame timer instead
+static Simulation* simulation = NULL;
+static bool simulation_thread = true;
+
+//frames are drawn at the deadlines of the pacer (--frame-rate N, --vsync) while something moves.
+//Once nothing does the viewer stops scheduling frames until the next input
+static FramePacer pacer;
+static bool tick_scheduled = false;
+//of the last frame taken from the simulation
+static bool animating = true;
+//frames to take after input before going idle: the one in flight, the one made with the input, one spare
+static const int WAKE_FRAMES = 3;
+static int wake_frames = WAKE_FRAMES;
 
 /*variables to control the workflow */
 /*display variables */
 static std::string hint="Default Mode";
 static bool show_skeleton = false;
 static bool show_mesh = true;
-static bool time_interpolation = true;
-static bool frame_mode = false;
-static bool mix_walk_run_anim = false;
+static bool lighting = true;
+//clusters of the character outside of the view or facing away are neither skinned nor drawn, off by default:
+//the bounds cost time every frame and cull nothing on a character with joints reaching everywhere
+static bool cluster_culling = false;
+//hints of playback changes come with the frames, this is the last one shown
+static int last_hint_serial = 0;
+
+#ifdef SKIN_TRACK_ALLOC
+//frames after warmup are expected not to allocate at all
+static const int ALLOC_WARMUP_FRAMES = 60;
+static int num_drawn_frames = 0;
+static AllocPhase frame_allocs;
+static AllocCounts steady_allocs;
+#endif
 
-/*user controlled parameters. Updated in key event function*/
-/*speed of animation*/
-static float frames_per_second = 30.0f;
-static float max_frames_per_second = 40.0f;
-static float min_frames_per_second = 1.0f;
+#ifdef SKIN_PROFILE
+//per frame stage times are written there on exit, .json for JSON, CSV otherwise
+static std::string frame_log_filename = "frame_times.csv";
+#endif
 
-//between 0 and max_frame of current animation
-static int selected_frame = 0;
-//interpolation parameter between 0  and 1
-static float walk_run_mix_rate = 0.5f;
+#ifdef SKIN_TRACE
+//Chrome trace_event timeline is written there on exit if not empty
+static std::string trace_filename = "";
+#endif
 
 //UTILS FOR FORMATTING/DISPLAYING   =================================================================
 
-/* to keep animation speed within certain limit */
-static float Clamp(float n, float lower, float upper) {
-	return std::max(lower, std::min(n, upper));
-}
-
 static std::string Int2String(int n) {
     std::ostringstream oss;
     oss << n;
@@ -119,6 +134,17 @@ void DrawTextHint() {
 	for (size_t i = 0; i < hint.length(); ++i) {
 		glutBitmapCharacter(GLUT_BITMAP_TIMES_ROMAN_24, hint[i]);
 	}
+#ifdef SKIN_PROFILE
+	//stage timings above the hint, frame total on top
+	std::vector<std::string> lines = GlobalFrameProfiler().SummaryLines();
+	glColor4f(0.0, 0.0, 0.0, 1.0);
+	for (size_t line = 0; line < lines.size(); line++) {
+		glRasterPos2i(10, 40 + 14 * line);
+		for (size_t i = 0; i < lines[line].length(); ++i) {
+			glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, lines[line][i]);
+		}
+	}
+#endif
 	glPopMatrix();
 	glMatrixMode( GL_PROJECTION);
 	glPopMatrix();
@@ -126,214 +152,57 @@ void DrawTextHint() {
 }
 
 
-//MESH WEIGHT LINEAR BLENDING PART  =====================================================================
-
-//Normalise weights components to one, otherwise strange artifacts
-static Vector3 NormSumToOne(Vector3 v) {
-	//assumes that all components of v are positive;
-	float sum = v.x + v.y + v.z;
-	return Vector3(v.x/sum, v.y/sum, v.z/sum);
-}
-
-//must be called after rest_trans_lc has been initialised
-static Vertex LinearBlending(Vertex& original, std::vector<Matrix_4x4>& anim_trans_gb) {
-	Vector3 pos = Vector3::Zero();
-	Vector3 norm = Vector3::Zero();
-	Vector3 weight_amounts = NormSumToOne(original.weight_amounts);
-	for (int j = 0; j < 3; j++) {
-		int joint_id = (int)round(original.weight_ids[j]);
-		float weight = weight_amounts[j];
-		Matrix_4x4 trans =  anim_trans_gb[joint_id] * rest_trans_lc[joint_id];
-		Matrix_3x3 rot = Matrix_4x4::ToMatrix_3x3(trans);
-		pos += (trans * original.position * weight);
-		norm += (rot * original.normal * weight);
-	}
-	return Vertex(pos, norm);
-}
-
-
-
-//UTILS FOR LINEAR INTERPOLATION  ======================================================================
-
-static Vector3 InterpolateSkels(Skeleton* skel_1, int id1, Skeleton* skel_2, int id2, float t) {
-	Vector3 v1 = skel_1->JointTransform(id1) * Vector3::Zero();
-	Vector3 v2 = skel_2->JointTransform(id2) * Vector3::Zero();
-	return v1 * (1-t) + v2 * t;
-}
-
-static Vertex InterpolateVertex(Vertex vrtx_1, Vertex vrtx_2, float t) {
-	Vertex vrtx;
-	vrtx.position = vrtx_1.position * (1-t) + vrtx_2.position * t;
-	vrtx.normal   = vrtx_1.normal   * (1-t) + vrtx_2.normal   * t;
-	return vrtx;
-}
-
-
-
-//UTILS TO STORE WALK AND RUN TRANSFORMS IN ADVANCE  ===================================================
-
-/*
- * Global transforms per frame for given animation.
- * Using vectors to alleviate problems with memory leaks.
- * Using this signature because it is c++98 and in that it won't be copying values twice as
- * c++98 doesn't have move constructor.
- */
-static void ComputeTransPerFrameGB(std::vector<std::vector<Matrix_4x4> >& trans_per_frame_gb, Animation* anim) {
-	trans_per_frame_gb.resize(anim->NumFrames());
-	for (int frame_id = 0; frame_id < anim->NumFrames(); frame_id++) {
-		Skeleton* skel = anim->GetFrame(frame_id);
-		trans_per_frame_gb[frame_id].resize(skel->NumJoints());
-		for (int joint_id = 0; joint_id < skel->NumJoints(); joint_id++) {
-			trans_per_frame_gb[frame_id][joint_id] = skel->JointTransform(joint_id);
-		}
-	}
-}
-
-/*
- * Compute local transforms (needed for Rest pose)
- */
-static void ComputeRestTransLC(std::vector<Matrix_4x4>& rest_trans_lc, Skeleton* rest_skel) {
-	rest_trans_lc.resize(rest_skel->NumJoints());
-	for (int joint_id = 0; joint_id < rest_skel->NumJoints(); joint_id++) {
-		rest_trans_lc[joint_id] = Matrix_4x4::Inverse(rest_skel->JointTransform(joint_id));
-	}
-}
-
-
-
-
-
-//WALK AND RUN BLENDING PART ===========================================================================
-//BASED ON:
-//Kovar, Lucas, and Michael Gleicher. "Flexible automatic motion blending with registration curves."
-//Proceedings of the 2003 ACM SIGGRAPH/Eurographics symposium on Computer animation. Eurographics Association, 2003.
-
-//compute distance between two character postures.
-//relies on the fact that two postures have the same root transform
-static float ComputeDistSkel(std::vector<Matrix_4x4>& trans_gb_1, std::vector<Matrix_4x4>& trans_gb_2) {
-	if (trans_gb_1.size() != trans_gb_2.size()) {
-		printf("The sizes of joints don't match");
-		return 1000000000000;
-	}
-
-	float distance = 0;
-	for (size_t joint_id = 0; joint_id < trans_gb_1.size(); joint_id++) {
-		Vector3 bone_pos1 = trans_gb_1[joint_id] * Vector3::Zero();
-		Vector3 bone_pos2 = trans_gb_2[joint_id] * Vector3::Zero();
-		distance += Vector3::Distance(bone_pos1, bone_pos2);
-	}
-	return distance;
+void Update() {
+    PROFILE_STAGE(STAGE_UPDATE);
+    //the simulation advances the time itself
+    if (!simulation->Running()) {
+        simulation->Step();
+    }
+    glutPostRedisplay();
 }
 
-//Create distance table between different frames of Walking/Running animation
-//dists: first index - walk frame, second index - run frame
-static void ComputeWalkRunDists(std::vector<std::vector<float> >& dists) {
-	int num_run  = run_animation->NumFrames();
-	int num_walk = walk_animation->NumFrames();
-
-
-	dists.resize(num_walk);
-
-	for (int walk_id = 0; walk_id < num_walk; walk_id++) {
-		dists[walk_id].resize(num_run);
-		for (int run_id = 0; run_id < num_run; run_id++) {
-			dists[walk_id][run_id] = ComputeDistSkel(run_tpf_gb[run_id], walk_tpf_gb[walk_id]);
-		}
-	}
+static void ScheduleTick();
+
+//one frame at its deadline. The timer sleeps in the GLUT loop until then, the last fraction
+//of a millisecond is slept here
+static void Tick(int value) {
+    tick_scheduled = false;
+    pacer.SleepUntilDue();
+    pacer.FrameStarted(TimeSeconds());
+    Update();
+    if (animating || wake_frames > 0) {
+        ScheduleTick();
+    }
 }
 
-//Compute raw best matches between frames of walking and running animations.
-//This raw matches must be pruned in order to find sequence which forms animation loop.
-//matches: in pairs first is walk frame, second is run frame
-//dists: table computed in ComputeWalkRunDists
-//anim_length: number of frames in initial raw sequence. Must be big enough in order to find animation loop within it
-static void ComputeWalkRunMatches(std::vector<std::pair<int, int> >& matches, std::vector<std::vector<float> >& dists, int anim_length) {
-	int num_run  = run_animation->NumFrames();
-	int num_walk = walk_animation->NumFrames();
-	//find best initial frames
-	int walk_id = 0;
-	int run_id  = 9;
-	float min_run_dist = 1000000000000;
-	//find the best match between first frame of walk and running animation
-	for (int j = 0; j < num_run; j++) {
-		float dist = dists[walk_id][j];
-		if (dist < min_run_dist) {
-			run_id = j;
-			min_run_dist = dist;
-		}
-	}
-
-	//calculate matches
-	//due to prev_step this algorithm is using
-	//Slope Limit = 2 (for clarification see paper mentioned above)
-	int prev_step = 0;// 1 - horiz, 2 - vert, 3 - diag
-	//saving initial point
-	matches.push_back(std::make_pair(walk_id, run_id));
-	for (int i = 1; i < anim_length; i++) {
-		float dist01 = dists[(walk_id) % num_walk][(run_id + 1) % num_run]; //horiz
-		float dist10 = dists[(walk_id + 1) % num_walk][(run_id) % num_run]; //vert
-		float dist11 = dists[(walk_id + 1) % num_walk][(run_id + 1) % num_run];// diag
-
-		//if dist 01 is smallest
-		if        (dist01 < dist10 && dist01 < dist11 && prev_step != 1) {
-			walk_id = (walk_id) % num_walk;
-			run_id  = (run_id + 1) % num_run;
-			prev_step = 1; //horiz
-
-		} else if (dist10 < dist01 && dist10 < dist11 && prev_step != 2) {
-			walk_id = (walk_id + 1) % num_walk;
-			run_id  = (run_id) % num_run;
-			prev_step = 2; //vert
-		} else {
-			//no choices left going diagonal
-			walk_id = (walk_id + 1) % num_walk;
-			run_id  = (run_id + 1) % num_run;
-			prev_step = 3;//diag
-		}
-		matches.push_back(std::make_pair(walk_id, run_id));
-	}
+static void ScheduleTick() {
+    if (tick_scheduled) return;
+    tick_scheduled = true;
+    glutTimerFunc((unsigned int)(pacer.Delay(TimeSeconds()) * 1000.0), Tick, 0);
 }
 
-//Prune raw_matches sequence found in ComputeWalkRunMatches in order to form animation loop (stored in matches).
-//If it doesn't find loop animation then return original raw_matches
-static void ComputeWalkRunLoop(std::vector<std::pair<int, int> >& raw_matches, std::vector<std::pair<int, int> >& matches) {
-	int run_frame = -1;
-	int prev_mix_frame = -1;
-	int T = -1; //period
-	for (int mix_frame=0; mix_frame < raw_matches.size(); mix_frame++) {
-		if (raw_matches[mix_frame].first != 0) {
-			continue;
-		}
-		if (run_frame == raw_matches[mix_frame].second) {
-			T = mix_frame - prev_mix_frame;
-			break;
-		} else {
-			run_frame = raw_matches[mix_frame].second;
-			prev_mix_frame = mix_frame;
-		}
-	}
-	if (T == -1) {
-		printf("\n Haven't found loop for mixed animation, just copy raw mixed animation. Try more frames of raw animation\n");
-		matches = raw_matches;
-	} else {
-		printf("\n Have found loop for mixed walk/run animation with period %d \n", T);
-		for (int mix_frame = prev_mix_frame; mix_frame < (prev_mix_frame + T); mix_frame++) {
-			matches.push_back(raw_matches[mix_frame]);
-		}
-	}
+//input changes what is shown, frames are made until it is even if nothing animates
+static void Wake() {
+    wake_frames = WAKE_FRAMES;
+    ScheduleTick();
 }
 
-//WALK AND RUN BLENDING PART END ========================================================================
-
-
-void Update() {
-    timer += 0.05;
-    //delta time since last update in seconds
-    float deltaTime = glutGet(GLUT_ELAPSED_TIME)/1000.f - timer_glut;
-    //time since start (glutGet(GLUT_ELAPSED_TIME) gives milliseconds, so divide by 1000)
-    timer_glut = glutGet(GLUT_ELAPSED_TIME)/1000.f;
-    global_frame += deltaTime * frames_per_second;
-    glutPostRedisplay();
+//asks the driver to sync buffer swaps to the display, false if there is no way to
+static bool EnableVsync() {
+#if defined(__linux__)
+    typedef int (*SwapIntervalProc)(int);
+    SwapIntervalProc swap_interval = (SwapIntervalProc)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalMESA");
+    if (swap_interval == NULL) {
+        swap_interval = (SwapIntervalProc)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalSGI");
+    }
+    return swap_interval != NULL && swap_interval(1) == 0;
+#elif defined(_WIN32)
+    typedef BOOL (WINAPI *SwapIntervalProc)(int);
+    SwapIntervalProc swap_interval = (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+    return swap_interval != NULL && swap_interval(1);
+#else
+    return false;
+#endif
 }
 
 static void DrawAxis(Matrix_4x4 origin) {
@@ -363,292 +232,169 @@ static void DrawAxis(Matrix_4x4 origin) {
     glLineWidth(1.0f);
 }
 
-static void DrawSkeleton(Skeleton* skeleton) {
+// SKELETON DRAWING FUNCTIONS =================================================================
 
+//bones the simulation made of the blended pose, axes of every joint when the pose isn't blended
+static void DrawSkeleton(const SimFrame& frame, const SimDrawItem& item) {
     glColor4f(0.0, 0.0, 0.0, 1.0);
     glLineWidth(2.0f);
 
-    glBegin(GL_LINES);
-
-    for (int i = 0; i < skeleton->NumJoints(); i++) {
-        int bone_id = i;
-        int parent_id = skeleton->GetJoint(bone_id).parent_id;
-
-        if (parent_id == -1) continue;
-
-        Vector3 bone_pos = skeleton->JointTransform(bone_id) * Vector3::Zero();
-        Vector3 parent_pos = skeleton->JointTransform(parent_id) * Vector3::Zero();
-
-        glVertex3f(bone_pos.x, bone_pos.y, bone_pos.z);
-        glVertex3f(parent_pos.x, parent_pos.y, parent_pos.z);
+    if (item.num_lines > 0) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, &frame.lines[item.first_line * 3]);
+        glDrawArrays(GL_LINES, 0, item.num_lines);
+        glDisableClientState(GL_VERTEX_ARRAY);
     }
 
-    glEnd();
-
     glLineWidth(1.0f);
     glColor4f(1.0, 1.0, 1.0, 1.0);
 
-    for(int i = 0; i < skeleton->NumJoints(); i++) {
-        DrawAxis(skeleton->JointTransform(i));
+    for (int i = 0; i < item.num_axes; i++) {
+        DrawAxis(frame.axes[item.first_axis + i]);
     }
 }
 
-// SKELETON DRAWING FUNCTIONS =================================================================
 
-// t - interpolation parameter between 0 and 1
-static void DrawSkeletonInterpolated(Skeleton* skel_1, Skeleton* skel_2, float t) {
-	if (skel_1->NumJoints() != skel_2->NumJoints()) {
-		printf("Number of joints in the skeletons doesn't match!");
-		return;
-	}
-    glColor4f(0.0, 0.0, 0.0, 1.0);
-    glLineWidth(2.0f);
-
-    glBegin(GL_LINES);
-
-    for (int i = 0; i < skel_1->NumJoints(); i++) {
-        int parent_id1 = skel_1->GetJoint(i).parent_id;
-        if (parent_id1 == -1) continue;
+//MODEL RENDERING PART =========================================================================
 
-        int parent_id2 = skel_2->GetJoint(i).parent_id;
-        if (parent_id2 == -1) continue;
+//lines of statistics in the top left corner, without touching the heap
+static void DrawStatsLines(const char (*lines)[128], int num_lines) {
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, WIDTH, 0, HEIGHT);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glColor4f(0.0, 0.0, 0.4, 1.0);
+	for (int line = 0; line < num_lines; line++) {
+		glRasterPos2i(10, HEIGHT - 20 - 14 * line);
+		for (const char* c = lines[line]; *c != '\0'; c++) {
+			glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+		}
+	}
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+}
 
-        //interpolation
-        Vector3 bone_pos   = InterpolateSkels(skel_1, i, skel_2, i, t);
-        Vector3 parent_pos = InterpolateSkels(skel_1, parent_id1, skel_2, parent_id2, t);
-        glVertex3f(bone_pos.x, bone_pos.y, bone_pos.z);
-        glVertex3f(parent_pos.x, parent_pos.y, parent_pos.z);
-    }
+static const int MAX_STATS_LINES = 10;
 
-    glEnd();
+//instances and skinned vertices per level of detail, returns the number of lines
+static int CrowdStatsLines(const SimFrame& frame, char (*lines)[128], int max_lines) {
+	int num_lines = std::min((int)frame.lod_stats.size(), max_lines);
+	for (int level = 0; level < num_lines; level++) {
+		const CrowdLodStats& stats = frame.lod_stats[level];
+		sprintf(lines[level], "LOD%d: %d instances, %d updated, %d skinned, %d interpolated vertices",
+		        level, stats.instances, stats.updated, stats.skinned_vertices, stats.interpolated_vertices);
+	}
+	return num_lines;
+}
 
-    glLineWidth(1.0f);
-    glColor4f(1.0, 1.0, 1.0, 1.0);
+static void ClusterStatsLine(const SimFrame& frame, char* line) {
+	const MeshClusters& clusters = anims->Clusters();
+	const ClusterCullStats& stats = frame.cluster_stats;
+	sprintf(line, "Clusters: %d of %d drawn (%d outside, %d facing away), %d of %d vertices skinned",
+	        stats.visible, clusters.NumClusters(), stats.outside, stats.back_facing,
+	        stats.skinned_vertices, clusters.ClusteredMesh()->NumVertices());
 }
 
-//first index animation type, second index frame, rates are interpolation parameters between 0 and 1
-static void DrawSkeletonInterpolated(Skeleton* anim_1_1,
-									 Skeleton* anim_1_2,
-									 Skeleton* anim_2_1,
-									 Skeleton* anim_2_2,
-									 float time_rate,
-									 float mix_rate) {
-
-	if (anim_1_1->NumJoints() != anim_2_1->NumJoints()) {
-		printf("Animations skeletons from first frames don't match!");
-		return;
+//how busy every job worker was while the frame ran jobs
+static void WorkerStatsLine(const SimFrame& frame, char* line) {
+	int length = sprintf(line, "Workers:");
+	for (size_t i = 0; i < frame.worker_utilization.size() && length < 100; i++) {
+		length += sprintf(line + length, " %d%%", (int)(frame.worker_utilization[i] * 100.0f + 0.5f));
 	}
-	if (anim_1_2->NumJoints() != anim_2_2->NumJoints()) {
-		printf("Animations skeletons from second frames don't match!");
-		return;
-	}
-	if (anim_1_2->NumJoints() != anim_1_1->NumJoints()) {
-		printf("Animations skeletons between different frames don't match!");
-		return;
-	}
-    glColor4f(0.0, 0.0, 0.0, 1.0);
-    glLineWidth(2.0f);
-
-    glBegin(GL_LINES);
-
-    for (int i = 0; i < anim_1_1->NumJoints(); i++) {
-    	//Interpolation between animation types
-    	//first frame
-        int parent_id_1x1 = anim_1_1->GetJoint(i).parent_id;
-        if (parent_id_1x1 == -1) continue;
-
-        int parent_id_2x1 = anim_2_1->GetJoint(i).parent_id;
-        if (parent_id_2x1 == -1) continue;
-
-        Vector3 bone_pos1   = InterpolateSkels(anim_1_1, i, anim_2_1, i, mix_rate);
-        Vector3 parent_pos1 = InterpolateSkels(anim_1_1, parent_id_1x1, anim_2_1, parent_id_2x1, mix_rate);
-
-        //second frame
-        int parent_id_1x2 = anim_1_2->GetJoint(i).parent_id;
-        if (parent_id_1x2 == -1) continue;
-
-        int parent_id_2x2 = anim_2_2->GetJoint(i).parent_id;
-        if (parent_id_2x2 == -1) continue;
-
-        Vector3 bone_pos2   = InterpolateSkels(anim_1_2, i, anim_2_2, i, mix_rate);
-        Vector3 parent_pos2 = InterpolateSkels(anim_1_2, parent_id_1x2, anim_2_2, parent_id_2x2, mix_rate);
-
-        //interpolation between frames
-        Vector3 bone_pos =   bone_pos1   * (1-time_rate) + bone_pos2   * time_rate;
-        Vector3 parent_pos = parent_pos1 * (1-time_rate) + parent_pos2 * time_rate;
-
-        //render
-        glVertex3f(bone_pos.x, bone_pos.y, bone_pos.z);
-        glVertex3f(parent_pos.x, parent_pos.y, parent_pos.z);
-    }
-
-    glEnd();
-
-    glLineWidth(1.0f);
-    glColor4f(1.0, 1.0, 1.0, 1.0);
+	sprintf(line + length, ", %d stolen", frame.steals);
 }
 
+//every character of the frame at its place: the skeleton, and the skinned vertices with the triangle
+//ranges which were kept. Nothing is evaluated here, the simulation made all of it
+static void DrawFrame(const SimFrame& frame) {
+	PROFILE_STAGE(STAGE_SUBMIT);
 
-//MODEL RENDERING PART =========================================================================
-
-static void DrawModel() {
-    float* world_positions_array = new float[character->NumVertices() * 3];
-    float* world_normals_array = new float[character->NumVertices() * 3];
-    int* triangle_array = new int[character->NumTriangles() * 3];
-
-    /*
-    ** TODO: Uncomment this once `JointTransform` is implemented to draw
-    **       the skeleton of the character in the rest pose.
-    */
-
-    //TIMING PART =========================================================================
-
-    //frame interpolation parameter between 0 and 1
-	float frame_mix_rate = global_frame - int(global_frame);
-	frame_mix_rate = Clamp(frame_mix_rate, 0, 1);
-
-    int curr_anim_frame, next_anim_frame;
-	if (frame_mode) {
-		//just displaying required frame
-		curr_anim_frame = selected_frame;
-		next_anim_frame = selected_frame;
-		frame_mix_rate = 0;
-	} else {
-		curr_anim_frame = int(global_frame);
-		next_anim_frame = curr_anim_frame + 1;
-	}
+	for (size_t i = 0; i < frame.items.size(); i++) {
+		const SimDrawItem& item = frame.items[i];
 
-	//normalise
-	int num_frames = (mix_walk_run_anim) ? matches.size() : current_animation->NumFrames();
-    curr_anim_frame = curr_anim_frame % num_frames;
-    next_anim_frame = next_anim_frame % num_frames;
-
-    //SKELETON VISUALIZATION PART ==========================================================
-    //definitely can be refactored but during experimentation refactoring does more harm than good
-    if (show_skeleton) {
-    	if (mix_walk_run_anim) {
-    		int walk_frame = matches[curr_anim_frame].first;
-    		int run_frame  = matches[curr_anim_frame].second;
-
-    		int next_walk_frame = matches[next_anim_frame].first;
-    		int next_run_frame  = matches[next_anim_frame].second;
-
-    		if (time_interpolation) {
-    			DrawSkeletonInterpolated(walk_animation->GetFrame(walk_frame),
-    									 walk_animation->GetFrame(next_walk_frame),
-										 run_animation->GetFrame(run_frame),
-										 run_animation->GetFrame(next_run_frame),
-										 frame_mix_rate,
-										 walk_run_mix_rate);
-    		} else {
-        		DrawSkeletonInterpolated(walk_animation->GetFrame(walk_frame),
-        								 run_animation->GetFrame(run_frame),
-										 walk_run_mix_rate);
-    		}
-
-    	} else {
-    		if (time_interpolation) {
-				DrawSkeletonInterpolated(current_animation->GetFrame(curr_anim_frame),
-										 current_animation->GetFrame(next_anim_frame),
-										 frame_mix_rate);
+		glPushMatrix();
+		glTranslatef(item.position.x, item.position.y, item.position.z);
+		glRotatef(item.heading, 0, 1, 0);
+		if (frame.show & SIM_SHOW_SKELETON) {
+			DrawSkeleton(frame, item);
+		}
+		if (item.mesh != NULL) {
+			glEnable(GL_DEPTH_TEST);
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glVertexPointer(3, GL_FLOAT, 0, &frame.positions[item.first_vertex * 3]);
+			if (item.has_normals) {
+				glEnable(GL_LIGHTING);
+				glEnableClientState(GL_NORMAL_ARRAY);
+				glNormalPointer(GL_FLOAT, 0, &frame.normals[item.first_vertex * 3]);
 			} else {
-				DrawSkeleton(current_animation->GetFrame(curr_anim_frame));
+				//unlit silhouette
+				glColor4f(0.2, 0.2, 0.2, 1.0);
 			}
-    	}
-    }
-
-    //MESH VISUALIZATION PART ==============================================================
-
-    if (show_mesh) {
-
-		for (int i = 0; i < character->NumVertices(); i++) {
-			/*
-			** TODO: Transform position and normal using rest pose and some
-			**       other animated pose from one of the animations
-			*/
-			Vertex vrtx_original = character->GetVertex(i);
-			Vertex vrtx;
-
-			if (mix_walk_run_anim) {
-	    		int walk_frame = matches[curr_anim_frame].first;
-	    		int run_frame  = matches[curr_anim_frame].second;
 
-	    		int next_walk_frame = matches[next_anim_frame].first;
-	    		int next_run_frame  = matches[next_anim_frame].second;
-
-				if (time_interpolation) {
-					//first frame
-					Vertex vrtx_walk_1 = LinearBlending(vrtx_original, walk_tpf_gb[walk_frame]);
-					Vertex vrtx_run_1  = LinearBlending(vrtx_original,  run_tpf_gb[run_frame]);
-					Vertex vrtx_1 = InterpolateVertex(vrtx_walk_1, vrtx_run_1, walk_run_mix_rate);
-
-					//second frame
-					Vertex vrtx_walk_2 = LinearBlending(vrtx_original, walk_tpf_gb[next_walk_frame]);
-					Vertex vrtx_run_2  = LinearBlending(vrtx_original,  run_tpf_gb[next_run_frame]);
-					Vertex vrtx_2 = InterpolateVertex(vrtx_walk_2, vrtx_run_2, walk_run_mix_rate);
-
-					//interpolate frames
-					vrtx = InterpolateVertex(vrtx_1, vrtx_2, frame_mix_rate);
-				} else {
-					Vertex vrtx_walk = LinearBlending(vrtx_original, walk_tpf_gb[walk_frame]);
-					Vertex vrtx_run  = LinearBlending(vrtx_original,  run_tpf_gb[run_frame]);
-					vrtx = InterpolateVertex(vrtx_walk, vrtx_run, walk_run_mix_rate);
-				}
-
-			} else {
-				if (time_interpolation) {
-					Vertex vrtx_1 = LinearBlending(vrtx_original, current_tpf_gb[curr_anim_frame]);
-					Vertex vrtx_2 = LinearBlending(vrtx_original, current_tpf_gb[next_anim_frame]);
-					vrtx = InterpolateVertex(vrtx_1, vrtx_2, frame_mix_rate);
-				} else {
-					vrtx = LinearBlending(vrtx_original, current_tpf_gb[curr_anim_frame]);
-				}
+			//one call per range, a run of kept clusters or the whole mesh
+			const int* triangles = item.mesh->m_triangles;
+			for (int r = item.first_range; r < item.first_range + item.num_ranges; r++) {
+				const ClusterRun& range = frame.ranges[r];
+				glDrawElements(GL_TRIANGLES, range.num_triangles * 3, GL_UNSIGNED_INT,
+				               triangles + range.first_triangle * 3);
 			}
 
-			world_positions_array[(i*3)+0] = vrtx.position.x;
-			world_positions_array[(i*3)+1] = vrtx.position.y;
-			world_positions_array[(i*3)+2] = vrtx.position.z;
-
-			world_normals_array[(i*3)+0] = vrtx.normal.x;
-			world_normals_array[(i*3)+1] = vrtx.normal.y;
-			world_normals_array[(i*3)+2] = vrtx.normal.z;
-		}
-
-		for (int i = 0; i < character->NumTriangles() * 3; i++) {
-			triangle_array[i] = character->GetIndex(i);
+			glDisableClientState(GL_VERTEX_ARRAY);
+			glDisableClientState(GL_NORMAL_ARRAY);
+			glDisable(GL_DEPTH_TEST);
+			glDisable(GL_LIGHTING);
 		}
+		glPopMatrix();
+	}
 
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_LIGHTING);
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_NORMAL_ARRAY);
-
-		glVertexPointer(3, GL_FLOAT, 0, world_positions_array);
-		glNormalPointer(   GL_FLOAT, 0, world_normals_array);
-
-		glDrawElements(GL_TRIANGLES, character->NumTriangles() * 3, GL_UNSIGNED_INT, triangle_array);
-
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_NORMAL_ARRAY);
-
-		glDisable(GL_DEPTH_TEST);
-		glDisable(GL_LIGHTING);
-    }
-
-
-    delete[] world_positions_array;
-    delete[] world_normals_array;
-    delete[] triangle_array;
+	char lines[MAX_STATS_LINES][128];
+	int num_lines = 0;
+	if (!frame.lod_stats.empty()) {
+		num_lines = CrowdStatsLines(frame, lines, MAX_STATS_LINES - 1);
+	} else if (frame.clusters_culled) {
+		ClusterStatsLine(frame, lines[num_lines++]);
+	}
+	WorkerStatsLine(frame, lines[num_lines++]);
+	DrawStatsLines(lines, num_lines);
 }
 
 void Draw() {
+    TRACE_SCOPE("frame");
+#ifdef SKIN_TRACK_ALLOC
+    frame_allocs.Start();
+#endif
+
+    //latest finished frame, the previous one is drawn again if there is no new one yet
+    if (simulation->AcquireFrame()) {
+    	const SimFrame& frame = simulation->Frame();
+#ifdef SKIN_PROFILE
+    	for (int stage = 0; stage < NUM_FRAME_STAGES; stage++) {
+    		if (frame.stage_seconds[stage] > 0.0) {
+    			GlobalFrameProfiler().AddStageTime(stage, frame.stage_seconds[stage]);
+    		}
+    	}
+#endif
+    	if (frame.hint_serial != last_hint_serial) {
+    		hint = frame.hint;
+    		last_hint_serial = frame.hint_serial;
+    	}
+    	animating = frame.animating;
+    	if (wake_frames > 0) {
+    		wake_frames--;
+    	}
+    }
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(40.0, (float)WIDTH / (float)HEIGHT, 1.0, 1000.0);
+    gluPerspective(camera->GetFOV() * 180.0 / M_PI, (float)WIDTH / (float)HEIGHT,
+                   camera->GetNearClipPlane(), camera->GetFarClipPlane());
 
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
@@ -656,10 +402,27 @@ void Draw() {
               camera->GetTarget().x, camera->GetTarget().y, camera->GetTarget().z,
               0.0, 1.0, 0.0);
 
-    DrawModel();
+    if (simulation->Frame().serial > 0) {
+    	DrawFrame(simulation->Frame());
+    }
 	DrawTextHint();
 
-    glutSwapBuffers();
+	{
+		PROFILE_STAGE(STAGE_SWAP);
+		glutSwapBuffers();
+	}
+	PROFILE_END_FRAME();
+
+#ifdef SKIN_TRACK_ALLOC
+	frame_allocs.Stop();
+	if (++num_drawn_frames > ALLOC_WARMUP_FRAMES) {
+		AllocCounts last = frame_allocs.Last();
+		if (last.allocations > 0 && steady_allocs.allocations == 0) {
+			printf("Frame %d allocated %llu times after warmup\n", num_drawn_frames, last.allocations);
+		}
+		steady_allocs = steady_allocs + last;
+	}
+#endif
 }
 
 void MouseEvent(int button, int state, int x, int y) {
@@ -694,6 +457,8 @@ void MouseEvent(int button, int state, int x, int y) {
         camera->SetPosition( camera->GetPosition() - camera->GetDirection() );
         break;
     }
+    simulation->SetView(*camera);
+    Wake();
 
 }
 
@@ -719,29 +484,37 @@ void MouseMoveEvent(int x, int y) {
         last_x = x;
         last_y = y;
 
+        simulation->SetView(*camera);
+        Wake();
     }
 
 }
 
 //USER INTERACTIONS PART ========================================================================
 
-void ChangeFrames(int value) {
-	int num_frames = (mix_walk_run_anim) ? matches.size() : current_animation->NumFrames();
-	if (frame_mode) {
-		selected_frame += value;
-	    int max_frames = num_frames - 1;
-	    selected_frame = Clamp(selected_frame, 0, max_frames);
-		hint = "Current Frame: " + Int2String(selected_frame);
-	} else {
-		frames_per_second += value;
-	    frames_per_second = Clamp(frames_per_second, min_frames_per_second, max_frames_per_second);
-		hint = "Animation Speed (Frames per Second): " + Int2String(((int)frames_per_second));
+//to the simulation, which shows the result in the hint of a later frame. Nothing waits for it
+static void SendCommand(int type, int value = 0, float amount = 0.0f) {
+	if (!simulation->Push(SimCommand(type, value, amount))) {
+		hint = "Simulation is busy, input dropped";
 	}
 }
 
+//what frames should be made of
+static void SendDisplay() {
+	int show = 0;
+	if (show_mesh) show |= SIM_SHOW_MESH;
+	if (show_skeleton) show |= SIM_SHOW_SKELETON;
+	//normals are only consumed by the lighting
+	if (lighting) show |= SIM_SHOW_NORMALS;
+	if (cluster_culling) show |= SIM_CULL_CLUSTERS;
+	SendCommand(SIM_DISPLAY, show);
+}
+
 void KeyEvent(unsigned char key, int x, int y) {
     switch (key) {
 		case GLUT_KEY_ESCAPE:
+			//nothing may run on the other thread when exit handlers write logs
+			simulation->Stop();
 			exit(EXIT_SUCCESS);
 			break;
 		//enable skeleton view
@@ -751,6 +524,7 @@ void KeyEvent(unsigned char key, int x, int y) {
 	    	show_mesh = false;
 	    	show_skeleton = true;
 	    	hint = "Show Skeleton: ON";
+	    	SendDisplay();
 	    	break;
 	    //enable mesh view
 	    case 'm':
@@ -759,303 +533,222 @@ void KeyEvent(unsigned char key, int x, int y) {
 	    	show_mesh = true;
 	    	show_skeleton = false;
 	    	hint = "Show Mesh: ON";
+	    	SendDisplay();
 	    	break;
 	    //controlling animation speed or current frame
 	    case 'j':
 	    case 'J':
-	    	ChangeFrames(-1);
+	    	SendCommand(SIM_CHANGE_FRAMES, -1);
 	    	break;
 	    case 'k':
 	    case 'K':
-	    	ChangeFrames(+1);
+	    	SendCommand(SIM_CHANGE_FRAMES, +1);
 	    	break;
 	    //run walking animation
 	    case 'w':
 	    case 'W':
-	    	current_animation = walk_animation;
-	    	current_tpf_gb = walk_tpf_gb;
-	    	mix_walk_run_anim = false;
-	    	hint = "Current Animation: Walk";
+	    	SendCommand(SIM_CLIP, CLIP_WALK);
 	    	break;
 	    //run running animation
 	    case 'r':
 	    case 'R':
-	    	current_animation = run_animation;
-	    	current_tpf_gb = run_tpf_gb;
-	    	mix_walk_run_anim = false;
-	    	hint = "Current Animation: Run";
+	    	SendCommand(SIM_CLIP, CLIP_RUN);
 	    	break;
 	    //run mixture of walking and running animation
 	    case 'b':
 	    case 'B':
 	    	//b - blend/mix walk and run animation
-	    	mix_walk_run_anim = true;
-	    	hint = "Current Animation: Walk/Run Mixture";
+	    	SendCommand(SIM_CLIP, CLIP_MIX);
 	    	break;
 	    //enable Animation Keyframe Interpolation
 	    case 'i':
 	    case 'I':
-	    	time_interpolation = !time_interpolation;
-	    	hint = (time_interpolation) ? "Time Interpolation: ON" : "Time Interpolation: OFF";
+	    	SendCommand(SIM_TOGGLE_INTERPOLATION);
+	    	break;
+	    //blend local translations/quaternions instead of global transforms
+	    case 'p':
+	    case 'P':
+	    	SendCommand(SIM_TOGGLE_LOCAL_BLEND);
 	    	break;
 	    //enable frame mode, current frame is controlled by j and k
 	    case 'f':
 	    case 'F':
-	    	frame_mode = !frame_mode;
-	    	hint = (frame_mode) ? "Frame Mode: ON" : "Frame Mode: OFF";
+	    	SendCommand(SIM_TOGGLE_FRAME_MODE);
+	    	break;
+	    //cull clusters of the character before skinning
+	    case 'c':
+	    case 'C':
+	    	cluster_culling = !cluster_culling;
+	    	hint = (cluster_culling) ? "Cluster Culling: ON" : "Cluster Culling: OFF";
+	    	SendDisplay();
+	    	break;
+	    //enable lighting, without it normals are not skinned at all
+	    case 'l':
+	    case 'L':
+	    	lighting = !lighting;
+	    	hint = (lighting) ? "Lighting: ON" : "Lighting: OFF";
+	    	SendDisplay();
 	    	break;
 	    //Control the mix ratio between walking and running animation, z - reduce, x - increase
 	    case 'z':
 	    case 'Z':
 	    case 'x':
 	    case 'X':
-	    	walk_run_mix_rate += ((key == 'z' || key == 'Z') ? -0.02f : 0.02f);
-	    	walk_run_mix_rate = Clamp(walk_run_mix_rate, 0, 1);
-	    	hint = "Walk/Run Mix Ratio (0 - Walk, 100 - Run): " + Int2String((int)(walk_run_mix_rate * 100));
+	    	SendCommand(SIM_CHANGE_MIX, 0, (key == 'z' || key == 'Z') ? -0.02f : 0.02f);
 	    	break;
     }
+    Wake();
 
 }
 
 //USER INTERACTIONS PART END =========================================================================
 
-enum {
-    SMD_STATE_EMPTY = 0,
-    SMD_STATE_MESH  = 1,
-    SMD_STATE_NODES = 2,
-    SMD_STATE_SKEL  = 3
-};
-
-void LoadSMDAnimation(std::string filename, Animation** animation) {
-
-    int state = SMD_STATE_EMPTY;
-
-    Skeleton* base = new Skeleton();
-    Animation* anim = new Animation();
-
-    std::vector<Joint> joints = std::vector<Joint>();
-
-    std::ifstream f(filename.c_str());
-
-    if (f == NULL) {
-        printf("Failed to read file %s\n", filename.c_str());
-        fflush(stdout);
-        exit(EXIT_FAILURE);
-    }
-
-    char line[1024];
-
-    while (!f.eof()) {
-
-        f.getline(line, sizeof(line));
-
-        if (strstr(line, "end"))   {
-            state = SMD_STATE_EMPTY;
-            continue;
-        }
-        if (strstr(line, "nodes")) {
-            state = SMD_STATE_NODES;
-            continue;
-        }
-
-        if (strstr(line, "skeleton")) {
-            state = SMD_STATE_SKEL;
-            base->m_num_joints = joints.size();
-            base->m_joints = new Joint[base->m_num_joints];
-
-            for (int i = 0; i < base->m_num_joints; i++) {
-                base->m_joints[i] = joints[i];
-            }
+#ifdef SKIN_PROFILE
+//glutMainLoop never returns, so the log is written by exit
+static void WriteFrameLog() {
+	if (GlobalFrameProfiler().WriteLog(frame_log_filename)) {
+		printf("Frame times written to %s\n", frame_log_filename.c_str());
+	} else {
+		printf("Failed to write frame times to %s\n", frame_log_filename.c_str());
+	}
+}
+#endif
 
-            continue;
-        }
+#ifdef SKIN_TRACE
+static void WriteTrace() {
+	if (TraceWrite(trace_filename)) {
+		printf("Trace written to %s\n", trace_filename.c_str());
+	} else {
+		printf("Failed to write trace to %s\n", trace_filename.c_str());
+	}
+}
+#endif
 
-        if (strstr(line, "time")) {
-            anim->AddFrame(base);
-        }
+#ifdef SKIN_TRACK_ALLOC
+static void PrintSteadyAllocs() {
+	int steady_frames = num_drawn_frames - ALLOC_WARMUP_FRAMES;
+	if (steady_frames > 0) {
+		printf("Steady state heap allocations: %.2f per frame, %.1f bytes per frame over %d frames\n",
+		       (double)steady_allocs.allocations / steady_frames, (double)steady_allocs.bytes / steady_frames, steady_frames);
+	}
+}
+#endif
 
-        if (state == SMD_STATE_NODES) {
-            char name[256];
-            int id, parent;
-            if (sscanf(line, "%i \"%[^\"]\" %i", &id, name, &parent) == 3) {
-                joints.push_back(Joint(id, parent));
-            }
-        }
+int main(int argc, char **argv) {
 
-        if (state == SMD_STATE_SKEL) {
-            int id;
-            float x, y, z, rx, ry, rz;
-            if (sscanf(line, "%i %f %f %f %f %f %f", &id, &x, &y, &z, &rx, &ry, &rz) == 7) {
+#ifdef SKIN_PROFILE
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--frame-log") == 0) {
+			frame_log_filename = argv[i + 1];
+		}
+	}
+	atexit(WriteFrameLog);
+#endif
 
-                Skeleton* frame = anim->GetFrame(anim->NumFrames()-1);
+#ifdef SKIN_TRACK_ALLOC
+	atexit(PrintSteadyAllocs);
+#endif
 
-                /* Swap y and z */
-                frame->m_joints[id].position = Vector3(x, z, y);
+#ifdef SKIN_TRACE
+	//start before loading, so startup phases are on the timeline as well
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--trace") == 0) {
+			trace_filename = argv[i + 1];
+			TRACE_THREAD_NAME("main");
+			TraceStart();
+			atexit(WriteTrace);
+		}
+	}
+#endif
 
-                Matrix_4x4 rotation = Matrix_4x4::RotationEuler(rx, ry, rz);
-                Matrix_4x4 handedflip = Matrix_4x4(1,0,0,0,  0,0,1,0,  0,1,0,0,  0,0,0,1);
 
-                rotation = handedflip * rotation;
-                rotation = rotation * handedflip;
+    camera = new Camera(Vector3(20, 30, 50), Vector3(0, 15, 0));
 
-                frame->m_joints[id].rotation = Matrix_4x4::Transpose(rotation);
-            }
+    anims = new AnimationSet();
+    anims->Load("./resources", true);
+    character = new CharacterContext(anims);
+
+    //job workers are pinned per node and crowd instances sharded over the nodes with workers,
+    //one node on most machines shards nothing
+    static NumaTopology numa;
+    numa.Detect();
+
+    //one core is left to GL submission and swaps. Threads and chunk size for this machine and mesh
+    //are measured on the first start and read from the cache afterwards
+    int num_threads = std::max(1, WorkerPool::HardwareThreads() - 1);
+    int chunk_size = 2048;
+    bool autotune = true;
+    bool retune = false;
+    Autotuner tuner(anims, num_threads);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-autotune") == 0) {
+            autotune = false;
+        } else if (strcmp(argv[i], "--retune") == 0) {
+            retune = true;
+        } else if (strcmp(argv[i], "--tune-cache") == 0 && i + 1 < argc) {
+            tuner.SetCacheFile(argv[i + 1]);
         }
-
     }
-
-    delete base;
-
-    (*animation) = anim;
-
-}
-
-void LoadSMDCharacter(std::string filename, Mesh** character) {
-
-    int state = SMD_STATE_EMPTY;
-
-    std::vector<Vertex> verts = std::vector<Vertex>();
-    std::vector<int> tris = std::vector<int>();
-
-    std::ifstream f(filename.c_str());
-
-    if (f == NULL) {
-        printf("Failed to read file %s\n", filename.c_str());
-        fflush(stdout);
-        exit(EXIT_FAILURE);
+    if (autotune) {
+        TuneConfig tuned = tuner.Tune(retune);
+        printf("Autotune: %d threads, %d vertex chunks (%s %s)\n", tuned.num_threads, tuned.chunk_size,
+               (tuned.cached) ? "cached in" : "measured, cache", tuner.CacheFile().c_str());
+        num_threads = tuned.num_threads;
+        chunk_size = tuned.chunk_size;
     }
-
-    char line[1024];
-
-    while (!f.eof()) {
-
-        f.getline(line, sizeof(line));
-
-        if (strstr(line, "end")) {
-            state = SMD_STATE_EMPTY;
-            continue;
+    jobs = new JobSystem(num_threads, &numa);
+
+    CrowdConfig crowd_config;
+    crowd_config.numa = &numa;
+    crowd_config.jobs = jobs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--replicate-assets") == 0) {
+            crowd_config.replicate_assets = true;
         }
-        if (strstr(line, "triangles")) {
-            state = SMD_STATE_MESH;
-            continue;
+    }
+    bool crowd_mode = false;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--crowd") == 0) {
+            crowd_mode = true;
+            crowd_config.num_instances = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--crowd-file") == 0) {
+            crowd_mode = true;
+            crowd_config.placement_file = argv[i + 1];
         }
-
-        if (state == SMD_STATE_MESH) {
-
-            int id = 0, l1_id = 0, l2_id = 0, l3_id = 0;
-            int num_links = 0;
-            float x, y, z, nx, ny, nz, u, v, l1_amount = 0, l2_amount = 0, l3_amount = 0;
-
-            if (sscanf(line, "%i %f %f %f %f %f %f %f %f %i %i %f %i %f %i %f",
-                       &id, &x, &y, &z, &nx, &ny, &nz, &u, &v, &num_links,
-                       &l1_id, &l1_amount, &l2_id, &l2_amount, &l3_id, &l3_amount) > 10) {
-
-                /* Swap y and z axis */
-                Vertex vert;
-                vert.position = Vector3(x, z, y);
-                vert.normal = Vector3(nx, nz, ny);
-                vert.weight_ids = Vector3(l1_id, l2_id, l3_id);
-                vert.weight_amounts = Vector3(l1_amount, l2_amount, l3_amount);
-
-                verts.push_back(vert);
-                tris.push_back(verts.size()-1);
-            }
+    }
+    if (crowd_mode) {
+        crowd = new Crowd(anims);
+        if (!crowd->Create(crowd_config)) {
+            exit(EXIT_FAILURE);
         }
-
+        hint = "Crowd: " + Int2String(crowd->NumInstances()) + " instances";
+        //step back to see the whole grid
+        float extent = crowd_config.spacing * sqrt((float)crowd->NumInstances());
+        delete camera;
+        camera = new Camera(Vector3(20, 30 + extent * 0.5f, 50 + extent), Vector3(0, 15, 0));
     }
-
-    f.close();
-
-    Mesh* mesh = new Mesh();
-    mesh->m_num_vertices = verts.size();
-    mesh->m_num_triangles = tris.size() / 3;
-    mesh->m_vertices = new Vertex[mesh->m_num_vertices];
-    mesh->m_triangles = new int[mesh->m_num_triangles * 3];
-
-    for(int i = 0; i < mesh->m_num_vertices; i++) {
-        mesh->m_vertices[i] = verts[i];
+    //the projection and the culling frustum both come from the camera
+    camera->SetFOV(40.0f * M_PI / 180.0f);
+    camera->SetNearClipPlane(1.0f);
+    camera->SetFarClipPlane(1000.0f);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-sim-thread") == 0) {
+            simulation_thread = false;
+        } else if (strcmp(argv[i], "--frame-rate") == 0 && i + 1 < argc) {
+            //0 - as fast as frames come
+            pacer.SetTargetRate(atof(argv[i + 1]));
+        } else if (strcmp(argv[i], "--vsync") == 0) {
+            pacer.SetVsync(true);
+        }
     }
-
-    for(int i = 0; i < mesh->m_num_triangles; i++) {
-        mesh->m_triangles[i*3+0] = tris[i*3+2];
-        mesh->m_triangles[i*3+1] = tris[i*3+1];
-        mesh->m_triangles[i*3+2] = tris[i*3+0];
+    simulation = new Simulation(anims, character, crowd, jobs, *camera, (float)WIDTH / (float)HEIGHT);
+    simulation->SetChunkSize(chunk_size);
+    SendDisplay();
+    if (simulation_thread) {
+        simulation->Start();
     }
 
-    (*character) = mesh;
-
-}
-
-int main(int argc, char **argv) {
-
-
-    camera = new Camera(Vector3(20, 30, 50), Vector3(0, 15, 0));
-
-    LoadSMDCharacter("./resources/character.smd", &character);
-    LoadSMDAnimation("./resources/rest_animation.smd", &rest_animation);
-    LoadSMDAnimation("./resources/run_animation.smd",  &run_animation);
-    LoadSMDAnimation("./resources/walk_animation.smd",  &walk_animation);
-
-    printf("rest_animation -> number of frames: %d \n", rest_animation->NumFrames());
-    printf("run_animation -> number of frames: %d \n", run_animation->NumFrames());
-    printf("walk_animation -> number of frames: %d \n", walk_animation->NumFrames());
-
-    //compute initial transforms in advance to save CPU =============================
-    ComputeRestTransLC(rest_trans_lc, rest_animation->GetFrame(0));
-    ComputeTransPerFrameGB(rest_tpf_gb, rest_animation);
-    ComputeTransPerFrameGB(run_tpf_gb, run_animation);
-    ComputeTransPerFrameGB(walk_tpf_gb, walk_animation);
-
-    //initialise start animation
-    current_animation = run_animation;
-    current_tpf_gb = run_tpf_gb;
-
-    //Initialise structure for animation blending ===========================================
-    //compute distance between walk/run animations
-    std::vector<std::vector<float> > dists;
-    ComputeWalkRunDists(dists);
-
-    //print table. On DICE machine with BIG SCREEN I was able to see quite clearly
-	printf("\n\n");
-	printf("Walk/Run distance table:\n");
-	//display run header
-	printf("run  id: ");
-	for (int run_id = 0; run_id < run_animation->NumFrames(); run_id++) {
-		printf("%5d ", run_id);
-	}
-	printf("\n");
-	//table body
-	for (int walk_id = 0; walk_id < dists.size(); walk_id++) {
-		printf("walk %2d: ", walk_id);//walk header
-		for (int run_id = 0; run_id < dists[walk_id].size(); run_id++) {
-			printf("%3.1f ", dists[walk_id][run_id]);
-		}
-		printf(";\n");
-	}
-	printf("\n\n");
-
-	//how many steps to try to reach loop convergence of two animations
-	int num_frames_raw_animation = walk_animation->NumFrames() * 10;
-	std::vector<std::pair<int, int> > raw_matches;
-	ComputeWalkRunMatches(raw_matches, dists, num_frames_raw_animation);
-
-	//display raw sequence of blended frames
-	printf("\nRaw sequence of most suitable frames for blending, first - walk, second - run\n");
-	for (int i = 0; i < raw_matches.size(); i++) {
-		printf("(%d, %d);  ", raw_matches[i].first, raw_matches[i].second);
-	}
-	printf("\n");
-
-	//finding loop animation
-	ComputeWalkRunLoop(raw_matches, matches);
-
-	//display loop animation sequence of blended frames
-	printf("\nPruned sequence of most suitable frames for blending, first - walk, second - run\n");
-	for (int i = 0; i < matches.size(); i++) {
-		printf("(%d, %d);  ", matches[i].first, matches[i].second);
-	}
-	printf("\n");
-
 	//start main code =======================================================================
 
     glutInit(&argc, argv);
@@ -1064,6 +757,11 @@ int main(int argc, char **argv) {
     glutInitWindowSize(WIDTH, HEIGHT);
     glutCreateWindow("Skinning");
 
+    if (pacer.Vsync() && !EnableVsync()) {
+        printf("No swap interval control, frames are paced without vsync\n");
+        pacer.SetVsync(false);
+    }
+
     glClearColor(0.5, 0.5, 0.5, 1.0);
 
     glEnable(GL_CULL_FACE);
@@ -1080,20 +778,21 @@ int main(int argc, char **argv) {
     glEnable(GL_LIGHT0);
 
     glutDisplayFunc(Draw);
-    glutIdleFunc(Update);
     glutMouseFunc(MouseEvent);
     glutMotionFunc(MouseMoveEvent);
     glutKeyboardFunc(KeyEvent);
+    ScheduleTick();
 
     glutMainLoop();
 
     //free allocated resources =====================================================================
+    delete simulation;
     delete camera;
     delete character;
-    delete rest_animation;
-    delete run_animation;
+    delete crowd;
+    delete jobs;
     //there was a bug in the original code. The memory for walk animation hasn't been freed
-    delete walk_animation;
+    delete anims;
 }
 
 
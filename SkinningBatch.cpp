@@ -0,0 +1,674 @@
+/*
+ * Headless batch skinning. Evaluates a clip (walk, run or their mixture) over a time range,
+ * skins the character for every output frame as fast as possible and writes the result
+ * into a file. No window, no GL - only the skinning library.
+ *
+ * Output file format: for every frame xyz positions of all vertices (float32),
+ * followed by xyz normals of all vertices unless --positions-only is given.
+ *
+ * With --crowd N evaluates N independently animated instances instead of one clip
+ * and reports throughput only, nothing is written. --clusters reports how much of the
+ * character cluster culling skins for the view of --camera, nothing is written either.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "AnimationSet.h"
+#include "CharacterContext.h"
+#include "LinearBlending.h"
+#include "Timer.h"
+#include "Trace.h"
+#include "WorkerPool.h"
+#include "PerfCounters.h"
+#include "AllocTracker.h"
+#include "FrameArena.h"
+#include "Crowd.h"
+#include "JobSystem.h"
+#include "Numa.h"
+#include "Autotune.h"
+#include "Camera.h"
+#include "Frustum.h"
+#include "MeshClusters.h"
+
+static void PrintUsage() {
+    printf("usage: skinning_batch [options]\n");
+    printf("  --resources DIR     directory with character and animation smd files (./resources)\n");
+    printf("  --clip walk|run|mix clip to evaluate (run)\n");
+    printf("  --mix RATE          walk/run mix ratio for mix clip, 0 - walk, 1 - run (0.5)\n");
+    printf("  --start SEC         start of the time range in seconds (0)\n");
+    printf("  --end SEC           end of the time range in seconds (10)\n");
+    printf("  --fps N             animation speed in frames per second (30)\n");
+    printf("  --rate N            output frames per second (60)\n");
+    printf("  --no-interp         disable keyframe interpolation\n");
+    printf("  --local-blend       blend local translations and quaternions instead of global transforms\n");
+    printf("  --positions-only    don't skin normals\n");
+    printf("  --out FILE          output file, can be /dev/null (/dev/null)\n");
+    printf("  --threads N         skinning threads (1)\n");
+    printf("  --trace FILE        write Chrome trace_event timeline (needs make TRACE=1)\n");
+    printf("  --perf-counters     hardware counters around pose evaluation and skinning (Linux, single thread)\n");
+    printf("  --alloc-report      heap allocations per phase and steady-state rate (needs make ALLOC=1)\n");
+    printf("  --check-zero-alloc  fail if any frame after warmup allocates (needs make ALLOC=1)\n");
+    printf("  --warmup N          frames before steady state for allocation checks (10)\n");
+    printf("  --autotune          threads and chunk size from trial runs, cached per host and mesh\n");
+    printf("  --retune            as --autotune, measured again even if cached\n");
+    printf("  --tune-cache FILE   autotune cache ($SKINNING_TUNE_CACHE or ~/.cache/skinning_tune.txt)\n");
+    printf("crowd mode (no --out, --perf-counters, --alloc-report or --check-zero-alloc):\n");
+    printf("  --crowd N           evaluate N instances on a grid instead of one clip\n");
+    printf("  --crowd-file FILE   instance placement, \"x z heading\" per line\n");
+    printf("  --crowd-clips W R M relative amounts of walk, run and mix instances (1 1 1)\n");
+    printf("  --crowd-fps MIN MAX animation speed range of instances (20 40)\n");
+    printf("  --crowd-mix MIN MAX walk/run mix range of mix instances (0 1)\n");
+    printf("  --no-phase          start all instances at the beginning of their clip\n");
+    printf("  --seed N            seed of the instance distribution (1)\n");
+    printf("  --target-ms MS      frame time budget to fit instances into (16.7)\n");
+    printf("  --camera X Y Z      camera position for levels of detail (20 30 50, the viewer default)\n");
+    printf("  --no-lod            every instance at full detail\n");
+    printf("  --no-cull           skin instances outside of the view of the camera as well\n");
+    printf("  --jobs              one work stealing job graph per frame, prints per worker utilization\n");
+    printf("  --numa              shard instances over the NUMA nodes, workers pinned per node (implies --jobs)\n");
+    printf("  --numa-nodes N      as --numa with the CPUs split into N nodes, for trying it on one node\n");
+    printf("  --replicate-assets  with --numa, a copy of the level meshes on every node\n");
+    printf("cluster culling (no --out, --perf-counters, --alloc-report or --check-zero-alloc):\n");
+    printf("  --clusters          skin only the clusters of the character the camera (--camera) sees\n");
+}
+
+//first of the options only the single clip run supports which is given, NULL if none is
+static const char* UnsupportedOption(bool out_given, bool perf_counters, bool alloc_report, bool check_zero_alloc) {
+    if (out_given) return "--out";
+    if (perf_counters) return "--perf-counters";
+    if (check_zero_alloc) return "--check-zero-alloc";
+    if (alloc_report) return "--alloc-report";
+    return NULL;
+}
+
+static void PrintAllocCounts(const char* phase, AllocCounts counts) {
+    printf("  %-10s %10llu allocations %12llu bytes %10llu frees\n", phase, counts.allocations, counts.bytes, counts.frees);
+}
+
+//counters of one region, per item numbers tell cache bound from compute bound runs
+static void PrintPerfCounters(const char* region, PerfCounters& counters, double items, const char* item_name) {
+    printf("perf counters, %s:\n", region);
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (counters.Available(i)) {
+            printf("  %-14s %14.0f  %10.3f per %s\n", PerfCounters::Name(i), counters.Value(i),
+                   counters.Value(i) / items, item_name);
+        } else {
+            printf("  %-14s %14s\n", PerfCounters::Name(i), "n/a");
+        }
+    }
+    if (counters.Available(PERF_CYCLES) && counters.Available(PERF_INSTRUCTIONS) && counters.Value(PERF_CYCLES) > 0) {
+        printf("  %-14s %14.2f\n", "IPC", counters.Value(PERF_INSTRUCTIONS) / counters.Value(PERF_CYCLES));
+    }
+}
+
+//vertices of one pool chunk skinned into the arena of the worker which claimed it
+struct StagedChunk {
+    float* positions;
+    float* normals;
+    int num_vertices;
+};
+
+class StagedSkinTask : public RangeTask {
+    public:
+        StagedSkinTask(const Mesh* mesh, const Matrix_4x4* palette, int output, int chunk_size,
+                       WorkerArenas& arenas, StagedChunk* chunks)
+            : mesh(mesh), palette(palette), output(output), chunk_size(chunk_size)
+            , arenas(arenas), chunks(chunks) {}
+
+        //the pool runs everything in one call when it has nothing to share, so split back into chunks
+        void Run(int begin, int end, int worker_id) {
+            FrameArena& arena = arenas.Get(worker_id);
+            for (int chunk_begin = begin; chunk_begin < end; chunk_begin += chunk_size) {
+                StagedChunk& chunk = chunks[chunk_begin / chunk_size];
+                chunk.num_vertices = std::min(chunk_size, end - chunk_begin);
+                chunk.positions = arena.AllocArray<float>(chunk.num_vertices * 3);
+                chunk.normals = (output & SKIN_OUTPUT_NORMALS) ? arena.AllocArray<float>(chunk.num_vertices * 3) : NULL;
+                SkinMeshPaletteRange(mesh, palette, output, chunk.positions, chunk.normals,
+                                     chunk_begin, chunk_begin + chunk.num_vertices);
+            }
+        }
+
+        const Mesh* mesh;
+        const Matrix_4x4* palette;
+        int output;
+        int chunk_size;
+        WorkerArenas& arenas;
+        StagedChunk* chunks;
+};
+
+//the view of the viewer: looking at the character, 40 degrees vertical field of view, 800x600
+static Frustum ViewerFrustum(Vector3 camera_position) {
+    Camera camera(camera_position, Vector3(0, 15, 0));
+    camera.SetFOV(40.0f * M_PI / 180.0f);
+    camera.SetNearClipPlane(1.0f);
+    camera.SetFarClipPlane(1000.0f);
+    return Frustum(camera, 800.0f / 600.0f);
+}
+
+//simulates the time range at the output rate, every frame poses and skins the whole crowd
+//with jobs every frame is one job graph on it instead of two loops on the pool
+static int RunCrowd(const AnimationSet& anims, WorkerPool& pool, JobSystem* jobs, const CrowdConfig& config, int skin_output,
+                    float start, float end, float output_rate, float target_ms, Vector3 camera_position, bool cull,
+                    int chunk_size) {
+    Crowd crowd(&anims);
+    if (!crowd.Create(config)) {
+        return EXIT_FAILURE;
+    }
+    int num_instances = crowd.NumInstances();
+    int num_frames = (int)((end - start) * output_rate) + 1;
+    if (config.numa != NULL) {
+        //fewer with fewer threads than nodes or without pinning
+        printf("shards: %d node%s\n", crowd.NumNodes(), (crowd.NumNodes() == 1) ? "" : "s");
+    }
+    crowd.Advance(start);
+
+    Frustum frustum = ViewerFrustum(camera_position);
+
+    std::vector<double> frame_ms(num_frames);
+    std::vector<CrowdLodStats> lod_totals(crowd.Lods().NumLevels(), CrowdLodStats());
+    for (int frame = 0; frame < num_frames; frame++) {
+        TRACE_SCOPE("frame");
+        double frame_start = TimeSeconds();
+        if (jobs != NULL) {
+            crowd.Evaluate(*jobs, skin_output, camera_position, (cull) ? &frustum : NULL, chunk_size);
+        } else {
+            crowd.Evaluate(pool, skin_output, camera_position, (cull) ? &frustum : NULL, chunk_size);
+        }
+        frame_ms[frame] = (TimeSeconds() - frame_start) * 1000.0;
+        crowd.Advance(1.0f / output_rate);
+
+        for (int level = 0; level < crowd.Lods().NumLevels(); level++) {
+            CrowdLodStats stats = crowd.LodStats(level);
+            lod_totals[level].instances += stats.instances;
+            lod_totals[level].updated += stats.updated;
+            lod_totals[level].skinned_vertices += stats.skinned_vertices;
+            lod_totals[level].interpolated_vertices += stats.interpolated_vertices;
+            lod_totals[level].culled += stats.culled;
+        }
+    }
+
+    double total_ms = 0;
+    for (int i = 0; i < num_frames; i++) {
+        total_ms += frame_ms[i];
+    }
+    double mean_ms = total_ms / num_frames;
+    std::sort(frame_ms.begin(), frame_ms.end());
+    double worst_ms = frame_ms[num_frames - 1];
+    double per_instance_ms = (num_instances > 0) ? mean_ms / num_instances : 0.0;
+
+    printf("crowd: %d instances, frames: %d, vertices: %d, threads: %d, normals: %s, blend: %s\n",
+           num_instances, num_frames, anims.Character()->NumVertices(), (jobs != NULL) ? jobs->NumThreads() : pool.NumThreads(),
+           (skin_output & SKIN_OUTPUT_NORMALS) ? "on" : "off", (config.local_blend) ? "local" : "global");
+    printf("frame: %.3f ms mean, %.3f ms worst, %.4f ms per instance\n", mean_ms, worst_ms, per_instance_ms);
+    for (int level = 0; level < crowd.Lods().NumLevels(); level++) {
+        const LodLevel& lod = crowd.Lods().Level(level);
+        printf("  LOD%d (from %.0f, %d vertices, %d influences, every %d frames): %.1f instances, %.1f culled, %.1f updates, "
+               "%.0f skinned + %.0f interpolated vertices per frame\n",
+               level, lod.min_distance, lod.mesh->NumVertices(), lod.num_influences, lod.update_interval,
+               (double)lod_totals[level].instances / num_frames, (double)lod_totals[level].culled / num_frames,
+               (double)lod_totals[level].updated / num_frames,
+               (double)lod_totals[level].skinned_vertices / num_frames,
+               (double)lod_totals[level].interpolated_vertices / num_frames);
+    }
+    if (jobs != NULL) {
+        for (int worker = 0; worker < jobs->NumThreads(); worker++) {
+            JobWorkerStats stats = jobs->WorkerStats(worker);
+            printf("  worker %d (node %d): %d jobs, %d stolen, %.0f%% busy\n",
+                   worker, jobs->WorkerNode(worker), stats.jobs, stats.steals, jobs->Utilization(worker) * 100.0);
+        }
+    }
+    printf("throughput: %.0f instances/sec\n", (total_ms > 0) ? num_instances * num_frames / (total_ms / 1000.0) : 0.0);
+    if (per_instance_ms > 0) {
+        printf("fits in %.1f ms: %d instances\n", target_ms, (int)(target_ms / per_instance_ms));
+    }
+    return EXIT_SUCCESS;
+}
+
+//every frame skins the whole character once and only the clusters which survive culling once
+static int RunClusters(const AnimationSet& anims, CharacterContext& context, int skin_output,
+                       float start, float end, float output_rate, Vector3 camera_position) {
+    const MeshClusters& clusters = anims.Clusters();
+    const Mesh* mesh = clusters.ClusteredMesh();
+    Frustum frustum = ViewerFrustum(camera_position);
+    int num_frames = (int)((end - start) * output_rate) + 1;
+
+    double full_time = 0;
+    double culled_time = 0;
+    double visible = 0, outside = 0, back_facing = 0, skinned_vertices = 0, drawn_triangles = 0;
+    for (int frame = 0; frame < num_frames; frame++) {
+        TRACE_SCOPE("frame");
+        context.playback.global_frame = (start + frame / output_rate) * context.playback.frames_per_second;
+        context.BeginFrame();
+        const Matrix_4x4* palette = context.Palette();
+
+        double full_start = TimeSeconds();
+        {
+            TRACE_SCOPE("skinning");
+            context.PrepareSkin(skin_output, mesh);
+            context.SkinRange(0, mesh->NumVertices());
+        }
+        double culled_start = TimeSeconds();
+        full_time += culled_start - full_start;
+
+        ClusterCullStats stats;
+        {
+            TRACE_SCOPE("culled skinning");
+            ClusterSelection selection;
+            selection.runs = context.Scratch().AllocArray<ClusterRun>(clusters.NumClusters());
+            selection.borrowed = context.Scratch().AllocArray<int>(clusters.NumBorrowed());
+            clusters.Cull(palette, frustum, camera_position, selection, &stats);
+            context.PrepareSkin(skin_output, mesh);
+            for (int i = 0; i < selection.num_runs; i++) {
+                context.SkinRange(selection.runs[i].first_vertex, selection.runs[i].first_vertex + selection.runs[i].num_vertices);
+            }
+            for (int i = 0; i < selection.num_borrowed; i++) {
+                context.SkinRange(selection.borrowed[i], selection.borrowed[i] + 1);
+            }
+        }
+        culled_time += TimeSeconds() - culled_start;
+
+        visible += stats.visible;
+        outside += stats.outside;
+        back_facing += stats.back_facing;
+        skinned_vertices += stats.skinned_vertices;
+        drawn_triangles += stats.drawn_triangles;
+    }
+
+    printf("clusters: %d, vertices: %d, triangles: %d, frames: %d, camera: %.1f %.1f %.1f\n",
+           clusters.NumClusters(), mesh->NumVertices(), mesh->NumTriangles(), num_frames,
+           camera_position.x, camera_position.y, camera_position.z);
+    printf("per frame: %.1f clusters kept, %.1f outside, %.1f facing away\n",
+           visible / num_frames, outside / num_frames, back_facing / num_frames);
+    printf("per frame: %.0f vertices skinned (%.1f%%), %.0f triangles drawn (%.1f%%)\n",
+           skinned_vertices / num_frames, 100.0 * skinned_vertices / num_frames / std::max(1, mesh->NumVertices()),
+           drawn_triangles / num_frames, 100.0 * drawn_triangles / num_frames / std::max(1, mesh->NumTriangles()));
+    printf("skinning: %.3f ms per frame whole, %.3f ms with culling\n",
+           full_time * 1000.0 / num_frames, culled_time * 1000.0 / num_frames);
+    return EXIT_SUCCESS;
+}
+
+static int ParseClip(const char* name) {
+    if (strcmp(name, "walk") == 0) return CLIP_WALK;
+    if (strcmp(name, "run") == 0)  return CLIP_RUN;
+    if (strcmp(name, "mix") == 0)  return CLIP_MIX;
+    printf("Unknown clip %s\n", name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+
+    std::string resources = "./resources";
+    std::string out_filename = "/dev/null";
+    bool out_given = false;
+    std::string clip_name = "run";
+    int clip = CLIP_RUN;
+    float walk_run_mix_rate = 0.5f;
+    float start = 0.0f;
+    float end = 10.0f;
+    float frames_per_second = 30.0f;
+    float output_rate = 60.0f;
+    bool time_interpolation = true;
+    bool local_blend = false;
+    int skin_output = SKIN_OUTPUT_ALL;
+    int num_threads = 1;
+    bool perf_counters = false;
+    bool alloc_report = false;
+    bool check_zero_alloc = false;
+    int warmup_frames = 10;
+    std::string trace_filename = "";
+    bool crowd_mode = false;
+    CrowdConfig crowd_config;
+    float target_ms = 16.7f;
+    Vector3 camera_position(20, 30, 50);
+    bool cull = true;
+    bool use_jobs = false;
+    bool numa = false;
+    int numa_nodes = 0;
+    bool clusters = false;
+    bool autotune = false;
+    bool retune = false;
+    std::string tune_cache = "";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--resources" && has_value) {
+            resources = argv[++i];
+        } else if (arg == "--clip" && has_value) {
+            clip_name = argv[++i];
+            clip = ParseClip(clip_name.c_str());
+        } else if (arg == "--mix" && has_value) {
+            walk_run_mix_rate = atof(argv[++i]);
+        } else if (arg == "--start" && has_value) {
+            start = atof(argv[++i]);
+        } else if (arg == "--end" && has_value) {
+            end = atof(argv[++i]);
+        } else if (arg == "--fps" && has_value) {
+            frames_per_second = atof(argv[++i]);
+        } else if (arg == "--rate" && has_value) {
+            output_rate = atof(argv[++i]);
+        } else if (arg == "--no-interp") {
+            time_interpolation = false;
+        } else if (arg == "--local-blend") {
+            local_blend = true;
+            crowd_config.local_blend = true;
+        } else if (arg == "--positions-only") {
+            skin_output = SKIN_OUTPUT_POSITIONS;
+        } else if (arg == "--out" && has_value) {
+            out_filename = argv[++i];
+            out_given = true;
+        } else if (arg == "--threads" && has_value) {
+            num_threads = atoi(argv[++i]);
+        } else if (arg == "--trace" && has_value) {
+            trace_filename = argv[++i];
+        } else if (arg == "--perf-counters") {
+            perf_counters = true;
+        } else if (arg == "--alloc-report") {
+            alloc_report = true;
+        } else if (arg == "--check-zero-alloc") {
+            alloc_report = true;
+            check_zero_alloc = true;
+        } else if (arg == "--warmup" && has_value) {
+            warmup_frames = atoi(argv[++i]);
+        } else if (arg == "--autotune") {
+            autotune = true;
+        } else if (arg == "--retune") {
+            autotune = true;
+            retune = true;
+        } else if (arg == "--tune-cache" && has_value) {
+            tune_cache = argv[++i];
+        } else if (arg == "--crowd" && has_value) {
+            crowd_mode = true;
+            crowd_config.num_instances = atoi(argv[++i]);
+        } else if (arg == "--crowd-file" && has_value) {
+            crowd_mode = true;
+            crowd_config.placement_file = argv[++i];
+        } else if (arg == "--crowd-clips" && i + 3 < argc) {
+            crowd_config.clip_weights[CLIP_WALK] = atof(argv[++i]);
+            crowd_config.clip_weights[CLIP_RUN] = atof(argv[++i]);
+            crowd_config.clip_weights[CLIP_MIX] = atof(argv[++i]);
+        } else if (arg == "--crowd-fps" && i + 2 < argc) {
+            crowd_config.min_fps = atof(argv[++i]);
+            crowd_config.max_fps = atof(argv[++i]);
+        } else if (arg == "--crowd-mix" && i + 2 < argc) {
+            crowd_config.min_mix = atof(argv[++i]);
+            crowd_config.max_mix = atof(argv[++i]);
+        } else if (arg == "--no-phase") {
+            crowd_config.random_phase = false;
+        } else if (arg == "--seed" && has_value) {
+            crowd_config.seed = atoi(argv[++i]);
+        } else if (arg == "--target-ms" && has_value) {
+            target_ms = atof(argv[++i]);
+        } else if (arg == "--camera" && i + 3 < argc) {
+            float x = atof(argv[++i]);
+            float y = atof(argv[++i]);
+            float z = atof(argv[++i]);
+            camera_position = Vector3(x, y, z);
+        } else if (arg == "--no-lod") {
+            crowd_config.lod = false;
+        } else if (arg == "--jobs") {
+            use_jobs = true;
+        } else if (arg == "--numa") {
+            numa = true;
+        } else if (arg == "--numa-nodes" && has_value) {
+            numa = true;
+            numa_nodes = atoi(argv[++i]);
+        } else if (arg == "--replicate-assets") {
+            crowd_config.replicate_assets = true;
+        } else if (arg == "--no-cull") {
+            cull = false;
+        } else if (arg == "--clusters") {
+            clusters = true;
+        } else {
+            PrintUsage();
+            return (arg == "--help" || arg == "-h") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (end < start || output_rate <= 0) {
+        printf("Empty time range\n");
+        return EXIT_FAILURE;
+    }
+    //crowd and cluster runs only time frames: they write no vertices and count neither allocations
+    //nor hardware events, a check which can't run must not pass
+    if (crowd_mode || clusters) {
+        const char* unsupported = UnsupportedOption(out_given, perf_counters, alloc_report, check_zero_alloc);
+        if (unsupported != NULL) {
+            printf("%s can't be combined with %s\n", unsupported, (crowd_mode) ? "--crowd" : "--clusters");
+            return EXIT_FAILURE;
+        }
+    }
+    if (walk_run_mix_rate < 0) walk_run_mix_rate = 0;
+    if (walk_run_mix_rate > 1) walk_run_mix_rate = 1;
+
+    if (!trace_filename.empty()) {
+#ifndef SKIN_TRACE
+        printf("Tracing is not compiled in, rebuild with make TRACE=1\n");
+#endif
+        TRACE_THREAD_NAME("main");
+        TraceStart();
+    }
+
+    //counters only see the calling thread
+    PerfCounters pose_counters;
+    PerfCounters skin_counters;
+    if (perf_counters) {
+        if (num_threads != 1) {
+            printf("Hardware counters only count the calling thread, skinning on 1 thread\n");
+            num_threads = 1;
+        }
+        if (!pose_counters.Open() || !skin_counters.Open()) {
+            printf("Hardware counters not available: %s\n", pose_counters.Error());
+            perf_counters = false;
+        }
+    }
+
+    if (alloc_report && !AllocTrackingCompiled()) {
+        printf("Allocation tracking is not compiled in, rebuild with make clean && make ALLOC=1\n");
+        if (check_zero_alloc) {
+            return EXIT_FAILURE;
+        }
+        alloc_report = false;
+    }
+
+    //allocations per phase, frames before warmup_frames only go into the totals
+    AllocPhase load_allocs, pose_allocs, skin_allocs, write_allocs, frame_allocs;
+    AllocCounts steady_allocs;
+    double steady_time = 0;
+    int first_allocating_frame = -1;
+    const char* first_allocating_phase = "";
+
+    load_allocs.Start();
+    AnimationSet anims;
+    anims.Load(resources, false);
+
+    //measured once per host and mesh, later runs read it from the cache. Trials run on what the
+    //result is used with: crowds with --jobs or --numa on a JobSystem, everything else on a WorkerPool
+    int chunk_size = 0;
+    if (autotune) {
+        TuneExecutor executor = (crowd_mode && (use_jobs || numa)) ? TUNE_JOB_SYSTEM : TUNE_WORKER_POOL;
+        Autotuner tuner(&anims, WorkerPool::HardwareThreads(), executor);
+        if (!tune_cache.empty()) {
+            tuner.SetCacheFile(tune_cache);
+        }
+        TuneConfig tuned = tuner.Tune(retune);
+        printf("autotune: %d threads, %d vertex chunks, %.1f us per pass, %s %s\n", tuned.num_threads, tuned.chunk_size,
+               tuned.pass_us, (tuned.cached) ? "cached in" : "measured, cache", tuner.CacheFile().c_str());
+        num_threads = (perf_counters) ? 1 : tuned.num_threads;
+        chunk_size = tuned.chunk_size;
+    }
+
+    if (crowd_mode) {
+        //a single node shards nothing, the run is the same as with --jobs
+        NumaTopology topology;
+        if (numa) {
+            topology.Detect();
+            if (numa_nodes > 0) {
+                topology.Emulate(numa_nodes);
+            }
+            printf("numa: %s\n", topology.Describe().c_str());
+            crowd_config.numa = &topology;
+            use_jobs = true;
+        }
+        WorkerPool pool((use_jobs) ? 1 : num_threads);
+        JobSystem* jobs = (use_jobs) ? new JobSystem(num_threads, (numa) ? &topology : NULL) : NULL;
+        crowd_config.jobs = jobs;
+        int result = RunCrowd(anims, pool, jobs, crowd_config, skin_output, start, end, output_rate, target_ms, camera_position, cull,
+                              (chunk_size > 0) ? chunk_size : 2048);
+        delete jobs;
+        if (!trace_filename.empty() && !TraceWrite(trace_filename)) {
+            printf("Failed to write trace to %s\n", trace_filename.c_str());
+        }
+        return result;
+    }
+    WorkerPool pool(num_threads);
+    //palette and chunk table of the frame live in the context scratch, skinned chunks in the arena of their worker
+    CharacterContext context(&anims);
+    context.playback.clip = clip;
+    context.playback.frames_per_second = frames_per_second;
+    context.playback.walk_run_mix_rate = walk_run_mix_rate;
+    context.playback.time_interpolation = time_interpolation;
+    context.playback.local_blend = local_blend;
+    if (clusters) {
+        int result = RunClusters(anims, context, skin_output, start, end, output_rate, camera_position);
+        if (!trace_filename.empty() && !TraceWrite(trace_filename)) {
+            printf("Failed to write trace to %s\n", trace_filename.c_str());
+        }
+        return result;
+    }
+    WorkerArenas worker_arenas(pool.NumThreads());
+
+    FILE* out = fopen(out_filename.c_str(), "wb");
+    if (out == NULL) {
+        printf("Failed to open output file %s\n", out_filename.c_str());
+        return EXIT_FAILURE;
+    }
+
+    const Mesh* character = anims.Character();
+    int num_vertices = character->NumVertices();
+    int num_frames = (int)((end - start) * output_rate) + 1;
+    if (chunk_size <= 0) {
+        chunk_size = std::max(256, num_vertices / (pool.NumThreads() * 4));
+    }
+    int num_chunks = (num_vertices + chunk_size - 1) / chunk_size;
+    load_allocs.Stop();
+
+    double skin_time = 0;
+    double write_time = 0;
+    size_t bytes_written = 0;
+
+    for (int frame = 0; frame < num_frames; frame++) {
+        TRACE_SCOPE("frame");
+        double frame_start = TimeSeconds();
+        frame_allocs.Start();
+        worker_arenas.Reset();
+        pose_allocs.Start();
+
+        const Matrix_4x4* palette = NULL;
+        if (perf_counters) pose_counters.Start();
+        {
+            TRACE_SCOPE("pose");
+            float global_frame = (start + frame / output_rate) * frames_per_second;
+            context.playback.global_frame = global_frame;
+            context.BeginFrame();
+            palette = context.Palette();
+        }
+        if (perf_counters) pose_counters.Stop();
+        pose_allocs.Stop();
+        skin_allocs.Start();
+
+        StagedChunk* chunks = context.Scratch().AllocArray<StagedChunk>(num_chunks);
+        if (perf_counters) skin_counters.Start();
+        {
+            TRACE_SCOPE("skinning");
+            StagedSkinTask task(character, palette, skin_output, chunk_size, worker_arenas, chunks);
+            pool.ParallelFor(num_vertices, chunk_size, &task);
+        }
+        if (perf_counters) skin_counters.Stop();
+        skin_allocs.Stop();
+
+        double frame_skinned = TimeSeconds();
+        write_allocs.Start();
+
+        TRACE_SCOPE("write");
+        for (int i = 0; i < num_chunks; i++) {
+            bytes_written += fwrite(chunks[i].positions, sizeof(float), chunks[i].num_vertices * 3, out) * sizeof(float);
+        }
+        if (skin_output & SKIN_OUTPUT_NORMALS) {
+            for (int i = 0; i < num_chunks; i++) {
+                bytes_written += fwrite(chunks[i].normals, sizeof(float), chunks[i].num_vertices * 3, out) * sizeof(float);
+            }
+        }
+
+        write_allocs.Stop();
+        frame_allocs.Stop();
+
+        skin_time += frame_skinned - frame_start;
+        write_time += TimeSeconds() - frame_skinned;
+
+        if (frame >= warmup_frames) {
+            steady_allocs = steady_allocs + frame_allocs.Last();
+            steady_time += TimeSeconds() - frame_start;
+            if (frame_allocs.Last().allocations > 0 && first_allocating_frame == -1) {
+                first_allocating_frame = frame;
+                first_allocating_phase = (pose_allocs.Last().allocations > 0) ? "pose"
+                                       : (skin_allocs.Last().allocations > 0) ? "skinning"
+                                       : (write_allocs.Last().allocations > 0) ? "write" : "arena reset";
+            }
+        }
+    }
+
+    fclose(out);
+
+    if (!trace_filename.empty() && !TraceWrite(trace_filename)) {
+        printf("Failed to write trace to %s\n", trace_filename.c_str());
+    }
+
+    printf("clip: %s", clip_name.c_str());
+    if (clip == CLIP_MIX) {
+        printf(" (walk/run mix %.2f)", walk_run_mix_rate);
+    }
+    printf(", frames: %d, vertices: %d, threads: %d, interpolation: %s, normals: %s, blend: %s\n",
+           num_frames, num_vertices, pool.NumThreads(), (time_interpolation) ? "on" : "off",
+           (skin_output & SKIN_OUTPUT_NORMALS) ? "on" : "off", (local_blend) ? "local" : "global");
+    printf("skinning: %.3f s, %.1f frames/sec, %.0f vertices/sec\n",
+           skin_time, num_frames / skin_time, (double)num_frames * num_vertices / skin_time);
+    printf("output: %s, %lu bytes, %.3f s\n", out_filename.c_str(), (unsigned long)bytes_written, write_time);
+    printf("frame arena: %lu bytes, worker arenas: %lu bytes\n",
+           (unsigned long)context.Scratch().HighWater(), (unsigned long)worker_arenas.HighWater());
+
+    if (alloc_report) {
+        int steady_frames = std::max(0, num_frames - warmup_frames);
+        printf("heap allocations:\n");
+        PrintAllocCounts("load", load_allocs.Total());
+        PrintAllocCounts("pose", pose_allocs.Total());
+        PrintAllocCounts("skinning", skin_allocs.Total());
+        PrintAllocCounts("write", write_allocs.Total());
+        PrintAllocCounts("frames", frame_allocs.Total());
+        printf("steady state (%d frames after %d warmup): %.2f allocations/frame, %.1f bytes/frame, %.1f allocations/sec\n",
+               steady_frames, warmup_frames,
+               (steady_frames > 0) ? (double)steady_allocs.allocations / steady_frames : 0.0,
+               (steady_frames > 0) ? (double)steady_allocs.bytes / steady_frames : 0.0,
+               (steady_time > 0) ? steady_allocs.allocations / steady_time : 0.0);
+    }
+
+    if (perf_counters) {
+        PrintPerfCounters("pose evaluation", pose_counters, num_frames, "frame");
+        PrintPerfCounters("skinning", skin_counters, (double)num_frames * num_vertices, "vertex");
+    }
+
+    if (check_zero_alloc) {
+        if (first_allocating_frame != -1) {
+            printf("FAILED: frame %d allocated in %s after warmup\n", first_allocating_frame, first_allocating_phase);
+            return EXIT_FAILURE;
+        }
+        printf("OK: no allocations in steady state\n");
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#pragma once
+
+/*
+ * Global heap allocation counting. Built with -DSKIN_TRACK_ALLOC (make ALLOC=1) the library
+ * replaces operator new/delete and counts every allocation of every thread, otherwise all
+ * counts stay zero and AllocTrackingCompiled() returns false.
+ */
+
+struct AllocCounts {
+    unsigned long long allocations;
+    unsigned long long frees;
+    unsigned long long bytes;       //allocated bytes, frees don't subtract
+
+    AllocCounts();
+    AllocCounts operator-(const AllocCounts& earlier) const;
+    AllocCounts operator+(const AllocCounts& other) const;
+};
+
+bool AllocTrackingCompiled();
+
+//totals since start of the process
+AllocCounts AllocCurrentCounts();
+
+//allocations of one phase accumulated over every Start/Stop window
+class AllocPhase {
+
+    public:
+        AllocPhase();
+
+        void Start();
+        void Stop();
+
+        //over all windows
+        AllocCounts Total();
+        //of the last finished window
+        AllocCounts Last();
+        int NumWindows();
+
+    private:
+        AllocCounts m_start;
+        AllocCounts m_total;
+        AllocCounts m_last;
+        int m_num_windows;
+};
+
+#endif
@@ -1,22 +1,37 @@
 #ifndef ANIMATION_H
 #define ANIMATION_H
 
+#include <vector>
+
 #include "Skeleton.h"
+#include "SkeletonPool.h"
 
 class Animation {
 
     public:
-        Animation();
+        //frames are allocated from pool, which must outlive the animation.
+        //Without a pool the animation uses one of its own
+        Animation(SkeletonPool* pool = NULL);
         ~Animation();
         
-        void AddFrame(Skeleton* frame);
-        Skeleton* GetFrame(int i);
-        int NumFrames();
+        //new last frame with the joints of base, returned to be filled in.
+        //All frames must have the same topology
+        Skeleton* AddFrame(const Skeleton* base);
+        Skeleton* AddFrame(const SkeletonTopology* topology, const Joint* joints);
+        const Skeleton* GetFrame(int i) const;
+        int NumFrames() const;
+
+        //shared by the frames, NULL without frames. Clips can be blended if the pointers are equal
+        const SkeletonTopology* Topology() const;
         
         private:
+        Animation(const Animation&);
+        Animation& operator=(const Animation&);
         
-        int m_num_frames;
-        Skeleton** m_frames;
+        SkeletonPool* m_pool;
+        bool m_owns_pool;
+        std::vector<Skeleton*> m_frames;
+        const SkeletonTopology* m_topology;
 };
 
 #endif
\ No newline at end of file
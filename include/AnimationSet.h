@@ -0,0 +1,123 @@
+#ifndef ANIMATION_SET_H
+#define ANIMATION_SET_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "Matrix.h"
+#include "Geometry.h"
+#include "Animation.h"
+#include "SkeletonPool.h"
+#include "LinearBlending.h"
+#include "LocalPose.h"
+#include "Bounds.h"
+#include "MeshClusters.h"
+#include "Lod.h"
+#include "JointMask.h"
+
+//clips which can be played
+enum {
+    CLIP_RUN  = 0,
+    CLIP_WALK = 1,
+    CLIP_MIX  = 2  //walk/run blending
+};
+
+/*
+ * The character with its rest, walk and run animations and everything
+ * precomputed from them: global transforms and local poses per frame and walk/run frame matches.
+ * Nothing changes after Load, so one set can be read by any number of threads
+ * (see CharacterContext for the per character state).
+ */
+class AnimationSet {
+
+    public:
+        AnimationSet();
+        ~AnimationSet();
+
+        //loads resources_dir/{character,rest_animation,run_animation,walk_animation}.smd
+        //verbose - print walk/run distance table and matches
+        void Load(std::string resources_dir, bool verbose);
+
+        int NumFrames(int clip) const;
+
+        const Mesh* Character() const;
+
+        const Animation* RestAnimation() const;
+        const Animation* RunAnimation() const;
+        const Animation* WalkAnimation() const;
+
+        const std::vector<Matrix_4x4>& RestTransLC() const;
+        //joints the character is skinned with and their ancestors. Per frame global transforms
+        //are identities for every other joint, and poses and palettes skip them
+        const JointMask& RequiredJoints() const;
+        const std::vector<std::vector<Matrix_4x4> >& RunTransPerFrameGB() const;
+        const std::vector<std::vector<Matrix_4x4> >& WalkTransPerFrameGB() const;
+
+        //translations and quaternions of every frame, for blending in local space
+        const std::vector<LocalPose>& RunLocalPoses() const;
+        const std::vector<LocalPose>& WalkLocalPoses() const;
+
+        //boxes of the rest pose vertices every joint influences, for SkinnedBounds
+        const std::vector<Aabb>& JointBounds() const;
+        //the character split into patches which can be culled before skinning
+        const MeshClusters& Clusters() const;
+        //levels of detail of the character with the default LodConfig, crowds take their meshes
+        //instead of decimating again
+        const LodSet& Lods() const;
+
+        //matches between walk and run frames, first - walk frame, second - run frame
+        const std::vector<std::pair<int, int> >& Matches() const;
+        //local blending of CLIP_MIX poses the joints within a tolerance of the global blend,
+        //checked at Load. Without it the mix is blended globally even with Playback::local_blend
+        bool LocalMixBlend() const;
+
+    private:
+        AnimationSet(const AnimationSet&);
+        AnimationSet& operator=(const AnimationSet&);
+
+        //joints of every frame of the animations, outlives them as members are destroyed after ~AnimationSet
+        SkeletonPool m_skeleton_pool;
+
+        Mesh* m_character;
+
+        Animation* m_rest_animation;
+        Animation* m_run_animation;
+        Animation* m_walk_animation;
+
+        std::vector<Matrix_4x4> m_rest_trans_lc;
+        JointMask m_required_joints;
+        std::vector<Aabb> m_joint_bounds;
+        MeshClusters m_clusters;
+        LodSet m_lods;
+        std::vector<std::vector<Matrix_4x4> > m_run_tpf_gb;
+        std::vector<std::vector<Matrix_4x4> > m_walk_tpf_gb;
+        std::vector<LocalPose> m_run_local;
+        std::vector<LocalPose> m_walk_local;
+
+        std::vector<std::pair<int, int> > m_matches;
+        bool m_local_mix_blend;
+};
+
+//Frames of a clip to interpolate between at some time
+struct ClipTime {
+    int curr_frame;
+    int next_frame;
+    //interpolation parameter between 0 and 1
+    float frame_mix_rate;
+};
+
+//global_frame - time in frames since start, in frame_mode selected_frame is shown instead
+ClipTime SampleClipTime(int num_frames, float global_frame, bool frame_mode, int selected_frame);
+
+//Poses of the clip to skin with at given time
+void SamplePoses(const AnimationSet& set, int clip, ClipTime time, bool time_interpolation,
+                 float walk_run_mix_rate, SkinPoses& poses);
+
+//the same frames and weights as SamplePoses, as local poses to blend with BlendLocalPoses
+void SampleLocalPoses(const AnimationSet& set, int clip, ClipTime time, bool time_interpolation,
+                      float walk_run_mix_rate, LocalPoses& poses);
+
+#endif
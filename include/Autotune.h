@@ -0,0 +1,76 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#pragma once
+
+#include <string>
+
+#include "AnimationSet.h"
+#include "JobSystem.h"
+
+//what the skinning is going to run on, trials run on the same
+enum TuneExecutor {
+    TUNE_JOB_SYSTEM = 0,
+    TUNE_WORKER_POOL = 1
+};
+
+//how the skinning of a frame is split up
+struct TuneConfig {
+    int num_threads;
+    int chunk_size;
+    //median time of one skinning pass of the character with it, microseconds
+    double pass_us;
+    //read from the cache instead of measured
+    bool cached;
+
+    TuneConfig();
+};
+
+/*
+ * Picks thread count and vertex chunk size for the skinning of the loaded character by timing
+ * short trial passes of every combination (palette skinning on the executor the result is used
+ * with, the viewer's JobSystem or a WorkerPool) and keeps the fastest. A configuration with fewer
+ * threads is only given up for one at least a few percent faster, so cores nobody gains from stay
+ * free. Results are kept in a cache file, one line per host, mesh and executor, so later runs just
+ * read them.
+ * SKIN_POSE_LANES is fixed at compile time, it is part of the key instead of the trials.
+ */
+class Autotuner {
+
+    public:
+        //max_threads - most threads the caller is going to run the skinning on
+        Autotuner(const AnimationSet* assets, int max_threads, TuneExecutor executor = TUNE_JOB_SYSTEM);
+
+        //cache entry of this host and mesh if there is one, otherwise (or with retune) trial
+        //runs whose winner is written back to the cache
+        TuneConfig Tune(bool retune = false);
+        //trial runs only
+        TuneConfig Measure();
+
+        //$SKINNING_TUNE_CACHE, otherwise skinning_tune.txt in $XDG_CACHE_HOME or ~/.cache,
+        //otherwise in the working directory
+        void SetCacheFile(const std::string& filename);
+        const std::string& CacheFile() const;
+        //cpu model, hardware threads, max_threads, lanes, mesh signature and executor
+        const std::string& Key() const;
+
+        //"model name" of /proc/cpuinfo, "unknown cpu" where there is none
+        static std::string CpuModel();
+        //hash of the vertices and triangles, changes with any edit of the mesh
+        static unsigned int MeshSignature(const Mesh* mesh);
+        static std::string DefaultCacheFile();
+
+    private:
+        bool Load(TuneConfig& config);
+        bool Save(const TuneConfig& config);
+        template <class Executor>
+        double TimePass(Executor& executor, int chunk_size);
+
+        const AnimationSet* m_assets;
+        int m_max_threads;
+        TuneExecutor m_executor;
+        std::string m_cache_file;
+        std::string m_key;
+};
+
+#endif
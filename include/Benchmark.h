@@ -0,0 +1,49 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*
+ * Minimal microbenchmark harness. A case is run warmup times unmeasured and then
+ * repetitions times measured, every measured run gives one sample of time per operation.
+ */
+class BenchCase {
+
+    public:
+        //ops_per_run - how many operations one call of Run performs, results are per operation
+        BenchCase(std::string name, int ops_per_run);
+        virtual ~BenchCase();
+
+        virtual void Run() = 0;
+
+        std::string name;
+        int ops_per_run;
+};
+
+struct BenchStats {
+    std::string name;
+    int repetitions;
+    int ops_per_run;
+    //nanoseconds per operation
+    double min_ns;
+    double median_ns;
+    double p99_ns;
+    double mean_ns;
+};
+
+//write results here so the compiler can't throw the measured work away
+extern volatile float bench_sink;
+
+BenchStats RunBenchCase(BenchCase& bench, int warmup, int repetitions);
+
+//p between 0 and 1, nearest rank
+double Percentile(std::vector<double> samples, double p);
+
+void PrintBenchTable(FILE* f, std::vector<BenchStats>& stats);
+void WriteBenchJSON(FILE* f, std::vector<BenchStats>& stats, int warmup, int repetitions);
+
+#endif
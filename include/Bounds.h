@@ -0,0 +1,35 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#pragma once
+
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "Geometry.h"
+
+//axis aligned box, empty until something is added
+struct Aabb {
+    Vector3 lower;
+    Vector3 upper;
+    bool empty;
+
+    Aabb();
+    void Add(Vector3 point);
+    void Add(const Aabb& box);
+    //box around the transformed corners
+    Aabb Transformed(const Matrix_4x4& transform) const;
+};
+
+/*
+ * Box of every joint around the rest pose vertices it influences, in mesh space.
+ * A skinned vertex is a weighted average of its influences' palette transforms of the rest
+ * position, so it lies inside the union of the joint boxes transformed by the palette.
+ */
+void ComputeJointBounds(const Mesh* mesh, int num_joints, std::vector<Aabb>& joint_bounds);
+
+//conservative box of the mesh skinned with palette, without skinning a vertex
+Aabb SkinnedBounds(const std::vector<Aabb>& joint_bounds, const Matrix_4x4* palette);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef CHARACTER_CONTEXT_H
+#define CHARACTER_CONTEXT_H
+
+#pragma once
+
+#include "Matrix.h"
+#include "AnimationSet.h"
+#include "LinearBlending.h"
+#include "FrameArena.h"
+#include "LocalPose.h"
+#include "PoseBatch.h"
+
+//what a character plays and where it is in it
+struct Playback {
+    int clip;
+    //time in frames since start
+    float global_frame;
+    float frames_per_second;
+    //0 - walk, 1 - run, for CLIP_MIX
+    float walk_run_mix_rate;
+    bool time_interpolation;
+    //selected_frame is shown instead of the current time
+    bool frame_mode;
+    int selected_frame;
+    //blend translations and quaternions of the local poses and skin with the one composed
+    //pose, instead of skinning with the weighted global poses
+    bool local_blend;
+
+    Playback();
+};
+
+/*
+ * Evaluation state of one character: its playback and the scratch of the current frame,
+ * over assets which are only read. Contexts share nothing writable, so many threads can
+ * evaluate many characters from one AnimationSet without locking.
+ */
+class CharacterContext {
+
+    public:
+        CharacterContext(const AnimationSet* assets);
+
+        const AnimationSet* Assets() const;
+
+        //moves playback time forward
+        void Advance(float seconds);
+
+        //releases scratch of the previous frame and samples the poses at the current time.
+        //With playback.local_blend and compose false the blended local pose is left for the
+        //caller to compose (several contexts in one PoseBatch) and hand back with SetComposed
+        void BeginFrame(bool compose = true);
+        const LocalPose& LocalBlend() const;
+        //playback.local_blend, unless the clip is the mix and the assets don't blend it locally
+        bool BlendsLocal() const;
+        void SetComposed(const PoseBatch& batch, int lane);
+
+        ClipTime Time() const;
+        const SkinPoses& Poses() const;
+
+        //skinning palette of the poses, computed on first use in a frame
+        const Matrix_4x4* Palette();
+
+        //skins the whole character into the frame scratch, normals only if output asks for them
+        void Skin(int output);
+
+        //Skin split in two: PrepareSkin computes the palette and allocates the output, after it
+        //SkinRange can be called for disjoint vertex ranges from different threads.
+        //mesh - level of detail of the character to skin instead of it (see LodSet).
+        //positions, normals - where to skin to instead of the frame scratch, room for every vertex
+        void PrepareSkin(int output, const Mesh* mesh = NULL, int num_influences = 3,
+                         float* positions = NULL, float* normals = NULL);
+        void SkinRange(int begin, int end);
+        const float* Positions() const;
+        //NULL if the last Skin didn't produce normals
+        const float* Normals() const;
+
+        //for anything else which lives until the next BeginFrame
+        FrameArena& Scratch();
+
+        Playback playback;
+
+    private:
+        CharacterContext(const CharacterContext&);
+        CharacterContext& operator=(const CharacterContext&);
+
+        const AnimationSet* m_assets;
+        FrameArena m_scratch;
+
+        ClipTime m_time;
+        SkinPoses m_poses;
+        LocalPoses m_local_poses;
+        LocalPose m_local_blend;
+        std::vector<Matrix_4x4> m_blended_gb;
+        Matrix_4x4* m_palette;
+        int m_output;
+        const Mesh* m_skin_mesh;
+        int m_num_influences;
+        float* m_positions;
+        float* m_normals;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Vector.h"
+#include "AnimationSet.h"
+#include "CharacterContext.h"
+#include "WorkerPool.h"
+#include "JobSystem.h"
+#include "PoseBatch.h"
+#include "Lod.h"
+#include "Frustum.h"
+#include "Numa.h"
+
+//distribution the playback of every instance is drawn from
+struct CrowdConfig {
+    int num_instances;
+    //relative amounts of instances playing CLIP_WALK, CLIP_RUN and CLIP_MIX
+    float clip_weights[3];
+    //playback speed in frames per second
+    float min_fps, max_fps;
+    //walk/run mix of CLIP_MIX instances
+    float min_mix, max_mix;
+    //start every instance at a random point of its clip
+    bool random_phase;
+    unsigned int seed;
+    //instances blend local poses, composed SKIN_POSE_LANES instances at a time (Playback::local_blend)
+    bool local_blend;
+
+    //square grid with this distance between instances, unless placement_file is given
+    float spacing;
+    //"x z heading_degrees" per line, # starts a comment. Gives the number of instances
+    std::string placement_file;
+
+    //levels of detail by distance to the camera, otherwise every instance is full detail
+    bool lod;
+    LodConfig lod_config;
+
+    //nodes the instances are sharded over, NULL or a single node for no sharding. Only used by Create
+    const NumaTopology* numa;
+    //JobSystem the crowd is evaluated with, created with numa. Instances are only sharded over the
+    //nodes it has workers on, NULL for no sharding
+    JobSystem* jobs;
+    //every node skins the level meshes from a copy of its own instead of the ones of the assets
+    bool replicate_assets;
+
+    CrowdConfig();
+};
+
+//what one level of detail cost in the last Evaluate
+struct CrowdLodStats {
+    int instances;
+    //instances whose pose was evaluated
+    int updated;
+    int skinned_vertices;
+    int interpolated_vertices;
+    //outside the frustum, neither skinned nor drawn
+    int culled;
+};
+
+/*
+ * Many independently animated instances of the character of one AnimationSet.
+ * Every instance is a CharacterContext of its own, so a frame is evaluated in two batches
+ * on the pool: poses (and palettes) of all instances, then skinning of all instances
+ * split into vertex chunks, so even a few instances keep every worker busy.
+ * With levels of detail far instances skin a cheaper mesh and only every few frames,
+ * in between their two last skinned results are interpolated. With a frustum, instances
+ * whose bounds from the joint boxes and the palette are outside of it aren't skinned at all.
+ * Sharded over the nodes of a NumaTopology, the jobs of an instance run on workers of its node
+ * (Evaluate with the JobSystem of the config), so its pose, scratch and skinned buffers
+ * are first touched and stay there. Clip data is shared by every node.
+ */
+class Crowd {
+
+    public:
+        Crowd(const AnimationSet* assets);
+        ~Crowd();
+
+        //false if the placement file can't be read
+        bool Create(const CrowdConfig& config);
+
+        int NumInstances();
+        CharacterContext& Instance(int i);
+        Vector3 Position(int i);
+        //rotation around y in degrees
+        float Heading(int i);
+
+        void Advance(float seconds);
+
+        //poses and skinned vertices of every instance for the current time, levels of
+        //detail by distance to camera_position, culled against frustum unless it is NULL.
+        //Valid until the next Evaluate
+        void Evaluate(WorkerPool& pool, int skin_output, Vector3 camera_position,
+                      const Frustum* frustum = NULL, int chunk_size = 2048);
+        //Evaluate as one job graph: the vertex chunks of an instance only wait for the pose group
+        //of that instance instead of all poses, interpolated instances don't wait at all
+        void Evaluate(JobSystem& jobs, int skin_output, Vector3 camera_position,
+                      const Frustum* frustum = NULL, int chunk_size = 2048);
+
+        //false if culled in the last Evaluate, then there is nothing to draw
+        bool Visible(int i);
+        //model to world transform of instance i
+        const Matrix_4x4& World(int i);
+
+        //what to draw for instance i, normals are NULL if skin_output had none
+        const Mesh* InstanceMesh(int i);
+        const float* Positions(int i);
+        const float* Normals(int i);
+        int InstanceLod(int i);
+        //node of the shard instance i belongs to
+        int HomeNode(int i);
+        //nodes with a shard, 1 without sharding
+        int NumNodes();
+
+        const LodSet& Lods();
+        CrowdLodStats LodStats(int level);
+
+    private:
+        Crowd(const Crowd&);
+        Crowd& operator=(const Crowd&);
+
+        //how an instance gets its vertices in this frame
+        enum LodMode {
+            LOD_SKIN,         //skinned by its context
+            LOD_SKIN_NEXT,    //skinned into next, drawn from prev (interpolated right after entering a level)
+            LOD_INTERPOLATE   //between prev and next
+        };
+
+        struct InstanceLodState {
+            int level;
+            int frames_to_update;
+            int frames_since_update;
+            int mode;
+            //frames the pose of an update is ahead of the current time
+            float ahead_frames;
+            //results of the last two updates and their interpolation, for levels updated less than every frame
+            std::vector<float> prev_positions, prev_normals;
+            std::vector<float> next_positions, next_normals;
+            std::vector<float> positions, normals;
+            const float* draw_positions;
+            const float* draw_normals;
+
+            bool visible;
+            //model space bounds of the last update and of what is drawn until the next one
+            Aabb update_bounds;
+            Aabb bounds;
+
+            InstanceLodState();
+        };
+
+        friend class CrowdPoseTask;
+        friend class CrowdSkinTask;
+        friend class CrowdPlaceTask;
+
+        void Clear();
+        bool LoadPlacement(const std::string& filename);
+        void SelectLods(int skin_output, Vector3 camera_position);
+        void ResizeLodBuffers(int i, int skin_output);
+        void GroupUpdates();
+        int NumGroups();
+        const LodLevel& NodeLevel(int i, int level);
+        void CollectWork(int chunk_size);
+        void CullInterpolated(int i);
+        bool CountWork(int i);
+        void AddWork(int i, int chunk_size);
+        void SetDrawBuffers();
+
+        const AnimationSet* m_assets;
+        std::vector<CharacterContext*> m_instances;
+        std::vector<Vector3> m_positions;
+        std::vector<float> m_headings;
+        std::vector<Matrix_4x4> m_world;
+        const Frustum* m_frustum;
+        //one per pool worker, for local blending. Made by the worker itself, on its node
+        std::vector<PoseBatch*> m_batches;
+
+        int m_num_nodes;
+        bool m_lod_enabled;
+        LodSet m_lods;
+        //copies of m_lods by node if assets are replicated
+        std::vector<LodSet*> m_node_lods;
+        std::vector<InstanceLodState> m_lod_states;
+        float m_last_advance;
+
+        //of the current frame: instances to pose, vertex ranges to skin or interpolate
+        struct WorkItem {
+            int instance;
+            int begin;
+            int end;
+        };
+        std::vector<int> m_updates;
+        //where every pose group starts in m_updates, and the end
+        std::vector<int> m_group_first;
+        std::vector<int> m_node_updates;
+        std::vector<WorkItem> m_items;
+        std::vector<CrowdLodStats> m_stats;
+        //Evaluate with a JobSystem: the graph and the pose group job of every updated instance
+        JobGraph m_graph;
+        std::vector<int> m_pose_jobs;
+};
+
+#endif
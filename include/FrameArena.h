@@ -0,0 +1,88 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <vector>
+
+/*
+ * Linear allocator for data which lives for one frame only. Allocation bumps an offset in one
+ * contiguous block and Reset at the start of the next frame releases everything at once.
+ * A frame which doesn't fit is served from separate blocks and the next Reset grows the block
+ * to the size of that frame, so after the first frames nothing touches the heap.
+ * Nothing is destructed, so only plain data (floats, vectors, matrices) belongs here.
+ */
+class FrameArena {
+
+    public:
+        FrameArena(size_t capacity = 0);
+        ~FrameArena();
+
+        //forget everything allocated since the last Reset
+        void Reset();
+
+        //alignment - power of two
+        void* Allocate(size_t bytes, size_t alignment = 16);
+
+        template <typename T>
+        T* AllocArray(int count) {
+            T* array = (T*)Allocate(sizeof(T) * count);
+            for (int i = 0; i < count; i++) {
+                new (&array[i]) T;
+            }
+            return array;
+        }
+
+        //bytes allocated since the last Reset
+        size_t Used();
+        size_t Capacity();
+        //largest frame so far
+        size_t HighWater();
+
+    private:
+        FrameArena(const FrameArena&);
+        FrameArena& operator=(const FrameArena&);
+
+        char* m_block;
+        size_t m_capacity;
+        size_t m_used;
+
+        //blocks of the current frame which didn't fit
+        std::vector<char*> m_overflow;
+        size_t m_overflow_bytes;
+        size_t m_high_water;
+};
+
+/*
+ * One FrameArena per worker of a WorkerPool, indexed by the worker_id passed to RangeTask::Run,
+ * so threads allocate without any synchronisation. Reset from one thread between parallel loops.
+ */
+class WorkerArenas {
+
+    public:
+        WorkerArenas(int num_workers);
+        ~WorkerArenas();
+
+        int NumWorkers();
+        FrameArena& Get(int worker_id);
+
+        void Reset();
+        //sum over the workers
+        size_t HighWater();
+
+    private:
+        WorkerArenas(const WorkerArenas&);
+        WorkerArenas& operator=(const WorkerArenas&);
+
+        //padded, so bump offsets of different workers don't share a cache line
+        struct PaddedArena {
+            FrameArena arena;
+            char padding[64];
+        };
+
+        std::vector<PaddedArena*> m_arenas;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef FRAME_FENCE_H
+#define FRAME_FENCE_H
+
+#pragma once
+
+#include <pthread.h>
+
+/*
+ * Completion counter between threads: one side calls Signal(n) when everything up to n is done,
+ * the other checks or waits for the value it needs. Nobody joins anybody, a waiting thread
+ * spins for a moment and then sleeps until the value is reached.
+ */
+class FrameFence {
+
+    public:
+        FrameFence();
+        ~FrameFence();
+
+        //values never go back, a smaller one is ignored
+        void Signal(int value);
+        int Value();
+        bool Reached(int value);
+
+        //returns when the fence reached value, false if it was cancelled instead
+        bool Wait(int value);
+
+        //every Wait returns false until Reset, for shutting down the waiting thread
+        void Cancel();
+        void Reset(int value = 0);
+
+    private:
+        FrameFence(const FrameFence&);
+        FrameFence& operator=(const FrameFence&);
+
+        volatile int m_value;
+        volatile int m_cancelled;
+
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_cond;
+        //protected by m_mutex, Signal only takes it when somebody sleeps
+        int m_num_sleeping;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#pragma once
+
+/*
+ * When the next frame of the viewer is due at a target rate. A deadline is one period after the
+ * previous deadline, not after the previous frame, so the rate doesn't drift with how long a
+ * frame takes. A frame later than a whole period starts the schedule over from now instead of
+ * rushing to catch up. With vsync the buffer swap waits for the display itself, so the pacer
+ * lets frames start a bit before their deadline and the swap still makes the refresh meant.
+ */
+class FramePacer {
+
+    public:
+        //60 frames per second without vsync
+        FramePacer();
+
+        //frames per second, 0 or less for as fast as frames come
+        void SetTargetRate(double rate);
+        double TargetRate() const;
+        void SetVsync(bool vsync);
+        bool Vsync() const;
+
+        //a frame starts at now (TimeSeconds), the next one is due a period later
+        void FrameStarted(double now);
+        //seconds from now until the next frame is due, 0 if it is
+        double Delay(double now) const;
+        //sleeps the calling thread until the next frame is due
+        void SleepUntilDue() const;
+
+    private:
+        double m_period;
+        bool m_vsync;
+        //deadline of the next frame, before the first one nothing waits
+        double m_next;
+};
+
+#endif
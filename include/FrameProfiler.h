@@ -0,0 +1,98 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Timer.h"
+#include "Trace.h"
+
+//stages of one frame, in the order they happen
+enum {
+    STAGE_UPDATE = 0,  //time update in the idle callback
+    STAGE_POSE,        //pose evaluation, skeleton drawing included
+    STAGE_SKINNING,    //vertex skinning
+    STAGE_BUFFERS,     //vertex/index buffers setup
+    STAGE_SUBMIT,      //GL submission of the mesh
+    STAGE_SWAP,        //buffers swap
+    NUM_FRAME_STAGES
+};
+
+/*
+ * Per stage frame times. Keeps rolling statistics over the last frames for display
+ * and a log of every frame which can be written out as CSV or JSON.
+ */
+class FrameProfiler {
+
+    public:
+        FrameProfiler();
+
+        static const char* StageName(int stage);
+
+        void AddStageTime(int stage, double seconds);
+        //closes current frame, everything added afterwards goes to the next one
+        void EndFrame();
+
+        //statistics over the rolling window, in seconds. Stage NUM_FRAME_STAGES is the whole frame
+        double Min(int stage);
+        double Avg(int stage);
+        double P99(int stage);
+
+        //one line per stage, for the overlay
+        std::vector<std::string> SummaryLines();
+
+        //.json extension writes JSON, anything else CSV. Returns false if the file can't be written
+        bool WriteLog(std::string filename);
+
+        //number of frames in the rolling window
+        static const int WINDOW = 300;
+        //frames kept in the log, later frames only go into the rolling window
+        static const int MAX_LOGGED_FRAMES = 1000000;
+
+    private:
+        //stage times of one frame, last one is the sum
+        struct FrameTimes {
+            float stages[NUM_FRAME_STAGES + 1];
+        };
+
+        FrameTimes m_current;
+        double m_frame_start;
+
+        std::vector<FrameTimes> m_window;
+        int m_window_next;
+
+        std::vector<FrameTimes> m_log;
+
+        //so percentiles don't allocate every frame
+        std::vector<float> m_scratch;
+};
+
+FrameProfiler& GlobalFrameProfiler();
+
+//adds its lifetime to the stage of the global profiler
+class ScopedStageTimer {
+    public:
+        ScopedStageTimer(int stage) : m_stage(stage), m_start(TimeSeconds()) {}
+        ~ScopedStageTimer() { GlobalFrameProfiler().AddStageTime(m_stage, TimeSeconds() - m_start); }
+    private:
+        int m_stage;
+        double m_start;
+};
+
+/* Build with -DSKIN_PROFILE (make PROFILE=1) to enable, otherwise the macros are empty */
+#ifdef SKIN_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_STAGE_TIMER(stage) ScopedStageTimer PROFILE_CONCAT(stage_timer_, __LINE__)(stage)
+#define PROFILE_END_FRAME() GlobalFrameProfiler().EndFrame()
+#else
+#define PROFILE_STAGE_TIMER(stage)
+#define PROFILE_END_FRAME()
+#endif
+
+//stages also show up on the trace timeline when tracing is compiled in
+#define PROFILE_STAGE(stage) PROFILE_STAGE_TIMER(stage); TRACE_SCOPE(FrameProfiler::StageName(stage))
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#pragma once
+
+#include "Vector.h"
+#include "Camera.h"
+#include "Bounds.h"
+
+/*
+ * View volume of a camera as six planes with normals pointing inside.
+ * Camera fov is the vertical field of view in radians, as gluPerspective uses it.
+ */
+class Frustum {
+
+    public:
+        //aspect - width / height of the viewport
+        Frustum(Camera& camera, float aspect);
+
+        //false only if the box is completely outside one plane, so it can keep boxes
+        //which are outside near a corner, never drops a visible one
+        bool Intersects(const Aabb& box) const;
+        bool Intersects(Vector3 center, float radius) const;
+
+    private:
+        //xyz - normal, w - offset, inside where Dot(normal, p) + w >= 0
+        Vector4 m_planes[6];
+};
+
+#endif
@@ -26,11 +26,11 @@ class Mesh {
         Mesh();
         ~Mesh();
         
-        int NumVertices();
-        int NumTriangles();
+        int NumVertices() const;
+        int NumTriangles() const;
         
-        int GetIndex(int i);
-        Vertex GetVertex(int i);
+        int GetIndex(int i) const;
+        Vertex GetVertex(int i) const;
         
         Vertex* m_vertices;
         int* m_triangles;
@@ -0,0 +1,152 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#pragma once
+
+#include <pthread.h>
+#include <vector>
+
+#include "WorkerPool.h"
+#include "Numa.h"
+
+/*
+ * Jobs of one run and what they wait for. A job is one RangeTask::Run call over [begin, end),
+ * it starts once every job it depends on is done. Cleared and refilled every frame, after the
+ * first frames adding jobs doesn't allocate.
+ */
+class JobGraph {
+
+    public:
+        JobGraph();
+
+        void Clear();
+
+        //id of the new job. A job of a node (modulo JobSystem::NumNodes()) only runs on workers of that
+        //node, so what it touches first is placed there, -1 runs anywhere
+        int Add(RangeTask* task, int begin, int end, int node = -1);
+        //job doesn't start before the job before is done, before has to be added first
+        void Depend(int job, int before);
+
+        int NumJobs() const;
+
+    private:
+        friend class JobSystem;
+
+        struct Job {
+            RangeTask* task;
+            int begin;
+            int end;
+            int node;
+            int num_dependencies;
+        };
+
+        struct Edge {
+            int before;
+            int job;
+        };
+
+        std::vector<Job> m_jobs;
+        std::vector<Edge> m_edges;
+};
+
+//what one worker did since JobSystem::ResetStats
+struct JobWorkerStats {
+    int jobs;
+    //jobs taken from the queue of another worker
+    int steals;
+    //inside jobs
+    double busy_seconds;
+
+    JobWorkerStats();
+};
+
+/*
+ * Work stealing scheduler. Every worker has a queue of jobs which are ready to run: it takes
+ * the newest of its own (likely still in cache) and, when it runs dry, steals the oldest from
+ * another worker. A finished job releases the jobs depending on it into the queue of the worker
+ * which finished it. The calling thread takes part as worker 0, so one thread runs everything inline.
+ * With a NumaTopology of several nodes workers are spread over the nodes and pinned to them
+ * (worker 0 to node 0 once it runs a graph), jobs of a node start on its workers and are only
+ * stolen by workers of the same node. Jobs without a node are stolen across nodes as well.
+ */
+class JobSystem {
+
+    public:
+        JobSystem(int num_threads, const NumaTopology* numa = NULL);
+        ~JobSystem();
+
+        int NumThreads();
+        //nodes with workers on them, 1 without a topology
+        int NumNodes();
+        int WorkerNode(int worker_id);
+
+        //runs every job of graph in an order the dependencies allow, returns when all are done
+        void Run(JobGraph& graph);
+
+        //independent jobs over [0, count) in chunks of chunk_size, as WorkerPool::ParallelFor
+        void ParallelFor(int count, int chunk_size, RangeTask* task);
+
+        //counters since the last ResetStats, read them between runs
+        JobWorkerStats WorkerStats(int worker_id);
+        //wall time spent in Run since the last ResetStats
+        double RunSeconds();
+        //busy time of the worker over RunSeconds, between 0 and 1
+        double Utilization(int worker_id);
+        void ResetStats();
+
+    private:
+        JobSystem(const JobSystem&);
+        JobSystem& operator=(const JobSystem&);
+
+        //ready jobs of one worker, the owner pushes and pops at the bottom, thieves take from the
+        //top. Every job is pushed once per run, so there is no wrap around
+        struct WorkerQueue {
+            std::vector<int> jobs;
+            int top;
+            int bottom;
+            volatile int lock;
+            JobWorkerStats stats;
+            //queues of different workers don't share a cache line
+            char padding[64];
+        };
+
+        static void* ThreadMain(void* arg);
+        void Work(int worker_id);
+        void Execute(int job, int worker_id);
+        void Push(int worker_id, int job);
+        bool Pop(int worker_id, int& job);
+        bool Steal(int worker_id, int& job);
+
+        std::vector<pthread_t> m_threads;
+        int m_num_threads;
+        std::vector<WorkerQueue*> m_queues;
+
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_start_cond;
+        pthread_cond_t m_done_cond;
+        int m_generation;
+        int m_num_working;
+        bool m_quit;
+
+        //node of every worker, the workers and cpus of every node
+        int m_num_nodes;
+        std::vector<int> m_worker_nodes;
+        std::vector<std::vector<int> > m_node_workers;
+        std::vector<std::vector<int> > m_node_cpus;
+        std::vector<int> m_next_worker;
+        bool m_caller_pinned;
+        pthread_t m_caller;
+
+        //current run: the graph, successors of every job and how many of its dependencies are left
+        JobGraph* m_graph;
+        std::vector<int> m_first_successor;
+        std::vector<int> m_successors;
+        std::vector<int> m_remaining;
+        volatile int m_num_done;
+
+        //for ParallelFor
+        JobGraph m_loop;
+        double m_run_seconds;
+};
+
+#endif
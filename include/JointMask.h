@@ -0,0 +1,54 @@
+#ifndef JOINT_MASK_H
+#define JOINT_MASK_H
+
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "Geometry.h"
+#include "SkeletonTopology.h"
+
+/*
+ * Joints of a rig something depends on, together with all of their ancestors, so a pose
+ * evaluated only for the required joints composes exactly as the full one does for them.
+ * Pose evaluation, blending and palettes skip the rest (props, finger tips, helpers).
+ */
+class JointMask {
+
+    public:
+        JointMask();
+
+        //all - every joint required, otherwise none
+        void Reset(const SkeletonTopology* topology, bool all = false);
+
+        //the joint and every ancestor of it
+        void Require(int joint_id);
+
+        const SkeletonTopology* Topology() const;
+        int NumJoints() const;
+        int NumRequired() const;
+        bool Required(int joint_id) const;
+
+        //required joints, parents before children
+        const std::vector<int>& Order() const;
+        //required joints as [first, second) runs of consecutive ids, for loops over joint arrays
+        const std::vector<std::pair<int, int> >& Ranges() const;
+
+    private:
+        void Update();
+
+        const SkeletonTopology* m_topology;
+        std::vector<bool> m_required;
+        std::vector<int> m_order;
+        std::vector<std::pair<int, int> > m_ranges;
+};
+
+//joints skinning reads for the mesh: every influence slot of every vertex, zero weights included,
+//as skinning multiplies their palette entries too
+void RequireSkinnedJoints(JointMask& mask, const Mesh* mesh);
+//joints the skeleton view draws and the walk/run distances (ComputeDistSkel) compare: every joint
+//of the rig
+void RequireSkeletonJoints(JointMask& mask);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef LINEAR_BLENDING_H
+#define LINEAR_BLENDING_H
+
+#pragma once
+
+#include <vector>
+
+#include "Matrix.h"
+#include "Geometry.h"
+#include "WorkerPool.h"
+#include "JointMask.h"
+
+//What the skinning has to produce. Normals are only needed for lighting,
+//so position only outputs (depth passes, silhouettes, exports) skip them entirely
+enum {
+    SKIN_OUTPUT_POSITIONS = 1,
+    SKIN_OUTPUT_NORMALS   = 2,
+    SKIN_OUTPUT_ALL       = SKIN_OUTPUT_POSITIONS | SKIN_OUTPUT_NORMALS
+};
+
+//two frames of two clips (time interpolation of walk/run mixture)
+static const int MAX_SKIN_POSES = 4;
+
+/*
+ * Poses (global joint transforms per joint) to skin with and their weights in the final mix.
+ * Weights must sum to one. Skinning with several poses gives the same result as skinning
+ * with each pose separately and interpolating the vertices.
+ */
+struct SkinPoses {
+    const std::vector<Matrix_4x4>* trans_gb[MAX_SKIN_POSES];
+    float weights[MAX_SKIN_POSES];
+    int num_poses;
+
+    SkinPoses();
+    //poses with zero weight are not added at all
+    void Add(const std::vector<Matrix_4x4>* trans_gb, float weight);
+};
+
+Vector3 NormSumToOne(Vector3 v);
+
+//output - combination of SKIN_OUTPUT_* flags, fields which are not requested are left zero
+Vertex LinearBlending(const Vertex& original, const std::vector<Matrix_4x4>& anim_trans_gb, const std::vector<Matrix_4x4>& rest_trans_lc, int output);
+
+/*
+ * Skin every vertex of the mesh. Arrays are xyz per vertex,
+ * normals can be NULL if output doesn't contain SKIN_OUTPUT_NORMALS
+ */
+void SkinMesh(const Mesh* mesh, const std::vector<Matrix_4x4>& rest_trans_lc, const SkinPoses& poses, int output,
+              float* positions, float* normals);
+
+//SkinMesh of vertices [begin, end) only
+void SkinMeshRange(const Mesh* mesh, const std::vector<Matrix_4x4>& rest_trans_lc, const SkinPoses& poses, int output,
+                   float* positions, float* normals, int begin, int end);
+
+//SkinMesh split across the pool threads in chunks of chunk_size vertices
+void SkinMeshParallel(WorkerPool& pool, int chunk_size,
+                      const Mesh* mesh, const std::vector<Matrix_4x4>& rest_trans_lc, const SkinPoses& poses, int output,
+                      float* positions, float* normals);
+
+/*
+ * Skinning matrices (pose global transform times rest local transform) of every joint blended
+ * over the poses. Skinning is linear in them, so skinning with the palette gives the same result
+ * as SkinMesh with the poses, but every influence is transformed once instead of once per pose.
+ * palette must hold rest_trans_lc.size() matrices. With a mask only the required joints are
+ * written, the mesh must not reference any other (see RequireSkinnedJoints).
+ */
+void ComputeSkinPalette(const SkinPoses& poses, const std::vector<Matrix_4x4>& rest_trans_lc, Matrix_4x4* palette,
+                        const JointMask* mask = NULL);
+
+//SkinMesh with a palette from ComputeSkinPalette
+void SkinMeshPalette(const Mesh* mesh, const Matrix_4x4* palette, int output, float* positions, float* normals);
+
+//vertices [begin, end) only, written from the start of positions and normals,
+//so a chunk can be skinned into a buffer of its own.
+//num_influences - how many of the 3 weights of a vertex are used, for meshes from ReduceInfluences
+void SkinMeshPaletteRange(const Mesh* mesh, const Matrix_4x4* palette, int output,
+                          float* positions, float* normals, int begin, int end, int num_influences = 3);
+
+#endif
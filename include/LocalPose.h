@@ -0,0 +1,60 @@
+#ifndef LOCAL_POSE_H
+#define LOCAL_POSE_H
+
+#pragma once
+
+#include <vector>
+
+#include "Matrix.h"
+#include "Skeleton.h"
+#include "LinearBlending.h"
+#include "JointMask.h"
+
+/*
+ * Local transforms of every joint of one skeleton as translations and unit quaternions,
+ * structure of arrays with the joint as the index, so whole poses are blended by
+ * loops over joints the compiler vectorizes.
+ */
+class LocalPose {
+
+    public:
+        LocalPose();
+
+        int NumJoints() const;
+        void Resize(int num_joints);
+
+        //rotations of skel are turned into quaternions
+        void FromSkeleton(const Skeleton* skel);
+
+        //Translation(t) * rotation of the joint, same as Skeleton::LocalTransform up to rounding
+        Matrix_4x4 LocalTransform(int joint_id) const;
+
+        std::vector<float> tx, ty, tz;
+        std::vector<float> qx, qy, qz, qw;
+};
+
+//up to MAX_SKIN_POSES weighted local poses of one rig, weights sum to 1
+struct LocalPoses {
+    const LocalPose* poses[MAX_SKIN_POSES];
+    float weights[MAX_SKIN_POSES];
+    int num_poses;
+
+    LocalPoses();
+    //poses with zero weight are not added at all
+    void Add(const LocalPose* pose, float weight);
+};
+
+/*
+ * Blends all poses in one pass over the joints: translations are lerped, rotations nlerped.
+ * Every quaternion is flipped into the hemisphere of the first pose before it is summed,
+ * so q and -q (the same rotation) don't cancel out. out is resized to the rig.
+ * With a mask only runs of required joints are blended, the others are left as they are.
+ * With a topology the children of roots are blended in model space and then put back under
+ * the blended root: clips can turn a root by half a turn which its children undo (walk and run
+ * do), their locals are then far apart although the joints are in the same place, and nlerped
+ * locals would flip everything below.
+ */
+void BlendLocalPoses(const LocalPoses& poses, LocalPose& out, const JointMask* mask = NULL,
+                     const SkeletonTopology* topology = NULL);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef LOD_H
+#define LOD_H
+
+#pragma once
+
+#include <vector>
+
+#include "Geometry.h"
+
+/*
+ * Level of detail of a character by distance to the camera. Far levels skin a mesh with
+ * fewer influences or fewer vertices, and update their animation only every few frames
+ * (in between skinned results are interpolated), so cost follows on screen detail.
+ */
+struct LodLevel {
+    //from this distance to the camera on
+    float min_distance;
+    //not owned by the level
+    const Mesh* mesh;
+    //weights per vertex used in skinning, 1 to 3
+    int num_influences;
+    //frames between pose and skin updates, 1 - every frame
+    int update_interval;
+};
+
+struct LodConfig {
+    //where levels 1 and 2 start
+    float distances[2];
+    int influences[3];
+    int update_intervals[3];
+    //cells of the decimation grid of the last level along the longest side of the mesh
+    int decimation_cells;
+
+    LodConfig();
+};
+
+//levels built from one character, ordered by distance
+class LodSet {
+
+    public:
+        LodSet();
+        ~LodSet();
+
+        //full mesh, the full mesh with fewer influences and a decimated mesh with fewest.
+        //copy_full - every level is a copy owned by the set, none is shared with character or built.
+        //built - levels made at asset load, their meshes are taken (or copied) instead of reducing
+        //and decimating again if they come from the same character, influences and cells
+        void Build(const Mesh* character, const LodConfig& config, bool copy_full = false,
+                   const LodSet* built = NULL);
+
+        int NumLevels() const;
+        const LodLevel& Level(int level) const;
+        int Select(float distance) const;
+
+    private:
+        LodSet(const LodSet&);
+        LodSet& operator=(const LodSet&);
+
+        void Clear();
+        //level mesh of built if it has the one asked for, NULL otherwise
+        const Mesh* BuiltMesh(const LodSet* built, int level, int num_influences, int cells) const;
+        //mesh owned by the set, copied from mesh or made by it
+        const Mesh* Own(Mesh* mesh);
+
+        std::vector<LodLevel> m_levels;
+        std::vector<Mesh*> m_meshes;
+        //what the level meshes were made from
+        const Mesh* m_character;
+        int m_influences[3];
+        int m_decimation_cells;
+};
+
+Mesh* CopyMesh(const Mesh* mesh);
+
+//copy of the mesh keeping the num_influences biggest weights of every vertex first,
+//renormalized to sum to one, the rest zero
+Mesh* ReduceInfluences(const Mesh* mesh, int num_influences);
+
+//vertex clustering: vertices in one cell of a cells^3 grid over the bounds merge into the one
+//closest to their average, which keeps its normal and weights. Collapsed triangles are dropped
+Mesh* DecimateMesh(const Mesh* mesh, int cells);
+
+#endif
@@ -22,8 +22,8 @@ class Matrix_2x2 {
         
         static void Print(Matrix_2x2 m);
         
-        Matrix_2x2 operator*(Matrix_2x2 m);
-        Vector2 operator*(Vector2 v);
+        Matrix_2x2 operator*(Matrix_2x2 m) const;
+        Vector2 operator*(Vector2 v) const;
 };
 
 class Matrix_3x3 {
@@ -52,8 +52,8 @@ class Matrix_3x3 {
         
         static void Print(Matrix_3x3 m);
         
-        Matrix_3x3 operator*(Matrix_3x3 m);
-        Vector3 operator*(Vector3 v);
+        Matrix_3x3 operator*(Matrix_3x3 m) const;
+        Vector3 operator*(Vector3 v) const;
 };
 
 class Matrix_4x4 {
@@ -96,13 +96,13 @@ class Matrix_4x4 {
         
         static void Print(Matrix_4x4 m);
         
-        Matrix_4x4 operator*(Matrix_4x4 m);
-        Matrix_4x4 operator*(Matrix_3x3 m);
-        Vector4 operator*(Vector4 v);
-        Vector3 operator*(Vector3 v);
+        Matrix_4x4 operator*(Matrix_4x4 m) const;
+        Matrix_4x4 operator*(Matrix_3x3 m) const;
+        Vector4 operator*(Vector4 v) const;
+        Vector3 operator*(Vector3 v) const;
         
-        Matrix_4x4 operator*(float fac);
-        Matrix_4x4 operator+(Matrix_4x4 m);
+        Matrix_4x4 operator*(float fac) const;
+        Matrix_4x4 operator+(Matrix_4x4 m) const;
 };
 
 #endif
\ No newline at end of file
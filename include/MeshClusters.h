@@ -0,0 +1,105 @@
+#ifndef MESH_CLUSTERS_H
+#define MESH_CLUSTERS_H
+
+#pragma once
+
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "Geometry.h"
+#include "Frustum.h"
+
+/*
+ * Patch of up to max_triangles triangles. Triangles of a cluster share the joint with most
+ * weight on them, bounds and normal cone are posed with the palette of that joint.
+ * Every vertex belongs to the first cluster using it, later clusters borrow it.
+ */
+struct MeshCluster {
+    //ranges in the clustered mesh, vertices are the ones the cluster owns
+    int first_vertex;
+    int num_vertices;
+    int first_triangle;
+    int num_triangles;
+    //into the borrowed vertex list
+    int first_borrowed;
+    int num_borrowed;
+
+    int dominant_joint;
+    //joints with weight on the vertices, with a sphere around the rest vertices of each
+    int first_joint;
+    int num_joints;
+
+    //rest pose, mesh space. Every face normal is within the cone, cone_cos <= 0 if it
+    //opens to a half space or more and can't face away as a whole
+    Vector3 cone_axis;
+    float cone_cos;
+};
+
+//consecutive clusters which survived culling, skinned and drawn as one range
+struct ClusterRun {
+    int first_vertex;
+    int num_vertices;
+    int first_triangle;
+    int num_triangles;
+};
+
+//what survived culling, arrays provided by the caller (see MeshClusters::Cull)
+struct ClusterSelection {
+    ClusterRun* runs;
+    int num_runs;
+    //vertices of dropped clusters the triangles of kept ones use, skinned one by one
+    int* borrowed;
+    int num_borrowed;
+};
+
+struct ClusterCullStats {
+    int visible;
+    int outside;
+    int back_facing;
+    int skinned_vertices;
+    int drawn_triangles;
+
+    ClusterCullStats();
+};
+
+class MeshClusters {
+
+    public:
+        MeshClusters();
+        ~MeshClusters();
+
+        //splits the triangles of every dominant joint in halves along the widest of position and
+        //normal direction until they fit in max_triangles
+        void Build(const Mesh* mesh, int num_joints, int max_triangles = 128);
+
+        //the mesh with vertices reordered by cluster and triangles indexing them
+        const Mesh* ClusteredMesh() const;
+        int NumClusters() const;
+        const MeshCluster& Cluster(int i) const;
+        //room the borrowed list of a selection needs
+        int NumBorrowed() const;
+
+        /*
+         * Bounds of every cluster posed with the palette against the view: clusters outside of
+         * the frustum or with every face turned away from eye (mesh space, as the frustum) are
+         * dropped, the rest merged into runs. selection.runs needs room for NumClusters() and
+         * selection.borrowed for NumBorrowed(). A vertex can be borrowed by several clusters and
+         * listed more than once. The palette is expected rigid, as the skinning palettes are.
+         */
+        void Cull(const Matrix_4x4* palette, const Frustum& frustum, Vector3 eye,
+                  ClusterSelection& selection, ClusterCullStats* stats = NULL) const;
+
+    private:
+        MeshClusters(const MeshClusters&);
+        MeshClusters& operator=(const MeshClusters&);
+
+        Mesh* m_mesh;
+        std::vector<MeshCluster> m_clusters;
+        std::vector<int> m_borrowed;
+        std::vector<int> m_joint_ids;
+        std::vector<Vector3> m_joint_centers;
+        std::vector<float> m_joint_radii;
+};
+
+#endif
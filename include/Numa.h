@@ -0,0 +1,48 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "WorkerPool.h"
+
+/*
+ * Memory nodes of the machine and the CPUs of each. Memory is placed on the node of the thread
+ * which touches it first, so buffers used by threads pinned to one node should be first touched
+ * there. Without /sys/devices/system/node (not Linux) or with one node it is a single node with
+ * every CPU, and whoever uses it needs no special case.
+ */
+class NumaTopology {
+
+    public:
+        //single node with every hardware thread
+        NumaTopology();
+
+        //nodes with CPUs from sysfs, a single node if there is nothing to read
+        void Detect();
+        //splits the CPUs over num_nodes nodes as if there were that many, to try sharding on one socket.
+        //Memory still lands wherever the system puts it
+        void Emulate(int num_nodes);
+
+        int NumNodes() const;
+        const std::vector<int>& Cpus(int node) const;
+        //"2 nodes: 0-7 8-15"
+        std::string Describe() const;
+
+    private:
+        std::vector<std::vector<int> > m_cpus;
+};
+
+//binds the calling thread to cpus, false where that isn't supported
+bool PinThread(const std::vector<int>& cpus);
+
+//runs task over [begin, end) on a thread pinned to node and waits for it, as worker 0. What it
+//allocates and writes first is placed on that node. False without running the task if no thread
+//could be pinned there
+bool RunOnNode(const NumaTopology& numa, int node, RangeTask* task, int begin, int end);
+//whether threads can be pinned to every node, tried on a short lived thread per node
+bool CanPinThreads(const NumaTopology& numa);
+
+#endif
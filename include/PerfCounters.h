@@ -0,0 +1,49 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#pragma once
+
+enum {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    NUM_PERF_COUNTERS
+};
+
+/*
+ * Hardware performance counters of the calling thread (Linux perf_event_open).
+ * Counts accumulate over every Start/Stop window. Counters the kernel or the CPU refuse
+ * (perf_event_paranoid, virtual machines, other platforms) are simply not available,
+ * everything else keeps working.
+ */
+class PerfCounters {
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+
+        //returns false if no counter could be opened, reason is in Error()
+        bool Open();
+        const char* Error();
+
+        bool Available(int counter);
+
+        void Start();
+        void Stop();
+
+        //count over all windows, scaled if the kernel had to multiplex counters
+        double Value(int counter);
+
+        static const char* Name(int counter);
+
+    private:
+        PerfCounters(const PerfCounters&);
+        PerfCounters& operator=(const PerfCounters&);
+
+        int m_fds[NUM_PERF_COUNTERS];
+        const char* m_error;
+};
+
+#endif
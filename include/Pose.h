@@ -0,0 +1,41 @@
+#ifndef POSE_H
+#define POSE_H
+
+#pragma once
+
+#include <vector>
+
+#include "Matrix.h"
+#include "Skeleton.h"
+#include "Animation.h"
+#include "LocalPose.h"
+#include "JointMask.h"
+
+/*
+ *Compute joint transformations in advance to save CPU
+ *gb - global frame
+ *lc - local frame
+ *tpf - transforms per frame
+ *we need  local only for rest pose
+ *mask - only its required joints are computed, NULL for all
+ */
+
+//global transforms of every joint of one skeleton
+void ComputeTransGB(std::vector<Matrix_4x4>& trans_gb, const Skeleton* skel);
+
+//global transforms of a blended local pose of the rig
+void ComputeTransGB(std::vector<Matrix_4x4>& trans_gb, const SkeletonTopology* topology, const LocalPose& pose,
+                    const JointMask* mask = NULL);
+
+//global transforms of every joint for every frame of the animation
+//joints which aren't required are left identities
+void ComputeTransPerFrameGB(std::vector<std::vector<Matrix_4x4> >& trans_per_frame_gb, const Animation* anim,
+                            const JointMask* mask = NULL);
+
+//translations and quaternions of every frame of the animation
+void ComputeLocalPoses(std::vector<LocalPose>& local_poses, const Animation* anim);
+
+//inverse of the rest pose global transforms
+void ComputeRestTransLC(std::vector<Matrix_4x4>& rest_trans_lc, const Skeleton* rest_skel);
+
+#endif
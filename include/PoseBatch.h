@@ -0,0 +1,63 @@
+#ifndef POSE_BATCH_H
+#define POSE_BATCH_H
+
+#pragma once
+
+#include <vector>
+
+#include "Matrix.h"
+#include "Skeleton.h"
+#include "SkeletonTopology.h"
+#include "LocalPose.h"
+#include "JointMask.h"
+
+//instances composed by one pass, 8 fills two SSE or one AVX register, 16 one AVX-512 register
+#ifndef SKIN_POSE_LANES
+#define SKIN_POSE_LANES 8
+#endif
+
+//affine transform (top 3 rows of a Matrix_4x4, row major) of one joint in every lane
+struct TransformLanes {
+    float m[12][SKIN_POSE_LANES];
+};
+
+/*
+ * Local to global composition of up to SKIN_POSE_LANES skeletons of one topology at once.
+ * Joints of one skeleton depend on each other, the same joint of different skeletons doesn't,
+ * so the data is structure of arrays with the instance as the inner index: every joint is
+ * composed with its parent in all lanes by straight line loops the compiler vectorizes.
+ * The bottom row of every transform is taken as (0, 0, 0, 1).
+ * With a mask only its required joints are set, composed and read back.
+ */
+class PoseBatch {
+
+    public:
+        //mask - of the same topology, not owned, NULL for every joint
+        PoseBatch(const SkeletonTopology* topology, const JointMask* mask = NULL);
+
+        const SkeletonTopology* Topology() const;
+        int NumJoints() const;
+
+        void SetLocal(int lane, int joint_id, const Matrix_4x4& local);
+        //local transforms of every joint of skel, which has to share the topology
+        void SetLocal(int lane, const Skeleton* skel);
+        void SetLocal(int lane, const LocalPose& pose);
+
+        //global transforms of every joint in every lane, parents before children
+        void Compose();
+
+        Matrix_4x4 Global(int lane, int joint_id) const;
+        //joints which aren't required are identities in trans_gb when it grows
+        void GetGlobal(int lane, std::vector<Matrix_4x4>& trans_gb) const;
+
+    private:
+        //every joint or the required ones, parents before children
+        const std::vector<int>& Order() const;
+
+        const SkeletonTopology* m_topology;
+        const JointMask* m_mask;
+        std::vector<TransformLanes> m_local;
+        std::vector<TransformLanes> m_global;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef SMD_LOADER_H
+#define SMD_LOADER_H
+
+#pragma once
+
+#include <string>
+
+#include "Geometry.h"
+#include "Animation.h"
+
+enum {
+    SMD_STATE_EMPTY = 0,
+    SMD_STATE_MESH  = 1,
+    SMD_STATE_NODES = 2,
+    SMD_STATE_SKEL  = 3
+};
+
+/* Both loaders exit the process if the file can't be read */
+//frames are allocated from pool if given (see Animation)
+void LoadSMDAnimation(std::string filename, Animation** animation, SkeletonPool* pool = NULL);
+void LoadSMDCharacter(std::string filename, Mesh** character);
+
+#endif
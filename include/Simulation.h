@@ -0,0 +1,205 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#pragma once
+
+#include <pthread.h>
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+#include "Geometry.h"
+#include "Camera.h"
+#include "AnimationSet.h"
+#include "CharacterContext.h"
+#include "Crowd.h"
+#include "MeshClusters.h"
+#include "JobSystem.h"
+#include "FrameProfiler.h"
+#include "FrameFence.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+//what the input thread asks the simulation to change
+enum {
+    SIM_CLIP = 0,              //value - CLIP_RUN, CLIP_WALK or CLIP_MIX
+    SIM_CHANGE_FRAMES,         //value - step of the selected frame in frame mode, of the speed otherwise
+    SIM_TOGGLE_INTERPOLATION,
+    SIM_TOGGLE_LOCAL_BLEND,
+    SIM_TOGGLE_FRAME_MODE,
+    SIM_CHANGE_MIX,            //amount - added to the walk/run mix rate
+    SIM_DISPLAY                //value - SIM_SHOW_* flags, what frames are made of
+};
+
+enum {
+    SIM_SHOW_MESH = 1,
+    SIM_SHOW_SKELETON = 2,
+    //skin normals as well, for lighting
+    SIM_SHOW_NORMALS = 4,
+    //skin and draw only the clusters of the character which may be visible (see MeshClusters)
+    SIM_CULL_CLUSTERS = 8
+};
+
+struct SimCommand {
+    int type;
+    int value;
+    float amount;
+
+    SimCommand(int type = SIM_DISPLAY, int value = 0, float amount = 0.0f);
+};
+
+//one character of a frame, drawn at position turned by heading (degrees around y)
+struct SimDrawItem {
+    Vector3 position;
+    float heading;
+    //triangles of mesh index the vertices from first_vertex of the frame buffers
+    const Mesh* mesh;
+    int first_vertex;
+    //false if there are no normals of it in SimFrame::normals
+    bool has_normals;
+    //triangle ranges of mesh to draw, in SimFrame::ranges
+    int first_range;
+    int num_ranges;
+    //bones as pairs of line vertices in SimFrame::lines, joint axes in SimFrame::axes
+    int first_line;
+    int num_lines;
+    int first_axis;
+    int num_axes;
+
+    SimDrawItem();
+};
+
+//everything the render thread needs to draw one simulated frame, without touching the characters
+struct SimFrame {
+    //0 until the first frame is published
+    int serial;
+    //SIM_SHOW_* flags it was made with
+    int show;
+    //later frames differ even without input, false when the character stands in frame mode
+    bool animating;
+
+    std::vector<SimDrawItem> items;
+    //xyz per vertex, normals only with SIM_SHOW_NORMALS. Only the first num_vertices are
+    //used, the buffers never shrink
+    int num_vertices;
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<ClusterRun> ranges;
+    std::vector<float> lines;
+    std::vector<Matrix_4x4> axes;
+
+    //of the single character with SIM_CULL_CLUSTERS
+    bool clusters_culled;
+    ClusterCullStats cluster_stats;
+    //of the crowd, per level of detail
+    std::vector<CrowdLodStats> lod_stats;
+
+    //text of the last playback change, hint_serial counts the changes
+    char hint[128];
+    int hint_serial;
+
+    //time of the pose, skinning and buffers stages spent on this frame
+    double stage_seconds[NUM_FRAME_STAGES];
+    //busy share of every job worker while this frame ran jobs, and jobs they stole
+    std::vector<float> worker_utilization;
+    int steals;
+
+    SimFrame();
+};
+
+/*
+ * Animation and skinning of the viewer, off the thread which handles input and draws.
+ * Input is handed over as commands through a lock-free single producer/single consumer queue
+ * and the camera as the latest value through a triple buffer. Finished frames are published
+ * through another triple buffer, so the render thread takes the latest one without waiting
+ * and a long frame never holds up input handling or buffer swaps.
+ * Frames are made one ahead: once the render side takes frame N (signalled through a fence)
+ * the next one is posed and skinned as jobs, straight into a free slot of the triple
+ * buffer, while N is drawn. So frames come as fast as the slower of the two sides.
+ * Every frame samples the time itself, so playback speed doesn't depend on the frame rate.
+ */
+class Simulation {
+
+    public:
+        //character, crowd (which may be NULL) and jobs are only touched by the simulation from
+        //now on and must outlive it, the simulation thread is job worker 0.
+        //aspect - width / height of the viewport, for culling
+        Simulation(const AnimationSet* assets, CharacterContext* character, Crowd* crowd,
+                   JobSystem* jobs, const Camera& camera, float aspect);
+        ~Simulation();
+
+        //input side, false if the queue is full and the command was dropped
+        bool Push(const SimCommand& command);
+        void SetView(const Camera& camera);
+
+        //render side, true if a frame was published since the last call
+        bool AcquireFrame();
+        //latest acquired frame, serial 0 if there is none yet
+        const SimFrame& Frame();
+
+        //vertices per skinning job of the character and of crowd instances (2048), set before Start
+        void SetChunkSize(int chunk_size);
+
+        //runs Step on a thread of its own. The thread makes a frame, then waits for the render
+        //side to take it before making the next one
+        void Start();
+        //joins the thread, nothing runs afterwards
+        void Stop();
+        bool Running();
+
+        //one frame: pending commands, time step, evaluation, publish. Without Start the
+        //input thread can call it directly
+        void Step();
+
+    private:
+        Simulation(const Simulation&);
+        Simulation& operator=(const Simulation&);
+
+        static void* ThreadMain(void* arg);
+
+        friend class SimSkinTask;
+        friend class SimCopyTask;
+
+        void Apply(const SimCommand& command);
+        void SetHint(const char* text);
+        void MakeCharacterFrame(SimFrame& frame);
+        void MakeCrowdFrame(SimFrame& frame);
+        void AddSkeleton(SimFrame& frame, SimDrawItem& item, const SkinPoses& poses);
+        void AddMesh(SimFrame& frame, SimDrawItem& item, const Mesh* mesh, bool with_normals,
+                     const ClusterSelection* selection);
+        void AddSkinRanges(int begin, int end);
+
+        const AnimationSet* m_assets;
+        CharacterContext* m_character;
+        std::vector<Vector3> m_joint_positions;
+        Crowd* m_crowd;
+        JobSystem* m_jobs;
+
+        SpscQueue<SimCommand> m_commands;
+        TripleBuffer<Camera> m_views;
+        TripleBuffer<SimFrame> m_frames;
+        //serial of the last frame the render side took
+        FrameFence m_consumed;
+
+        //simulation thread only
+        Camera m_camera;
+        float m_aspect;
+        int m_show;
+        int m_chunk_size;
+        int m_serial;
+        double m_last_time;
+        char m_hint[128];
+        int m_hint_serial;
+        //vertex ranges of the character to skin, crowd instance of every item to copy
+        struct SkinRange {
+            int begin;
+            int end;
+        };
+        std::vector<SkinRange> m_skin_ranges;
+        std::vector<int> m_copy_instances;
+
+        pthread_t m_thread;
+        bool m_running;
+};
+
+#endif
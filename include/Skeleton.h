@@ -7,15 +7,14 @@
 
 #include "Matrix.h"
 #include "Vector.h"
+#include "SkeletonTopology.h"
 
+//local transform of a joint relative to its parent, the hierarchy lives in SkeletonTopology
 struct Joint {
-    int id;
-    int parent_id;
     Vector3 position;
     Matrix_4x4 rotation;
 
     Joint();
-    Joint(int id, int parent_id);
 };
 
 class Skeleton {
@@ -24,16 +23,21 @@ class Skeleton {
         Skeleton();
         ~Skeleton();
         
-        int NumJoints();
-        Joint GetJoint(int i);
+        int NumJoints() const;
+        Joint GetJoint(int i) const;
         void SetJoint(int i, Joint j);
+        const SkeletonTopology* Topology() const;
         
-        Skeleton* Copy();
+        //the copy shares the topology
+        Skeleton* Copy() const;
 
-        Matrix_4x4 JointTransform(int i);
+        Matrix_4x4 LocalTransform(int i) const;
+        Matrix_4x4 JointTransform(int i) const;
 
         Joint* m_joints;
         int m_num_joints;
+        //not owned, outlives the skeleton
+        const SkeletonTopology* m_topology;
         
 };
 
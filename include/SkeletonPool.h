@@ -0,0 +1,54 @@
+#ifndef SKELETON_POOL_H
+#define SKELETON_POOL_H
+
+#pragma once
+
+#include <vector>
+
+#include "Skeleton.h"
+
+/*
+ * Owns skeletons and their joints for a whole set of loaded assets. Both come out of big
+ * contiguous blocks, so loading thousands of frames is a handful of allocations, frames of
+ * an animation end up next to each other in memory and everything is released at once
+ * when the pool is destroyed. Skeletons from the pool must not be deleted.
+ * The pool also keeps one copy of every distinct topology, so clips of the same rig share it.
+ */
+class SkeletonPool {
+
+    public:
+        SkeletonPool(int joints_per_block = 4096);
+        ~SkeletonPool();
+
+        //skeleton of default joints, stays valid for the lifetime of the pool
+        Skeleton* NewSkeleton(const SkeletonTopology* topology);
+
+        //topology of the pool equal to the given one, added if there is none yet
+        const SkeletonTopology* Intern(const SkeletonTopology& topology);
+
+        int NumTopologies();
+        int NumSkeletons();
+        int NumJoints();
+        //joint and skeleton blocks allocated so far
+        int NumBlocks();
+
+    private:
+        SkeletonPool(const SkeletonPool&);
+        SkeletonPool& operator=(const SkeletonPool&);
+
+        int m_joints_per_block;
+
+        std::vector<Joint*> m_joint_blocks;
+        int m_joint_block_size;
+        int m_joint_block_used;
+
+        std::vector<SkeletonTopology*> m_topologies;
+
+        std::vector<Skeleton*> m_skeleton_blocks;
+        int m_skeleton_block_used;
+
+        int m_num_skeletons;
+        int m_num_joints;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SKELETON_TOPOLOGY_H
+#define SKELETON_TOPOLOGY_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * Joint names and hierarchy of a rig, shared by every frame of every clip made for it.
+ * Immutable once built. Skeletons only hold local transforms of the joints, so two
+ * skeletons (or clips) are compatible exactly when they point at the same topology.
+ */
+class SkeletonTopology {
+
+    public:
+        //parents[i] - index of the parent of joint i, -1 for roots. Parents have to form a forest
+        //(see FindCycle), a joint on a cycle is made a root so every joint is still traversed
+        SkeletonTopology(const std::vector<std::string>& names, const std::vector<int>& parents);
+
+        int NumJoints() const;
+        int Parent(int joint_id) const;
+        const std::string& Name(int joint_id) const;
+
+        //every joint once, parents before their children
+        const std::vector<int>& TraversalOrder() const;
+
+        //same names and parents
+        bool Equals(const SkeletonTopology& other) const;
+
+        //a joint whose parent chain comes back to itself, -1 if there is none
+        static int FindCycle(const std::vector<int>& parents);
+
+    private:
+        std::vector<std::string> m_names;
+        std::vector<int> m_parents;
+        std::vector<int> m_order;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#pragma once
+
+#include <vector>
+
+/*
+ * Bounded queue between exactly one producer and one consumer thread, without locks.
+ * Each index is moved by one side only, with an atomic add which is a full barrier, so the item
+ * written (or read) before it is visible to the other side when it sees the index. Neither side ever waits, Push on a
+ * full queue and Pop on an empty one just return false.
+ */
+template <typename T>
+class SpscQueue {
+
+    public:
+        //capacity - rounded up to a power of two
+        SpscQueue(int capacity = 256) : m_head(0), m_tail(0) {
+            int size = 1;
+            while (size < capacity) {
+                size *= 2;
+            }
+            m_items.resize(size);
+            m_mask = size - 1;
+        }
+
+        //producer side, false if the queue is full and item wasn't added
+        bool Push(const T& item) {
+            unsigned int tail = __sync_fetch_and_add(&m_tail, 0);
+            unsigned int head = __sync_fetch_and_add(&m_head, 0);
+            if (tail - head > m_mask) {
+                return false;
+            }
+            m_items[tail & m_mask] = item;
+            __sync_fetch_and_add(&m_tail, 1);
+            return true;
+        }
+
+        //consumer side, false if the queue is empty
+        bool Pop(T& item) {
+            unsigned int head = __sync_fetch_and_add(&m_head, 0);
+            unsigned int tail = __sync_fetch_and_add(&m_tail, 0);
+            if (head == tail) {
+                return false;
+            }
+            item = m_items[head & m_mask];
+            __sync_fetch_and_add(&m_head, 1);
+            return true;
+        }
+
+        int Capacity() const {
+            return (int)m_mask + 1;
+        }
+
+    private:
+        SpscQueue(const SpscQueue&);
+        SpscQueue& operator=(const SpscQueue&);
+
+        std::vector<T> m_items;
+        unsigned int m_mask;
+        //on separate cache lines, the two sides don't invalidate each other's index
+        volatile unsigned int m_head;
+        char m_padding[64];
+        volatile unsigned int m_tail;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#pragma once
+
+#include <algorithm>
+
+#include "Vector.h"
+#include "Skeleton.h"
+#include "Animation.h"
+#include "SkeletonPool.h"
+#include "Geometry.h"
+
+//tiny generator of our own so assets (and crowds) don't depend on the c library rand
+class SyntheticRandom {
+    public:
+        SyntheticRandom(unsigned int seed) : m_state(seed * 2654435761u + 1) {}
+
+        //between 0 and 1
+        float Uniform() {
+            m_state = m_state * 1664525u + 1013904223u;
+            return (m_state >> 8) / 16777216.0f;
+        }
+        float Range(float lower, float upper) {
+            return lower + (upper - lower) * Uniform();
+        }
+        int Index(int n) {
+            return std::min(n - 1, (int)(Uniform() * n));
+        }
+        Vector3 Direction() {
+            return Vector3::Normalize(Vector3(Range(-1, 1), Range(-1, 1), Range(-1, 1)) + Vector3(0, 0.01f, 0));
+        }
+
+    private:
+        unsigned int m_state;
+};
+
+/*
+ * Synthetic assets of arbitrary size for scaling measurements. They are built with the same
+ * types the SMD loaders produce, so every pipeline can run on them unchanged.
+ * The same seed always gives the same asset.
+ */
+
+//parents always precede children, no chain from the root is longer than max_depth joints.
+//The skeleton and its topology belong to pool
+Skeleton* GenerateSkeleton(SkeletonPool& pool, int num_joints, int max_depth, unsigned int seed);
+
+//looping clip, every joint swings around its rest rotation with its own axis and phase
+Animation* GenerateAnimation(const Skeleton* rest, int num_frames, unsigned int seed);
+
+//num_vertices/3 separate triangles around the rest pose joints,
+//every vertex is bound to num_influences joints (between 1 and 3, as many as Vertex can hold)
+Mesh* GenerateMesh(const Skeleton* rest, int num_vertices, int num_influences, unsigned int seed);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#pragma once
+
+//monotonic wall clock in seconds from some arbitrary point, only differences make sense
+double TimeSeconds();
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#pragma once
+
+#include <string>
+
+/*
+ * Timeline tracing. Begin/end events are appended to a buffer owned by the calling thread,
+ * so recording needs no locks. Buffers are chained into a global list with compare-and-swap
+ * the first time a thread records something. The whole timeline is written as Chrome
+ * trace_event JSON, which chrome://tracing and Perfetto open directly.
+ *
+ * Event and thread names must be string literals (or live until the trace is written).
+ */
+
+//nothing is recorded before this
+void TraceStart();
+bool TraceEnabled();
+
+//name shown for the calling thread
+void TraceSetThreadName(const char* name);
+
+void TraceBegin(const char* name);
+void TraceEnd(const char* name);
+
+//writes everything recorded so far, call it when other threads are idle
+bool TraceWrite(std::string filename);
+
+class ScopedTrace {
+    public:
+        ScopedTrace(const char* name) : m_name(name) { TraceBegin(name); }
+        ~ScopedTrace() { TraceEnd(m_name); }
+    private:
+        const char* m_name;
+};
+
+/* Build with -DSKIN_TRACE (make TRACE=1) to compile the trace points in */
+#ifdef SKIN_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ScopedTrace TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) TraceSetThreadName(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD_NAME(name)
+#endif
+
+#endif
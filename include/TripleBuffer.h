@@ -0,0 +1,67 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#pragma once
+
+/*
+ * Hands the latest value from one writer thread to one reader thread, without locks.
+ * The writer fills Back() and Publish swaps it with the middle slot; the reader's Acquire
+ * swaps the middle slot with Front() if something was published since. Neither side ever
+ * waits on the other, the reader always holds a complete value and values published
+ * faster than they are acquired are overwritten. Slots are reused, so anything a value
+ * allocated stays around for the next time the slot is written.
+ */
+template <typename T>
+class TripleBuffer {
+
+    public:
+        TripleBuffer() : m_back(0), m_middle(1), m_front(2) {}
+
+        //writer side
+        T& Back() {
+            return m_slots[m_back];
+        }
+
+        void Publish() {
+            m_back = Exchange(m_back | FRESH) & INDEX;
+        }
+
+        //reader side, false if nothing new was published and Front() stays the same
+        bool Acquire() {
+            if (!(__sync_fetch_and_add(&m_middle, 0) & FRESH)) {
+                return false;
+            }
+            m_front = Exchange(m_front) & INDEX;
+            return true;
+        }
+
+        T& Front() {
+            return m_slots[m_front];
+        }
+
+    private:
+        TripleBuffer(const TripleBuffer&);
+        TripleBuffer& operator=(const TripleBuffer&);
+
+        //slot index of the middle, and whether it holds a value the reader hasn't seen
+        enum {
+            INDEX = 3,
+            FRESH = 4
+        };
+
+        //full barrier, so the slot contents are visible before its index is
+        int Exchange(int value) {
+            int old;
+            do {
+                old = __sync_fetch_and_add(&m_middle, 0);
+            } while (!__sync_bool_compare_and_swap(&m_middle, old, value));
+            return old;
+        }
+
+        T m_slots[3];
+        int m_back;
+        volatile int m_middle;
+        int m_front;
+};
+
+#endif
@@ -25,24 +25,24 @@ class Vector2 {
         
         static void Print(Vector2 v);
         
-        float operator[](int i);
+        float operator[](int i) const;
         
-        bool operator==(Vector2 v);
-        bool operator!=(Vector2 v);
+        bool operator==(Vector2 v) const;
+        bool operator!=(Vector2 v) const;
         
-        Vector2 operator*(float factor);
+        Vector2 operator*(float factor) const;
         Vector2 operator*=(float factor);
-        Vector2 operator*(Vector2 v);
+        Vector2 operator*(Vector2 v) const;
         Vector2 operator*=(Vector2 v);
-        Vector2 operator/(float factor);
-        Vector2 operator/(Vector2 v);
-        Vector2 operator+(float factor);
-        Vector2 operator+(Vector2 v);
+        Vector2 operator/(float factor) const;
+        Vector2 operator/(Vector2 v) const;
+        Vector2 operator+(float factor) const;
+        Vector2 operator+(Vector2 v) const;
         Vector2 operator+=(Vector2 v);
-        Vector2 operator-(Vector2 v);
+        Vector2 operator-(Vector2 v) const;
         Vector2 operator-=(Vector2 v);
         Vector2 operator-=(float factor);
-        Vector2 operator-();
+        Vector2 operator-() const;
 };
 
 class Vector3 {
@@ -68,30 +68,30 @@ class Vector3 {
           
         static void Print(Vector3 v);
         
-        float r();
-        float g();
-        float b();
+        float r() const;
+        float g() const;
+        float b() const;
         
-        Vector2 xy();
+        Vector2 xy() const;
         
-        float operator[](int i);
+        float operator[](int i) const;
         
-        bool operator==(Vector3 v);
-        bool operator!=(Vector3 v);
+        bool operator==(Vector3 v) const;
+        bool operator!=(Vector3 v) const;
         
-        Vector3 operator*(float factor);
+        Vector3 operator*(float factor) const;
         Vector3 operator*=(float factor);
-        Vector3 operator*(Vector3 v);
+        Vector3 operator*(Vector3 v) const;
         Vector3 operator*=(Vector3 v);
-        Vector3 operator/(float factor);
-        Vector3 operator/(Vector3 v);
-        Vector3 operator+(Vector3 v);
-        Vector3 operator+(float factor);
+        Vector3 operator/(float factor) const;
+        Vector3 operator/(Vector3 v) const;
+        Vector3 operator+(Vector3 v) const;
+        Vector3 operator+(float factor) const;
         Vector3 operator+=(Vector3 v);
-        Vector3 operator-(Vector3 v);
+        Vector3 operator-(Vector3 v) const;
         Vector3 operator-=(Vector3 v);
         Vector3 operator-=(float factor);
-        Vector3 operator-();
+        Vector3 operator-() const;
 };
 
 class Vector4 {
@@ -120,32 +120,32 @@ class Vector4 {
         static Vector3 FromHomogeneous(Vector4 v);
         static Vector4 ToHomogeneous(Vector3 v);
         
-        float r();
-        float g();
-        float b();
-        float a();
+        float r() const;
+        float g() const;
+        float b() const;
+        float a() const;
         
-        Vector3 xyz();
-        Vector3 rgb();
+        Vector3 xyz() const;
+        Vector3 rgb() const;
         
-        float operator[](int i);
+        float operator[](int i) const;
         
-        bool operator==(Vector4 v);
-        bool operator!=(Vector4 v);
+        bool operator==(Vector4 v) const;
+        bool operator!=(Vector4 v) const;
         
-        Vector4 operator*(float factor);
+        Vector4 operator*(float factor) const;
         Vector4 operator*=(float factor);
-        Vector4 operator*(Vector4 v);
+        Vector4 operator*(Vector4 v) const;
         Vector4 operator*=(Vector4 v);
-        Vector4 operator/(float factor);
-        Vector4 operator/(Vector4 v);
-        Vector4 operator+(float factor);
-        Vector4 operator+(Vector4 v);
+        Vector4 operator/(float factor) const;
+        Vector4 operator/(Vector4 v) const;
+        Vector4 operator+(float factor) const;
+        Vector4 operator+(Vector4 v) const;
         Vector4 operator+=(Vector4 v);
-        Vector4 operator-(Vector4 v);
+        Vector4 operator-(Vector4 v) const;
         Vector4 operator-=(Vector4 v);
         Vector4 operator-=(float factor);
-        Vector4 operator-();
+        Vector4 operator-() const;
 };
 
 #endif
@@ -0,0 +1,30 @@
+#ifndef WALK_RUN_BLENDING_H
+#define WALK_RUN_BLENDING_H
+
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "Matrix.h"
+
+//WALK AND RUN BLENDING PART ===========================================================================
+//BASED ON:
+//Kovar, Lucas, and Michael Gleicher. "Flexible automatic motion blending with registration curves."
+//Proceedings of the 2003 ACM SIGGRAPH/Eurographics symposium on Computer animation. Eurographics Association, 2003.
+
+//distance between two character postures given by their global joint transforms
+float ComputeDistSkel(const std::vector<Matrix_4x4>& trans_gb_1, const std::vector<Matrix_4x4>& trans_gb_2);
+
+//dists: first index - walk frame, second index - run frame
+void ComputeWalkRunDists(std::vector<std::vector<float> >& dists,
+                         const std::vector<std::vector<Matrix_4x4> >& walk_tpf_gb,
+                         const std::vector<std::vector<Matrix_4x4> >& run_tpf_gb);
+
+//matches: in pairs first is walk frame, second is run frame
+void ComputeWalkRunMatches(std::vector<std::pair<int, int> >& matches, const std::vector<std::vector<float> >& dists, int anim_length);
+
+//prune raw_matches into animation loop
+void ComputeWalkRunLoop(const std::vector<std::pair<int, int> >& raw_matches, std::vector<std::pair<int, int> >& matches);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#pragma once
+
+#include <pthread.h>
+#include <vector>
+
+//Work split into index ranges, Run is called concurrently for different ranges
+class RangeTask {
+    public:
+        virtual ~RangeTask();
+        //worker_id - between 0 and WorkerPool::NumThreads()-1, can index per worker scratch data
+        virtual void Run(int begin, int end, int worker_id) = 0;
+};
+
+/*
+ * Fixed set of threads executing parallel loops. The calling thread takes part as worker 0,
+ * so a pool of one thread runs everything inline. Chunks are claimed dynamically.
+ */
+class WorkerPool {
+
+    public:
+        WorkerPool(int num_threads);
+        ~WorkerPool();
+
+        int NumThreads();
+
+        //runs task over [0, count) in chunks of chunk_size, returns when all chunks are done
+        void ParallelFor(int count, int chunk_size, RangeTask* task);
+
+        //number of hardware threads, at least 1
+        static int HardwareThreads();
+
+    private:
+        WorkerPool(const WorkerPool&);
+        WorkerPool& operator=(const WorkerPool&);
+
+        static void* ThreadMain(void* arg);
+        void RunChunks(int worker_id);
+
+        std::vector<pthread_t> m_threads;
+        int m_num_threads;
+
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_start_cond;
+        pthread_cond_t m_done_cond;
+
+        //current loop, protected by m_mutex except m_next_chunk which is claimed atomically
+        RangeTask* m_task;
+        int m_count;
+        int m_chunk_size;
+        volatile int m_next_chunk;
+        int m_generation;
+        int m_num_working;
+        bool m_quit;
+};
+
+#endif
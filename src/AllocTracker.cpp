@@ -0,0 +1,123 @@
+#include "AllocTracker.h"
+
+#include <stdlib.h>
+#include <new>
+
+static volatile unsigned long long alloc_count = 0;
+static volatile unsigned long long free_count = 0;
+static volatile unsigned long long alloc_bytes = 0;
+
+AllocCounts::AllocCounts()
+    : allocations(0)
+    , frees(0)
+    , bytes(0) {}
+
+AllocCounts AllocCounts::operator-(const AllocCounts& earlier) const {
+    AllocCounts result;
+    result.allocations = allocations - earlier.allocations;
+    result.frees = frees - earlier.frees;
+    result.bytes = bytes - earlier.bytes;
+    return result;
+}
+
+AllocCounts AllocCounts::operator+(const AllocCounts& other) const {
+    AllocCounts result;
+    result.allocations = allocations + other.allocations;
+    result.frees = frees + other.frees;
+    result.bytes = bytes + other.bytes;
+    return result;
+}
+
+bool AllocTrackingCompiled() {
+#ifdef SKIN_TRACK_ALLOC
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocCounts AllocCurrentCounts() {
+    AllocCounts counts;
+    counts.allocations = __sync_fetch_and_add(&alloc_count, 0);
+    counts.frees = __sync_fetch_and_add(&free_count, 0);
+    counts.bytes = __sync_fetch_and_add(&alloc_bytes, 0);
+    return counts;
+}
+
+AllocPhase::AllocPhase()
+    : m_num_windows(0) {}
+
+void AllocPhase::Start() {
+    m_start = AllocCurrentCounts();
+}
+
+void AllocPhase::Stop() {
+    m_last = AllocCurrentCounts() - m_start;
+    m_total = m_total + m_last;
+    m_num_windows++;
+}
+
+AllocCounts AllocPhase::Total() {
+    return m_total;
+}
+
+AllocCounts AllocPhase::Last() {
+    return m_last;
+}
+
+int AllocPhase::NumWindows() {
+    return m_num_windows;
+}
+
+#ifdef SKIN_TRACK_ALLOC
+
+static void* CountedAlloc(size_t size) {
+    __sync_fetch_and_add(&alloc_count, 1);
+    __sync_fetch_and_add(&alloc_bytes, size);
+    return malloc(size ? size : 1);
+}
+
+static void CountedFree(void* ptr) {
+    if (ptr != NULL) {
+        __sync_fetch_and_add(&free_count, 1);
+        free(ptr);
+    }
+}
+
+void* operator new(size_t size) throw(std::bad_alloc) {
+    void* ptr = CountedAlloc(size);
+    if (ptr == NULL) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc) {
+    void* ptr = CountedAlloc(size);
+    if (ptr == NULL) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw() {
+    return CountedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw() {
+    return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) throw() {
+    CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) throw() {
+    CountedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) throw() {
+    CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) throw() {
+    CountedFree(ptr);
+}
+
+#endif
@@ -3,37 +3,45 @@
 #include <math.h>
 #include <stdio.h>
 
-Animation::Animation()
-    : m_num_frames(0)
-    , m_frames(NULL) {}
+Animation::Animation(SkeletonPool* pool)
+    : m_pool(pool)
+    , m_owns_pool(pool == NULL)
+    , m_topology(NULL) {
+    if (m_owns_pool) {
+        m_pool = new SkeletonPool();
+    }
+}
 
 Animation::~Animation() {
-
-    for (int i = 0; i < m_num_frames; i++) {
-        delete m_frames[i];
+    //frames are released by their pool
+    if (m_owns_pool) {
+        delete m_pool;
     }
-
-    delete[] m_frames;
 }
 
-void Animation::AddFrame(Skeleton* frame) {
-    m_num_frames++;
-    Skeleton** newframes = new Skeleton*[m_num_frames];
+Skeleton* Animation::AddFrame(const Skeleton* base) {
+    return AddFrame(base->Topology(), base->m_joints);
+}
 
-    for(int i = 0; i < m_num_frames-1; i++) {
-        newframes[i] = m_frames[i];
+Skeleton* Animation::AddFrame(const SkeletonTopology* topology, const Joint* joints) {
+    //the frames reference the copy of the pool, not the caller's
+    m_topology = m_pool->Intern(*topology);
+    Skeleton* frame = m_pool->NewSkeleton(m_topology);
+    for (int i = 0; i < frame->m_num_joints; i++) {
+        frame->m_joints[i] = joints[i];
     }
-
-    newframes[m_num_frames-1] = frame->Copy();
-
-    delete[] m_frames;
-    m_frames = newframes;
+    m_frames.push_back(frame);
+    return frame;
 }
 
-Skeleton* Animation::GetFrame(int i) {
+const Skeleton* Animation::GetFrame(int i) const {
     return m_frames[i];
 }
 
-int Animation::NumFrames() {
-    return m_num_frames;
+int Animation::NumFrames() const {
+    return m_frames.size();
+}
+
+const SkeletonTopology* Animation::Topology() const {
+    return m_topology;
 }
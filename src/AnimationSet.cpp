@@ -0,0 +1,359 @@
+#include "AnimationSet.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "SMDLoader.h"
+#include "Pose.h"
+#include "WalkRunBlending.h"
+#include "Trace.h"
+
+//how far local blending may pose a joint of the walk/run mix from the global blend, of the size of the rest skeleton
+static const float LOCAL_MIX_TOLERANCE = 0.1f;
+
+//largest distance between the joints of the local and the global blend of matched walk and run frames, half each
+static float ComputeLocalMixError(const AnimationSet& set) {
+    const SkeletonTopology* topology = set.RestAnimation()->Topology();
+    const JointMask& mask = set.RequiredJoints();
+    LocalPoses local_poses;
+    LocalPose local_blend;
+    SkinPoses poses;
+    std::vector<Matrix_4x4> blended_gb;
+    float error = 0;
+    for (int frame = 0; frame < set.NumFrames(CLIP_MIX); frame++) {
+        ClipTime time = SampleClipTime(set.NumFrames(CLIP_MIX), 0.0f, true, frame);
+        SampleLocalPoses(set, CLIP_MIX, time, false, 0.5f, local_poses);
+        BlendLocalPoses(local_poses, local_blend, &mask, topology);
+        ComputeTransGB(blended_gb, topology, local_blend, &mask);
+        SamplePoses(set, CLIP_MIX, time, false, 0.5f, poses);
+        for (int joint_id = 0; joint_id < topology->NumJoints(); joint_id++) {
+            if (!mask.Required(joint_id)) continue;
+            Vector3 global_pos = Vector3::Zero();
+            for (int p = 0; p < poses.num_poses; p++) {
+                global_pos += ((*poses.trans_gb[p])[joint_id] * Vector3::Zero()) * poses.weights[p];
+            }
+            error = std::max(error, Vector3::Distance(global_pos, blended_gb[joint_id] * Vector3::Zero()));
+        }
+    }
+    return error;
+}
+
+AnimationSet::AnimationSet()
+    : m_character(NULL)
+    , m_rest_animation(NULL)
+    , m_run_animation(NULL)
+    , m_walk_animation(NULL)
+    , m_local_mix_blend(false) {}
+
+AnimationSet::~AnimationSet() {
+    delete m_character;
+    delete m_rest_animation;
+    delete m_run_animation;
+    delete m_walk_animation;
+}
+
+void AnimationSet::Load(std::string resources_dir, bool verbose) {
+
+    TRACE_SCOPE("AnimationSet::Load");
+    {
+        TRACE_SCOPE("LoadSMDCharacter character");
+        LoadSMDCharacter(resources_dir + "/character.smd", &m_character);
+    }
+    {
+        TRACE_SCOPE("LoadSMDAnimation rest");
+        LoadSMDAnimation(resources_dir + "/rest_animation.smd", &m_rest_animation, &m_skeleton_pool);
+    }
+    {
+        TRACE_SCOPE("LoadSMDAnimation run");
+        LoadSMDAnimation(resources_dir + "/run_animation.smd",  &m_run_animation, &m_skeleton_pool);
+    }
+    {
+        TRACE_SCOPE("LoadSMDAnimation walk");
+        LoadSMDAnimation(resources_dir + "/walk_animation.smd",  &m_walk_animation, &m_skeleton_pool);
+    }
+
+    //clips of one rig share the topology of the pool
+    if (m_rest_animation->Topology() == NULL
+        || m_run_animation->Topology() != m_rest_animation->Topology()
+        || m_walk_animation->Topology() != m_rest_animation->Topology()) {
+        printf("Rest, run and walk animations don't have the same skeleton\n");
+        fflush(stdout);
+        exit(EXIT_FAILURE);
+    }
+
+    //joints the skin reads, the skeleton view draws and the walk/run distances compare, with their
+    //ancestors. Everything below skips the rest
+    {
+        TRACE_SCOPE("RequireJoints");
+        m_required_joints.Reset(m_rest_animation->Topology());
+        RequireSkinnedJoints(m_required_joints, m_character);
+        RequireSkeletonJoints(m_required_joints);
+    }
+
+    if (verbose) {
+        printf("required joints: %d of %d \n", m_required_joints.NumRequired(), m_required_joints.NumJoints());
+        printf("rest_animation -> number of frames: %d \n", m_rest_animation->NumFrames());
+        printf("run_animation -> number of frames: %d \n", m_run_animation->NumFrames());
+        printf("walk_animation -> number of frames: %d \n", m_walk_animation->NumFrames());
+        printf("skeleton pool -> frames: %d, joints: %d, blocks: %d, topologies: %d \n",
+               m_skeleton_pool.NumSkeletons(), m_skeleton_pool.NumJoints(), m_skeleton_pool.NumBlocks(),
+               m_skeleton_pool.NumTopologies());
+    }
+
+    //compute initial transforms in advance to save CPU =============================
+    {
+        TRACE_SCOPE("ComputeRestTransLC");
+        ComputeRestTransLC(m_rest_trans_lc, m_rest_animation->GetFrame(0));
+    }
+    {
+        TRACE_SCOPE("ComputeJointBounds");
+        ComputeJointBounds(m_character, m_rest_animation->Topology()->NumJoints(), m_joint_bounds);
+    }
+    {
+        TRACE_SCOPE("MeshClusters::Build");
+        m_clusters.Build(m_character, m_rest_animation->Topology()->NumJoints());
+    }
+    {
+        TRACE_SCOPE("LodSet::Build");
+        m_lods.Build(m_character, LodConfig());
+    }
+    {
+        TRACE_SCOPE("ComputeTransPerFrameGB run");
+        ComputeTransPerFrameGB(m_run_tpf_gb, m_run_animation, &m_required_joints);
+    }
+    {
+        TRACE_SCOPE("ComputeTransPerFrameGB walk");
+        ComputeTransPerFrameGB(m_walk_tpf_gb, m_walk_animation, &m_required_joints);
+    }
+    {
+        TRACE_SCOPE("ComputeLocalPoses");
+        ComputeLocalPoses(m_run_local, m_run_animation);
+        ComputeLocalPoses(m_walk_local, m_walk_animation);
+    }
+
+    //Initialise structure for animation blending ===========================================
+    //compute distance between walk/run animations
+    std::vector<std::vector<float> > dists;
+    {
+        TRACE_SCOPE("ComputeWalkRunDists");
+        ComputeWalkRunDists(dists, m_walk_tpf_gb, m_run_tpf_gb);
+    }
+
+    if (verbose) {
+        //print table. On DICE machine with BIG SCREEN I was able to see quite clearly
+        printf("\n\n");
+        printf("Walk/Run distance table:\n");
+        //display run header
+        printf("run  id: ");
+        for (int run_id = 0; run_id < m_run_animation->NumFrames(); run_id++) {
+            printf("%5d ", run_id);
+        }
+        printf("\n");
+        //table body
+        for (size_t walk_id = 0; walk_id < dists.size(); walk_id++) {
+            printf("walk %2d: ", (int)walk_id);//walk header
+            for (size_t run_id = 0; run_id < dists[walk_id].size(); run_id++) {
+                printf("%3.1f ", dists[walk_id][run_id]);
+            }
+            printf(";\n");
+        }
+        printf("\n\n");
+    }
+
+    //how many steps to try to reach loop convergence of two animations
+    int num_frames_raw_animation = m_walk_animation->NumFrames() * 10;
+    std::vector<std::pair<int, int> > raw_matches;
+    {
+        TRACE_SCOPE("ComputeWalkRunMatches");
+        ComputeWalkRunMatches(raw_matches, dists, num_frames_raw_animation);
+    }
+
+    if (verbose) {
+        //display raw sequence of blended frames
+        printf("\nRaw sequence of most suitable frames for blending, first - walk, second - run\n");
+        for (size_t i = 0; i < raw_matches.size(); i++) {
+            printf("(%d, %d);  ", raw_matches[i].first, raw_matches[i].second);
+        }
+        printf("\n");
+    }
+
+    //finding loop animation
+    {
+        TRACE_SCOPE("ComputeWalkRunLoop");
+        ComputeWalkRunLoop(raw_matches, m_matches);
+    }
+
+    if (verbose) {
+        //display loop animation sequence of blended frames
+        printf("\nPruned sequence of most suitable frames for blending, first - walk, second - run\n");
+        for (size_t i = 0; i < m_matches.size(); i++) {
+            printf("(%d, %d);  ", m_matches[i].first, m_matches[i].second);
+        }
+        printf("\n");
+    }
+
+    //the mix is only blended locally if that poses the joints where the global blend does
+    {
+        TRACE_SCOPE("ComputeLocalMixError");
+        std::vector<Matrix_4x4> rest_gb;
+        ComputeTransGB(rest_gb, m_rest_animation->GetFrame(0));
+        Aabb rest_box;
+        for (size_t joint_id = 0; joint_id < rest_gb.size(); joint_id++) {
+            rest_box.Add(rest_gb[joint_id] * Vector3::Zero());
+        }
+        float tolerance = LOCAL_MIX_TOLERANCE * Vector3::Distance(rest_box.lower, rest_box.upper);
+        float error = ComputeLocalMixError(*this);
+        m_local_mix_blend = (error <= tolerance);
+        if (verbose) {
+            printf("local walk/run blend -> largest joint distance from global blend: %.2f (tolerance %.2f)\n",
+                   error, tolerance);
+        }
+        if (!m_local_mix_blend) {
+            printf("[WARNING]: local blending of walk and run moves joints up to %.2f away from the global blend "
+                   "(tolerance %.2f), the mix is blended globally\n", error, tolerance);
+        }
+    }
+}
+
+int AnimationSet::NumFrames(int clip) const {
+    switch (clip) {
+        case CLIP_WALK: return m_walk_animation->NumFrames();
+        case CLIP_MIX:  return m_matches.size();
+        default:        return m_run_animation->NumFrames();
+    }
+}
+
+const Mesh* AnimationSet::Character() const {
+    return m_character;
+}
+
+const Animation* AnimationSet::RestAnimation() const {
+    return m_rest_animation;
+}
+
+const Animation* AnimationSet::RunAnimation() const {
+    return m_run_animation;
+}
+
+const Animation* AnimationSet::WalkAnimation() const {
+    return m_walk_animation;
+}
+
+const std::vector<Matrix_4x4>& AnimationSet::RestTransLC() const {
+    return m_rest_trans_lc;
+}
+
+const std::vector<std::vector<Matrix_4x4> >& AnimationSet::RunTransPerFrameGB() const {
+    return m_run_tpf_gb;
+}
+
+const std::vector<std::vector<Matrix_4x4> >& AnimationSet::WalkTransPerFrameGB() const {
+    return m_walk_tpf_gb;
+}
+
+const std::vector<LocalPose>& AnimationSet::RunLocalPoses() const {
+    return m_run_local;
+}
+
+const std::vector<LocalPose>& AnimationSet::WalkLocalPoses() const {
+    return m_walk_local;
+}
+
+const std::vector<Aabb>& AnimationSet::JointBounds() const {
+    return m_joint_bounds;
+}
+
+const JointMask& AnimationSet::RequiredJoints() const {
+    return m_required_joints;
+}
+
+const MeshClusters& AnimationSet::Clusters() const {
+    return m_clusters;
+}
+
+const LodSet& AnimationSet::Lods() const {
+    return m_lods;
+}
+
+const std::vector<std::pair<int, int> >& AnimationSet::Matches() const {
+    return m_matches;
+}
+
+bool AnimationSet::LocalMixBlend() const {
+    return m_local_mix_blend;
+}
+
+ClipTime SampleClipTime(int num_frames, float global_frame, bool frame_mode, int selected_frame) {
+    ClipTime time;
+    if (frame_mode) {
+        //just displaying required frame
+        time.curr_frame = selected_frame;
+        time.next_frame = selected_frame;
+        time.frame_mix_rate = 0;
+    } else {
+        time.curr_frame = int(global_frame);
+        time.next_frame = time.curr_frame + 1;
+        time.frame_mix_rate = global_frame - int(global_frame);
+        time.frame_mix_rate = std::max(0.0f, std::min(time.frame_mix_rate, 1.0f));
+    }
+
+    //normalise
+    time.curr_frame = time.curr_frame % num_frames;
+    time.next_frame = time.next_frame % num_frames;
+    return time;
+}
+
+void SamplePoses(const AnimationSet& set, int clip, ClipTime time, bool time_interpolation,
+                 float walk_run_mix_rate, SkinPoses& poses) {
+    poses.num_poses = 0;
+    float frame_mix_rate = (time_interpolation) ? time.frame_mix_rate : 0.0f;
+
+    const std::vector<std::vector<Matrix_4x4> >& walk_tpf_gb = set.WalkTransPerFrameGB();
+    const std::vector<std::vector<Matrix_4x4> >& run_tpf_gb = set.RunTransPerFrameGB();
+
+    if (clip == CLIP_MIX) {
+        const std::vector<std::pair<int, int> >& matches = set.Matches();
+        int walk_frame = matches[time.curr_frame].first;
+        int run_frame  = matches[time.curr_frame].second;
+
+        int next_walk_frame = matches[time.next_frame].first;
+        int next_run_frame  = matches[time.next_frame].second;
+
+        poses.Add(&walk_tpf_gb[walk_frame],      (1 - walk_run_mix_rate) * (1 - frame_mix_rate));
+        poses.Add(&run_tpf_gb[run_frame],        walk_run_mix_rate       * (1 - frame_mix_rate));
+        poses.Add(&walk_tpf_gb[next_walk_frame], (1 - walk_run_mix_rate) * frame_mix_rate);
+        poses.Add(&run_tpf_gb[next_run_frame],   walk_run_mix_rate       * frame_mix_rate);
+    } else {
+        const std::vector<std::vector<Matrix_4x4> >& tpf_gb = (clip == CLIP_WALK) ? walk_tpf_gb : run_tpf_gb;
+        poses.Add(&tpf_gb[time.curr_frame], 1 - frame_mix_rate);
+        poses.Add(&tpf_gb[time.next_frame], frame_mix_rate);
+    }
+}
+
+void SampleLocalPoses(const AnimationSet& set, int clip, ClipTime time, bool time_interpolation,
+                      float walk_run_mix_rate, LocalPoses& poses) {
+    poses.num_poses = 0;
+    float frame_mix_rate = (time_interpolation) ? time.frame_mix_rate : 0.0f;
+
+    const std::vector<LocalPose>& walk_local = set.WalkLocalPoses();
+    const std::vector<LocalPose>& run_local = set.RunLocalPoses();
+
+    if (clip == CLIP_MIX) {
+        const std::vector<std::pair<int, int> >& matches = set.Matches();
+        int walk_frame = matches[time.curr_frame].first;
+        int run_frame  = matches[time.curr_frame].second;
+
+        int next_walk_frame = matches[time.next_frame].first;
+        int next_run_frame  = matches[time.next_frame].second;
+
+        poses.Add(&walk_local[walk_frame],      (1 - walk_run_mix_rate) * (1 - frame_mix_rate));
+        poses.Add(&run_local[run_frame],        walk_run_mix_rate       * (1 - frame_mix_rate));
+        poses.Add(&walk_local[next_walk_frame], (1 - walk_run_mix_rate) * frame_mix_rate);
+        poses.Add(&run_local[next_run_frame],   walk_run_mix_rate       * frame_mix_rate);
+    } else {
+        const std::vector<LocalPose>& local = (clip == CLIP_WALK) ? walk_local : run_local;
+        poses.Add(&local[time.curr_frame], 1 - frame_mix_rate);
+        poses.Add(&local[time.next_frame], frame_mix_rate);
+    }
+}
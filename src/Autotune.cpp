@@ -0,0 +1,260 @@
+#include "Autotune.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include "CharacterContext.h"
+#include "LinearBlending.h"
+#include "PoseBatch.h"
+#include "Timer.h"
+
+//trial passes of one configuration take about this long, after the warmup ones
+static const double TRIAL_SECONDS = 0.02;
+static const int WARMUP_PASSES = 2;
+static const int MIN_PASSES = 5;
+static const int MAX_PASSES = 200;
+static const int MIN_CHUNK_SIZE = 256;
+static const int MAX_CHUNK_SIZE = 8192;
+//a configuration with more threads has to be this much faster to win
+static const double MORE_THREADS_GAIN = 0.03;
+
+TuneConfig::TuneConfig()
+    : num_threads(1)
+    , chunk_size(2048)
+    , pass_us(0)
+    , cached(false) {}
+
+Autotuner::Autotuner(const AnimationSet* assets, int max_threads, TuneExecutor executor)
+    : m_assets(assets)
+    , m_max_threads(std::max(1, max_threads))
+    , m_executor(executor)
+    , m_cache_file(DefaultCacheFile()) {
+
+    char text[128];
+    sprintf(text, ";threads %d/%d;lanes %d;mesh %08x;%s", m_max_threads, WorkerPool::HardwareThreads(),
+            SKIN_POSE_LANES, MeshSignature(assets->Character()), (executor == TUNE_WORKER_POOL) ? "pool" : "jobs");
+    m_key = CpuModel() + text;
+}
+
+std::string Autotuner::CpuModel() {
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (f == NULL) {
+        return "unknown cpu";
+    }
+    std::string model = "unknown cpu";
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "model name", 10) == 0) {
+            char* value = strchr(line, ':');
+            if (value != NULL) {
+                value++;
+                while (*value == ' ' || *value == '\t') value++;
+                value[strcspn(value, "\r\n")] = '\0';
+                model = value;
+            }
+            break;
+        }
+    }
+    fclose(f);
+    return model;
+}
+
+//FNV-1a
+static unsigned int HashBytes(unsigned int hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+unsigned int Autotuner::MeshSignature(const Mesh* mesh) {
+    unsigned int hash = 2166136261u;
+    int sizes[2] = {mesh->NumVertices(), mesh->NumTriangles()};
+    hash = HashBytes(hash, sizes, sizeof(sizes));
+    hash = HashBytes(hash, mesh->m_vertices, sizeof(Vertex) * mesh->NumVertices());
+    hash = HashBytes(hash, mesh->m_triangles, sizeof(int) * mesh->NumTriangles() * 3);
+    return hash;
+}
+
+std::string Autotuner::DefaultCacheFile() {
+    const char* file = getenv("SKINNING_TUNE_CACHE");
+    if (file != NULL && file[0] != '\0') {
+        return file;
+    }
+    std::string dir;
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (xdg != NULL && xdg[0] != '\0') {
+        dir = xdg;
+    } else if (home != NULL && home[0] != '\0') {
+        dir = std::string(home) + "/.cache";
+    } else {
+        return "skinning_tune.txt";
+    }
+#ifndef _WIN32
+    //already there almost always
+    mkdir(dir.c_str(), 0755);
+#endif
+    return dir + "/skinning_tune.txt";
+}
+
+void Autotuner::SetCacheFile(const std::string& filename) {
+    m_cache_file = filename;
+}
+
+const std::string& Autotuner::CacheFile() const {
+    return m_cache_file;
+}
+
+const std::string& Autotuner::Key() const {
+    return m_key;
+}
+
+//"key\tthreads chunk_size pass_us" per line
+bool Autotuner::Load(TuneConfig& config) {
+    FILE* f = fopen(m_cache_file.c_str(), "r");
+    if (f == NULL) {
+        return false;
+    }
+    bool found = false;
+    char line[1024];
+    while (!found && fgets(line, sizeof(line), f) != NULL) {
+        char* values = strchr(line, '\t');
+        if (values == NULL) continue;
+        *values++ = '\0';
+        if (m_key != line) continue;
+        TuneConfig entry;
+        if (sscanf(values, "%d %d %lf", &entry.num_threads, &entry.chunk_size, &entry.pass_us) == 3
+                && entry.num_threads >= 1 && entry.num_threads <= m_max_threads && entry.chunk_size >= 1) {
+            entry.cached = true;
+            config = entry;
+            found = true;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+//rewrites the file with the entry of this key replaced, entries of other hosts and meshes stay
+bool Autotuner::Save(const TuneConfig& config) {
+    std::vector<std::string> lines;
+    FILE* f = fopen(m_cache_file.c_str(), "r");
+    if (f != NULL) {
+        char line[1024];
+        while (fgets(line, sizeof(line), f) != NULL) {
+            const char* values = strchr(line, '\t');
+            if (values != NULL && m_key != std::string(line, values - line)) {
+                lines.push_back(line);
+            }
+        }
+        fclose(f);
+    }
+    f = fopen(m_cache_file.c_str(), "w");
+    if (f == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < lines.size(); i++) {
+        fputs(lines[i].c_str(), f);
+    }
+    fprintf(f, "%s\t%d %d %.1f\n", m_key.c_str(), config.num_threads, config.chunk_size, config.pass_us);
+    return fclose(f) == 0;
+}
+
+TuneConfig Autotuner::Tune(bool retune) {
+    TuneConfig config;
+    if (!retune && Load(config)) {
+        return config;
+    }
+    config = Measure();
+    if (!Save(config)) {
+        printf("Failed to write autotune cache %s\n", m_cache_file.c_str());
+    }
+    return config;
+}
+
+//vertex chunks of the character skinned with one palette, as the simulation does
+class TuneSkinTask : public RangeTask {
+    public:
+        TuneSkinTask(const Mesh* mesh, const Matrix_4x4* palette, float* positions, float* normals)
+            : mesh(mesh), palette(palette), positions(positions), normals(normals) {}
+
+        void Run(int begin, int end, int worker_id) {
+            SkinMeshPaletteRange(mesh, palette, SKIN_OUTPUT_ALL, positions + begin * 3, normals + begin * 3, begin, end);
+        }
+
+        const Mesh* mesh;
+        const Matrix_4x4* palette;
+        float* positions;
+        float* normals;
+};
+
+//median of the passes, executor is a JobSystem or a WorkerPool
+template <class Executor>
+double Autotuner::TimePass(Executor& executor, int chunk_size) {
+    const Mesh* mesh = m_assets->Character();
+    int num_vertices = mesh->NumVertices();
+    CharacterContext context(m_assets);
+    context.BeginFrame();
+    std::vector<float> positions(num_vertices * 3);
+    std::vector<float> normals(num_vertices * 3);
+    TuneSkinTask task(mesh, context.Palette(), &positions[0], &normals[0]);
+
+    for (int i = 0; i < WARMUP_PASSES; i++) {
+        executor.ParallelFor(num_vertices, chunk_size, &task);
+    }
+    std::vector<double> samples;
+    double start = TimeSeconds();
+    while ((int)samples.size() < MAX_PASSES
+            && ((int)samples.size() < MIN_PASSES || TimeSeconds() - start < TRIAL_SECONDS)) {
+        double pass_start = TimeSeconds();
+        executor.ParallelFor(num_vertices, chunk_size, &task);
+        samples.push_back(TimeSeconds() - pass_start);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2] * 1e6;
+}
+
+TuneConfig Autotuner::Measure() {
+    int num_vertices = m_assets->Character()->NumVertices();
+    //powers of two and the maximum
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < m_max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(m_max_threads);
+    //chunks up to one covering the whole mesh
+    std::vector<int> chunk_sizes;
+    for (int chunk_size = MIN_CHUNK_SIZE; chunk_size <= MAX_CHUNK_SIZE; chunk_size *= 2) {
+        chunk_sizes.push_back(chunk_size);
+        if (chunk_size >= num_vertices) break;
+    }
+
+    TuneConfig best;
+    best.pass_us = -1;
+    for (size_t t = 0; t < thread_counts.size(); t++) {
+        //one executor per thread count, only one of them is started
+        WorkerPool* pool = (m_executor == TUNE_WORKER_POOL) ? new WorkerPool(thread_counts[t]) : NULL;
+        JobSystem* jobs = (m_executor == TUNE_JOB_SYSTEM) ? new JobSystem(thread_counts[t]) : NULL;
+        for (size_t c = 0; c < chunk_sizes.size(); c++) {
+            double pass_us = (pool != NULL) ? TimePass(*pool, chunk_sizes[c]) : TimePass(*jobs, chunk_sizes[c]);
+            bool more_threads = (best.pass_us >= 0 && thread_counts[t] > best.num_threads);
+            double needed = (more_threads) ? best.pass_us * (1.0 - MORE_THREADS_GAIN) : best.pass_us;
+            if (best.pass_us < 0 || pass_us < needed) {
+                best.num_threads = thread_counts[t];
+                best.chunk_size = chunk_sizes[c];
+                best.pass_us = pass_us;
+            }
+        }
+        delete pool;
+        delete jobs;
+    }
+    return best;
+}
@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+
+#include <math.h>
+#include <algorithm>
+
+#include "Timer.h"
+
+volatile float bench_sink = 0;
+
+BenchCase::BenchCase(std::string name, int ops_per_run)
+    : name(name)
+    , ops_per_run(ops_per_run) {}
+
+BenchCase::~BenchCase() {}
+
+double Percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    int rank = (int)ceil(p * samples.size()) - 1;
+    rank = std::max(0, std::min(rank, (int)samples.size() - 1));
+    return samples[rank];
+}
+
+BenchStats RunBenchCase(BenchCase& bench, int warmup, int repetitions) {
+    for (int i = 0; i < warmup; i++) {
+        bench.Run();
+    }
+
+    std::vector<double> samples(repetitions);
+    double sum = 0;
+    for (int i = 0; i < repetitions; i++) {
+        double start = TimeSeconds();
+        bench.Run();
+        samples[i] = (TimeSeconds() - start) * 1e9 / bench.ops_per_run;
+        sum += samples[i];
+    }
+
+    BenchStats stats;
+    stats.name = bench.name;
+    stats.repetitions = repetitions;
+    stats.ops_per_run = bench.ops_per_run;
+    stats.min_ns = Percentile(samples, 0);
+    stats.median_ns = Percentile(samples, 0.5);
+    stats.p99_ns = Percentile(samples, 0.99);
+    stats.mean_ns = (repetitions > 0) ? sum / repetitions : 0;
+    return stats;
+}
+
+void PrintBenchTable(FILE* f, std::vector<BenchStats>& stats) {
+    fprintf(f, "%-48s %12s %12s %12s %12s\n", "benchmark (ns/op)", "min", "median", "p99", "mean");
+    for (size_t i = 0; i < stats.size(); i++) {
+        fprintf(f, "%-48s %12.1f %12.1f %12.1f %12.1f\n", stats[i].name.c_str(),
+                stats[i].min_ns, stats[i].median_ns, stats[i].p99_ns, stats[i].mean_ns);
+    }
+}
+
+void WriteBenchJSON(FILE* f, std::vector<BenchStats>& stats, int warmup, int repetitions) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"warmup\": %d,\n", warmup);
+    fprintf(f, "  \"repetitions\": %d,\n", repetitions);
+    fprintf(f, "  \"unit\": \"ns/op\",\n");
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < stats.size(); i++) {
+        fprintf(f, "    {\"name\": \"%s\", \"ops_per_run\": %d, \"repetitions\": %d, "
+                   "\"min\": %.3f, \"median\": %.3f, \"p99\": %.3f, \"mean\": %.3f}%s\n",
+                stats[i].name.c_str(), stats[i].ops_per_run, stats[i].repetitions,
+                stats[i].min_ns, stats[i].median_ns, stats[i].p99_ns, stats[i].mean_ns,
+                (i + 1 < stats.size()) ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+}
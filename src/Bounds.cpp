@@ -0,0 +1,62 @@
+#include "Bounds.h"
+
+#include <math.h>
+#include <algorithm>
+
+Aabb::Aabb()
+    : lower(Vector3::Zero())
+    , upper(Vector3::Zero())
+    , empty(true) {}
+
+void Aabb::Add(Vector3 point) {
+    if (empty) {
+        lower = point;
+        upper = point;
+        empty = false;
+        return;
+    }
+    lower = Vector3(std::min(lower.x, point.x), std::min(lower.y, point.y), std::min(lower.z, point.z));
+    upper = Vector3(std::max(upper.x, point.x), std::max(upper.y, point.y), std::max(upper.z, point.z));
+}
+
+void Aabb::Add(const Aabb& box) {
+    if (!box.empty) {
+        Add(box.lower);
+        Add(box.upper);
+    }
+}
+
+Aabb Aabb::Transformed(const Matrix_4x4& transform) const {
+    Aabb box;
+    if (empty) {
+        return box;
+    }
+    for (int corner = 0; corner < 8; corner++) {
+        Vector3 point((corner & 1) ? upper.x : lower.x,
+                      (corner & 2) ? upper.y : lower.y,
+                      (corner & 4) ? upper.z : lower.z);
+        box.Add(transform * point);
+    }
+    return box;
+}
+
+void ComputeJointBounds(const Mesh* mesh, int num_joints, std::vector<Aabb>& joint_bounds) {
+    joint_bounds.assign(num_joints, Aabb());
+    for (int i = 0; i < mesh->NumVertices(); i++) {
+        const Vertex& vertex = mesh->m_vertices[i];
+        for (int j = 0; j < 3; j++) {
+            int joint_id = (int)round(vertex.weight_ids[j]);
+            if (vertex.weight_amounts[j] > 0 && joint_id >= 0 && joint_id < num_joints) {
+                joint_bounds[joint_id].Add(vertex.position);
+            }
+        }
+    }
+}
+
+Aabb SkinnedBounds(const std::vector<Aabb>& joint_bounds, const Matrix_4x4* palette) {
+    Aabb box;
+    for (size_t joint_id = 0; joint_id < joint_bounds.size(); joint_id++) {
+        box.Add(joint_bounds[joint_id].Transformed(palette[joint_id]));
+    }
+    return box;
+}
@@ -0,0 +1,123 @@
+#include "CharacterContext.h"
+
+#include "Pose.h"
+
+Playback::Playback()
+    : clip(CLIP_RUN)
+    , global_frame(0.0f)
+    , frames_per_second(30.0f)
+    , walk_run_mix_rate(0.5f)
+    , time_interpolation(true)
+    , frame_mode(false)
+    , selected_frame(0)
+    , local_blend(false) {}
+
+CharacterContext::CharacterContext(const AnimationSet* assets)
+    : m_assets(assets)
+    , m_palette(NULL)
+    , m_output(SKIN_OUTPUT_ALL)
+    , m_skin_mesh(NULL)
+    , m_num_influences(3)
+    , m_positions(NULL)
+    , m_normals(NULL) {
+    m_time.curr_frame = 0;
+    m_time.next_frame = 0;
+    m_time.frame_mix_rate = 0;
+}
+
+const AnimationSet* CharacterContext::Assets() const {
+    return m_assets;
+}
+
+void CharacterContext::Advance(float seconds) {
+    playback.global_frame += seconds * playback.frames_per_second;
+}
+
+void CharacterContext::BeginFrame(bool compose) {
+    m_scratch.Reset();
+    m_palette = NULL;
+    m_positions = NULL;
+    m_normals = NULL;
+
+    m_time = SampleClipTime(m_assets->NumFrames(playback.clip), playback.global_frame,
+                            playback.frame_mode, playback.selected_frame);
+    if (!BlendsLocal()) {
+        SamplePoses(*m_assets, playback.clip, m_time, playback.time_interpolation,
+                    playback.walk_run_mix_rate, m_poses);
+        return;
+    }
+
+    SampleLocalPoses(*m_assets, playback.clip, m_time, playback.time_interpolation,
+                     playback.walk_run_mix_rate, m_local_poses);
+    BlendLocalPoses(m_local_poses, m_local_blend, &m_assets->RequiredJoints(),
+                    m_assets->RestAnimation()->Topology());
+    m_poses.num_poses = 0;
+    m_poses.Add(&m_blended_gb, 1.0f);
+    if (compose) {
+        ComputeTransGB(m_blended_gb, m_assets->RestAnimation()->Topology(), m_local_blend, &m_assets->RequiredJoints());
+    }
+}
+
+const LocalPose& CharacterContext::LocalBlend() const {
+    return m_local_blend;
+}
+
+bool CharacterContext::BlendsLocal() const {
+    return playback.local_blend && (playback.clip != CLIP_MIX || m_assets->LocalMixBlend());
+}
+
+void CharacterContext::SetComposed(const PoseBatch& batch, int lane) {
+    batch.GetGlobal(lane, m_blended_gb);
+}
+
+ClipTime CharacterContext::Time() const {
+    return m_time;
+}
+
+const SkinPoses& CharacterContext::Poses() const {
+    return m_poses;
+}
+
+const Matrix_4x4* CharacterContext::Palette() {
+    if (m_palette == NULL) {
+        m_palette = m_scratch.AllocArray<Matrix_4x4>(m_assets->RestTransLC().size());
+        ComputeSkinPalette(m_poses, m_assets->RestTransLC(), m_palette, &m_assets->RequiredJoints());
+    }
+    return m_palette;
+}
+
+void CharacterContext::Skin(int output) {
+    PrepareSkin(output);
+    SkinRange(0, m_assets->Character()->NumVertices());
+}
+
+void CharacterContext::PrepareSkin(int output, const Mesh* mesh, int num_influences,
+                                   float* positions, float* normals) {
+    m_skin_mesh = (mesh != NULL) ? mesh : m_assets->Character();
+    m_num_influences = num_influences;
+    int num_vertices = m_skin_mesh->NumVertices();
+    Palette();
+    m_output = output;
+    m_positions = (positions != NULL) ? positions : m_scratch.AllocArray<float>(num_vertices * 3);
+    m_normals = NULL;
+    if (output & SKIN_OUTPUT_NORMALS) {
+        m_normals = (normals != NULL) ? normals : m_scratch.AllocArray<float>(num_vertices * 3);
+    }
+}
+
+void CharacterContext::SkinRange(int begin, int end) {
+    SkinMeshPaletteRange(m_skin_mesh, m_palette, m_output, m_positions + begin * 3,
+                         (m_normals != NULL) ? m_normals + begin * 3 : NULL, begin, end, m_num_influences);
+}
+
+const float* CharacterContext::Positions() const {
+    return m_positions;
+}
+
+const float* CharacterContext::Normals() const {
+    return m_normals;
+}
+
+FrameArena& CharacterContext::Scratch() {
+    return m_scratch;
+}
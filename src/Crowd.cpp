@@ -0,0 +1,641 @@
+#include "Crowd.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include "Synthetic.h"
+#include "Trace.h"
+
+CrowdConfig::CrowdConfig()
+    : num_instances(100)
+    , min_fps(20.0f)
+    , max_fps(40.0f)
+    , min_mix(0.0f)
+    , max_mix(1.0f)
+    , random_phase(true)
+    , seed(1)
+    , local_blend(false)
+    , spacing(30.0f)
+    , placement_file("")
+    , lod(true)
+    , numa(NULL)
+    , jobs(NULL)
+    , replicate_assets(false) {
+    clip_weights[CLIP_WALK] = 1;
+    clip_weights[CLIP_RUN] = 1;
+    clip_weights[CLIP_MIX] = 1;
+}
+
+Crowd::Crowd(const AnimationSet* assets)
+    : m_assets(assets)
+    , m_frustum(NULL)
+    , m_num_nodes(1)
+    , m_lod_enabled(false)
+    , m_last_advance(0) {}
+
+Crowd::~Crowd() {
+    Clear();
+}
+
+void Crowd::Clear() {
+    for (size_t i = 0; i < m_instances.size(); i++) {
+        delete m_instances[i];
+    }
+    for (size_t i = 0; i < m_batches.size(); i++) {
+        delete m_batches[i];
+    }
+    for (size_t i = 0; i < m_node_lods.size(); i++) {
+        delete m_node_lods[i];
+    }
+    m_instances.clear();
+    m_batches.clear();
+    m_node_lods.clear();
+    m_num_nodes = 1;
+    m_lod_states.clear();
+    m_world.clear();
+    m_positions.clear();
+    m_headings.clear();
+}
+
+bool Crowd::LoadPlacement(const std::string& filename) {
+    FILE* f = fopen(filename.c_str(), "r");
+    if (f == NULL) {
+        printf("Failed to read placement file %s\n", filename.c_str());
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') continue;
+        float x, z, heading = 0;
+        int read = sscanf(line, "%f %f %f", &x, &z, &heading);
+        if (read >= 2) {
+            m_positions.push_back(Vector3(x, 0, z));
+            m_headings.push_back((read == 3) ? heading : 0.0f);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+//contexts of the instances of one node and its copy of the level meshes, run on that node
+class CrowdPlaceTask : public RangeTask {
+    public:
+        CrowdPlaceTask(Crowd& crowd, const CrowdConfig& config)
+            : crowd(crowd), config(config) {}
+
+        void Run(int begin, int end, int worker_id) {
+            for (int node = begin; node < end; node++) {
+                for (int i = node; i < crowd.NumInstances(); i += crowd.m_num_nodes) {
+                    crowd.m_instances[i] = new CharacterContext(crowd.m_assets);
+                }
+                if (config.replicate_assets) {
+                    crowd.m_node_lods[node] = new LodSet();
+                    crowd.m_node_lods[node]->Build(crowd.m_assets->Character(), config.lod_config, true,
+                                                   &crowd.m_assets->Lods());
+                }
+            }
+        }
+
+        Crowd& crowd;
+        const CrowdConfig& config;
+};
+
+bool Crowd::Create(const CrowdConfig& config) {
+    Clear();
+
+    if (!config.placement_file.empty()) {
+        if (!LoadPlacement(config.placement_file)) {
+            return false;
+        }
+    } else {
+        //square grid centered at the origin
+        int num_instances = std::max(0, config.num_instances);
+        int side = (int)ceil(sqrt((double)num_instances));
+        float offset = (side - 1) * config.spacing * 0.5f;
+        for (int i = 0; i < num_instances; i++) {
+            m_positions.push_back(Vector3((i % side) * config.spacing - offset, 0, (i / side) * config.spacing - offset));
+            m_headings.push_back(0.0f);
+        }
+    }
+
+    //instance i belongs to node i % m_num_nodes, neighbours on different nodes keep the shards
+    //about as busy as each other whatever is culled. Only nodes the job system has workers on
+    //(none if it couldn't pin them) get instances, nobody else would run their jobs there
+    m_instances.assign(m_positions.size(), NULL);
+    int num_nodes = 1;
+    if (config.numa != NULL && config.jobs != NULL) {
+        num_nodes = std::min(config.numa->NumNodes(), config.jobs->NumNodes());
+    }
+    if (num_nodes > 1) {
+        m_num_nodes = num_nodes;
+        if (config.replicate_assets) {
+            m_node_lods.assign(m_num_nodes, NULL);
+        }
+        CrowdPlaceTask task(*this, config);
+        bool pinned = true;
+        for (int node = 0; pinned && node < m_num_nodes; node++) {
+            pinned = RunOnNode(*config.numa, node, &task, node, node + 1);
+        }
+        if (!pinned) {
+            //what the nodes placed so far is dropped, everything is allocated as without numa
+            printf("Failed to pin threads to NUMA nodes, the crowd is placed unpinned and unsharded\n");
+            for (size_t i = 0; i < m_instances.size(); i++) {
+                delete m_instances[i];
+                m_instances[i] = NULL;
+            }
+            for (size_t i = 0; i < m_node_lods.size(); i++) {
+                delete m_node_lods[i];
+            }
+            m_node_lods.clear();
+            m_num_nodes = 1;
+        }
+    }
+    if (m_num_nodes == 1) {
+        for (size_t i = 0; i < m_positions.size(); i++) {
+            m_instances[i] = new CharacterContext(m_assets);
+        }
+    }
+
+    float total_weight = config.clip_weights[CLIP_WALK] + config.clip_weights[CLIP_RUN] + config.clip_weights[CLIP_MIX];
+    SyntheticRandom random(config.seed);
+    for (size_t i = 0; i < m_positions.size(); i++) {
+        CharacterContext* instance = m_instances[i];
+        Playback& playback = instance->playback;
+
+        float pick = random.Uniform() * total_weight;
+        if (pick < config.clip_weights[CLIP_WALK]) {
+            playback.clip = CLIP_WALK;
+        } else if (pick < config.clip_weights[CLIP_WALK] + config.clip_weights[CLIP_RUN]) {
+            playback.clip = CLIP_RUN;
+        } else {
+            playback.clip = CLIP_MIX;
+        }
+        playback.frames_per_second = random.Range(config.min_fps, config.max_fps);
+        playback.walk_run_mix_rate = random.Range(config.min_mix, config.max_mix);
+        playback.global_frame = (config.random_phase) ? random.Uniform() * m_assets->NumFrames(playback.clip) : 0.0f;
+        playback.local_blend = config.local_blend;
+    }
+
+    m_lod_enabled = config.lod;
+    m_lods.Build(m_assets->Character(), config.lod_config, false, &m_assets->Lods());
+    m_lod_states.assign(m_instances.size(), InstanceLodState());
+    for (size_t i = 0; i < m_positions.size(); i++) {
+        m_world.push_back(Matrix_4x4::Translation(m_positions[i]) * Matrix_4x4::RotationY(m_headings[i] * M_PI / 180.0f));
+    }
+    return true;
+}
+
+int Crowd::NumInstances() {
+    return m_instances.size();
+}
+
+CharacterContext& Crowd::Instance(int i) {
+    return *m_instances[i];
+}
+
+Vector3 Crowd::Position(int i) {
+    return m_positions[i];
+}
+
+float Crowd::Heading(int i) {
+    return m_headings[i];
+}
+
+void Crowd::Advance(float seconds) {
+    m_last_advance = seconds;
+    for (size_t i = 0; i < m_instances.size(); i++) {
+        m_instances[i]->Advance(seconds);
+    }
+}
+
+Crowd::InstanceLodState::InstanceLodState()
+    : level(-1)
+    , frames_to_update(0)
+    , frames_since_update(0)
+    , mode(LOD_SKIN)
+    , ahead_frames(0)
+    , draw_positions(NULL)
+    , draw_normals(NULL)
+    , visible(true) {}
+
+bool Crowd::Visible(int i) {
+    return m_lod_states[i].visible;
+}
+
+const Matrix_4x4& Crowd::World(int i) {
+    return m_world[i];
+}
+
+const Mesh* Crowd::InstanceMesh(int i) {
+    return NodeLevel(i, std::max(0, m_lod_states[i].level)).mesh;
+}
+
+const float* Crowd::Positions(int i) {
+    return m_lod_states[i].draw_positions;
+}
+
+const float* Crowd::Normals(int i) {
+    return m_lod_states[i].draw_normals;
+}
+
+int Crowd::InstanceLod(int i) {
+    return m_lod_states[i].level;
+}
+
+int Crowd::HomeNode(int i) {
+    return i % m_num_nodes;
+}
+
+int Crowd::NumNodes() {
+    return m_num_nodes;
+}
+
+//level of instance i with the meshes of its node
+const LodLevel& Crowd::NodeLevel(int i, int level) {
+    const LodSet& lods = (m_node_lods.empty()) ? m_lods : *m_node_lods[HomeNode(i)];
+    return lods.Level(level);
+}
+
+const LodSet& Crowd::Lods() {
+    return m_lods;
+}
+
+CrowdLodStats Crowd::LodStats(int level) {
+    return m_stats[level];
+}
+
+static void ResizeBuffer(std::vector<float>& buffer, int size) {
+    if ((int)buffer.size() != size) {
+        buffer.resize(size);
+    }
+}
+
+//picks the level of every instance for this frame and which ones update their pose
+void Crowd::SelectLods(int skin_output, Vector3 camera_position) {
+    m_updates.clear();
+    m_stats.assign(m_lods.NumLevels(), CrowdLodStats());
+
+    for (int i = 0; i < NumInstances(); i++) {
+        InstanceLodState& state = m_lod_states[i];
+        int level = (m_lod_enabled) ? m_lods.Select(Vector3::Distance(m_positions[i], camera_position)) : 0;
+        bool entered = (level != state.level);
+        if (entered) {
+            state.level = level;
+            state.frames_to_update = 0;
+        }
+        const LodLevel& lod = m_lods.Level(level);
+        m_stats[level].instances++;
+
+        if (state.frames_to_update == 0) {
+            //the update of the frame entering the level is a frame old by now, the first interval
+            //starts at it instead of at this frame, which is already interpolated into it
+            bool after_entering = (!entered && state.mode == LOD_SKIN_NEXT && state.ahead_frames == 0);
+            state.frames_since_update = 0;
+            state.ahead_frames = 0;
+            if (lod.update_interval == 1) {
+                state.mode = LOD_SKIN;
+            } else {
+                state.mode = LOD_SKIN_NEXT;
+                //buffers are sized by the pose job, on the node of the instance
+                if (!entered) {
+                    //the last update is the current time, this one is skinned for the next update
+                    state.prev_positions.swap(state.next_positions);
+                    state.prev_normals.swap(state.next_normals);
+                    state.frames_since_update = (after_entering) ? 1 : 0;
+                    state.ahead_frames = (lod.update_interval - state.frames_since_update) * m_last_advance
+                                       * m_instances[i]->playback.frames_per_second;
+                }
+            }
+            //a level just entered has nothing to interpolate from, it updates again next frame
+            state.frames_to_update = (entered && lod.update_interval > 1) ? 0
+                                   : lod.update_interval - 1 - state.frames_since_update;
+            m_updates.push_back(i);
+            m_stats[level].updated++;
+        } else {
+            state.frames_to_update--;
+            state.frames_since_update++;
+            state.mode = LOD_INTERPOLATE;
+        }
+    }
+}
+
+//interpolation buffers of an instance updated for a later frame, both results are the same size
+//so it doesn't matter they were swapped before
+void Crowd::ResizeLodBuffers(int i, int skin_output) {
+    InstanceLodState& state = m_lod_states[i];
+    int num_vertices = m_lods.Level(state.level).mesh->NumVertices();
+    int normals_size_factor = (skin_output & SKIN_OUTPUT_NORMALS) ? 3 : 0;
+    ResizeBuffer(state.prev_positions, num_vertices * 3);
+    ResizeBuffer(state.next_positions, num_vertices * 3);
+    ResizeBuffer(state.positions, num_vertices * 3);
+    ResizeBuffer(state.prev_normals, num_vertices * normals_size_factor);
+    ResizeBuffer(state.next_normals, num_vertices * normals_size_factor);
+    ResizeBuffer(state.normals, num_vertices * normals_size_factor);
+}
+
+//pose groups of up to SKIN_POSE_LANES updates. Sharded, updates are ordered by node and a group
+//doesn't mix nodes, so it runs where all of its instances live
+void Crowd::GroupUpdates() {
+    if (m_num_nodes > 1) {
+        m_node_updates.clear();
+        for (int node = 0; node < m_num_nodes; node++) {
+            for (size_t k = 0; k < m_updates.size(); k++) {
+                if (HomeNode(m_updates[k]) == node) {
+                    m_node_updates.push_back(m_updates[k]);
+                }
+            }
+        }
+        m_updates.swap(m_node_updates);
+    }
+    m_group_first.clear();
+    for (int k = 0; k < (int)m_updates.size(); k++) {
+        if (k == 0 || k - m_group_first.back() == SKIN_POSE_LANES
+                   || HomeNode(m_updates[k]) != HomeNode(m_updates[k - 1])) {
+            m_group_first.push_back(k);
+        }
+    }
+    m_group_first.push_back(m_updates.size());
+}
+
+int Crowd::NumGroups() {
+    return m_group_first.size() - 1;
+}
+
+//vertex ranges of the visible instances, after their poses and bounds are known
+void Crowd::CollectWork(int chunk_size) {
+    m_items.clear();
+    for (int i = 0; i < NumInstances(); i++) {
+        CullInterpolated(i);
+        if (CountWork(i)) {
+            AddWork(i, chunk_size);
+        }
+    }
+}
+
+//interpolated instances keep the bounds of their last two updates, they are known before any pose
+void Crowd::CullInterpolated(int i) {
+    InstanceLodState& state = m_lod_states[i];
+    if (state.mode == LOD_INTERPOLATE) {
+        state.visible = (m_frustum == NULL) || m_frustum->Intersects(state.bounds.Transformed(m_world[i]));
+    }
+}
+
+//adds instance i to the statistics of its level, false if it was culled
+bool Crowd::CountWork(int i) {
+    InstanceLodState& state = m_lod_states[i];
+    CrowdLodStats& stats = m_stats[state.level];
+    if (!state.visible) {
+        stats.culled++;
+        if (state.mode == LOD_SKIN_NEXT) {
+            //next isn't skinned, so there will be nothing to interpolate to: start over once visible
+            state.level = -1;
+        }
+        return false;
+    }
+
+    int num_vertices = m_lods.Level(state.level).mesh->NumVertices();
+    if (state.mode == LOD_INTERPOLATE) {
+        stats.interpolated_vertices += num_vertices;
+    } else {
+        stats.skinned_vertices += num_vertices;
+    }
+    return true;
+}
+
+void Crowd::AddWork(int i, int chunk_size) {
+    int num_vertices = m_lods.Level(m_lod_states[i].level).mesh->NumVertices();
+    for (int begin = 0; begin < num_vertices; begin += chunk_size) {
+        WorkItem item;
+        item.instance = i;
+        item.begin = begin;
+        item.end = std::min(begin + chunk_size, num_vertices);
+        m_items.push_back(item);
+    }
+}
+
+//poses, palettes and output buffers of the updated instances, one pose group (see GroupUpdates)
+//per index. Local blends of a group are composed together in the batch of the worker
+class CrowdPoseTask : public RangeTask {
+    public:
+        CrowdPoseTask(Crowd& crowd, int output)
+            : crowd(crowd), output(output) {}
+
+        void Run(int begin, int end, int worker_id) {
+            if (crowd.m_batches[worker_id] == NULL) {
+                crowd.m_batches[worker_id] = new PoseBatch(crowd.m_assets->RestAnimation()->Topology(),
+                                                           &crowd.m_assets->RequiredJoints());
+            }
+            PoseBatch& batch = *crowd.m_batches[worker_id];
+            for (int group = begin; group < end; group++) {
+                int first = crowd.m_group_first[group];
+                int num_lanes = crowd.m_group_first[group + 1] - first;
+                bool any_local = false;
+                for (int lane = 0; lane < num_lanes; lane++) {
+                    int i = crowd.m_updates[first + lane];
+                    CharacterContext& instance = *crowd.m_instances[i];
+                    //updates of interpolated levels are posed ahead, at the time of the next update
+                    float global_frame = instance.playback.global_frame;
+                    instance.playback.global_frame += crowd.m_lod_states[i].ahead_frames;
+                    instance.BeginFrame(false);
+                    instance.playback.global_frame = global_frame;
+                    if (instance.BlendsLocal()) {
+                        batch.SetLocal(lane, instance.LocalBlend());
+                        any_local = true;
+                    }
+                }
+                if (any_local) {
+                    batch.Compose();
+                }
+                for (int lane = 0; lane < num_lanes; lane++) {
+                    int i = crowd.m_updates[first + lane];
+                    CharacterContext& instance = *crowd.m_instances[i];
+                    if (instance.BlendsLocal()) {
+                        instance.SetComposed(batch, lane);
+                    }
+                    Crowd::InstanceLodState& state = crowd.m_lod_states[i];
+                    const LodLevel& lod = crowd.NodeLevel(i, state.level);
+                    if (state.mode == Crowd::LOD_SKIN_NEXT) {
+                        crowd.ResizeLodBuffers(i, output);
+                    }
+
+                    //interpolation runs between the last two updates, its bounds cover both
+                    Aabb bounds = SkinnedBounds(crowd.m_assets->JointBounds(), instance.Palette());
+                    state.bounds = bounds;
+                    if (state.mode == Crowd::LOD_SKIN_NEXT && state.ahead_frames != 0) {
+                        state.bounds.Add(state.update_bounds);
+                    }
+                    state.update_bounds = bounds;
+                    state.visible = (crowd.m_frustum == NULL)
+                                 || crowd.m_frustum->Intersects(state.bounds.Transformed(crowd.m_world[i]));
+
+                    if (state.visible && state.mode == Crowd::LOD_SKIN) {
+                        instance.PrepareSkin(output, lod.mesh, lod.num_influences);
+                    }
+                }
+            }
+        }
+
+        Crowd& crowd;
+        int output;
+};
+
+//one vertex range of one instance per index: skinned, skinned for a later frame or interpolated
+class CrowdSkinTask : public RangeTask {
+    public:
+        CrowdSkinTask(Crowd& crowd, int output)
+            : crowd(crowd), output(output) {}
+
+        void Run(int begin, int end, int worker_id) {
+            for (int index = begin; index < end; index++) {
+                const Crowd::WorkItem& item = crowd.m_items[index];
+                Crowd::InstanceLodState& state = crowd.m_lod_states[item.instance];
+                CharacterContext& instance = *crowd.m_instances[item.instance];
+                //with a job graph chunks of updated instances are there before it is known if they are culled
+                if (!state.visible) continue;
+
+                if (state.mode == Crowd::LOD_SKIN) {
+                    instance.SkinRange(item.begin, item.end);
+                } else if (state.mode == Crowd::LOD_SKIN_NEXT) {
+                    const LodLevel& lod = crowd.NodeLevel(item.instance, state.level);
+                    float* normals = (state.next_normals.empty()) ? NULL : &state.next_normals[item.begin * 3];
+                    SkinMeshPaletteRange(lod.mesh, instance.Palette(), output, &state.next_positions[item.begin * 3],
+                                         normals, item.begin, item.end, lod.num_influences);
+                    //the update after entering a level is drawn a frame into its interval
+                    if (state.frames_since_update > 0) {
+                        InterpolateRange(state, item.begin, item.end);
+                    }
+                } else {
+                    InterpolateRange(state, item.begin, item.end);
+                }
+            }
+        }
+
+        void InterpolateRange(Crowd::InstanceLodState& state, int begin, int end) {
+            float alpha = (float)state.frames_since_update / crowd.m_lods.Level(state.level).update_interval;
+            Interpolate(state.prev_positions, state.next_positions, alpha, state.positions, begin, end);
+            if (!state.normals.empty()) {
+                Interpolate(state.prev_normals, state.next_normals, alpha, state.normals, begin, end);
+            }
+        }
+
+        static void Interpolate(const std::vector<float>& from, const std::vector<float>& to, float alpha,
+                                std::vector<float>& out, int begin, int end) {
+            for (int i = begin * 3; i < end * 3; i++) {
+                out[i] = from[i] + (to[i] - from[i]) * alpha;
+            }
+        }
+
+        Crowd& crowd;
+        int output;
+};
+
+void Crowd::Evaluate(WorkerPool& pool, int skin_output, Vector3 camera_position, const Frustum* frustum, int chunk_size) {
+    if (m_instances.empty()) {
+        return;
+    }
+    chunk_size = std::max(1, chunk_size);
+    m_frustum = frustum;
+    {
+        TRACE_SCOPE("crowd lod");
+        SelectLods(skin_output, camera_position);
+    }
+    {
+        TRACE_SCOPE("crowd poses");
+        if ((int)m_batches.size() < pool.NumThreads()) {
+            m_batches.resize(pool.NumThreads(), NULL);
+        }
+        GroupUpdates();
+        int num_groups = NumGroups();
+        CrowdPoseTask task(*this, skin_output);
+        pool.ParallelFor(num_groups, std::max(1, num_groups / (pool.NumThreads() * 4)), &task);
+    }
+    {
+        TRACE_SCOPE("crowd culling");
+        CollectWork(chunk_size);
+    }
+    {
+        TRACE_SCOPE("crowd skinning");
+        CrowdSkinTask task(*this, skin_output);
+        pool.ParallelFor(m_items.size(), 1, &task);
+    }
+    SetDrawBuffers();
+}
+
+void Crowd::Evaluate(JobSystem& jobs, int skin_output, Vector3 camera_position, const Frustum* frustum, int chunk_size) {
+    if (m_instances.empty()) {
+        return;
+    }
+    chunk_size = std::max(1, chunk_size);
+    m_frustum = frustum;
+    {
+        TRACE_SCOPE("crowd lod");
+        SelectLods(skin_output, camera_position);
+    }
+
+    TRACE_SCOPE("crowd jobs");
+    if ((int)m_batches.size() < jobs.NumThreads()) {
+        m_batches.resize(jobs.NumThreads(), NULL);
+    }
+    GroupUpdates();
+    CrowdPoseTask pose_task(*this, skin_output);
+    CrowdSkinTask skin_task(*this, skin_output);
+    m_graph.Clear();
+
+    //a job per pose group, then the chunks of every instance which may be visible. Sharded, the
+    //jobs of an instance are bound to its node
+    m_pose_jobs.assign(NumInstances(), -1);
+    for (int group = 0; group < NumGroups(); group++) {
+        int first = m_group_first[group];
+        int node = (m_num_nodes > 1) ? HomeNode(m_updates[first]) : -1;
+        int job = m_graph.Add(&pose_task, group, group + 1, node);
+        for (int k = first; k < m_group_first[group + 1]; k++) {
+            m_pose_jobs[m_updates[k]] = job;
+        }
+    }
+    m_items.clear();
+    for (int i = 0; i < NumInstances(); i++) {
+        CullInterpolated(i);
+        if (m_pose_jobs[i] == -1 && !m_lod_states[i].visible) continue;
+        int first_item = m_items.size();
+        AddWork(i, chunk_size);
+        int node = (m_num_nodes > 1) ? HomeNode(i) : -1;
+        for (int index = first_item; index < (int)m_items.size(); index++) {
+            int job = m_graph.Add(&skin_task, index, index + 1, node);
+            if (m_pose_jobs[i] != -1) {
+                m_graph.Depend(job, m_pose_jobs[i]);
+            }
+        }
+    }
+    jobs.Run(m_graph);
+
+    for (int i = 0; i < NumInstances(); i++) {
+        CountWork(i);
+    }
+    SetDrawBuffers();
+}
+
+//where the vertices of every instance are drawn from in this frame
+void Crowd::SetDrawBuffers() {
+    for (int i = 0; i < NumInstances(); i++) {
+        InstanceLodState& state = m_lod_states[i];
+        if (!state.visible) {
+            state.draw_positions = NULL;
+            state.draw_normals = NULL;
+        } else if (state.mode == LOD_SKIN) {
+            state.draw_positions = m_instances[i]->Positions();
+            state.draw_normals = m_instances[i]->Normals();
+        } else {
+            //an update draws the result of the previous one, unless the level was just entered. The one
+            //after that is interpolated like the frames in between
+            bool first_update = (state.mode == LOD_SKIN_NEXT && state.ahead_frames == 0);
+            bool interpolated = (state.mode == LOD_INTERPOLATE || state.frames_since_update > 0);
+            std::vector<float>& positions = (interpolated) ? state.positions
+                                          : (first_update) ? state.next_positions : state.prev_positions;
+            std::vector<float>& normals = (interpolated) ? state.normals
+                                        : (first_update) ? state.next_normals : state.prev_normals;
+            state.draw_positions = &positions[0];
+            state.draw_normals = (normals.empty()) ? NULL : &normals[0];
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+
+//offset from block at which an allocation with this alignment can start
+static size_t AlignedOffset(char* block, size_t offset, size_t alignment) {
+    size_t address = (size_t)(block + offset);
+    size_t aligned = (address + alignment - 1) & ~(alignment - 1);
+    return offset + (aligned - address);
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : m_block(NULL)
+    , m_capacity(0)
+    , m_used(0)
+    , m_overflow_bytes(0)
+    , m_high_water(0) {
+    if (capacity > 0) {
+        m_block = new char[capacity];
+        m_capacity = capacity;
+    }
+}
+
+FrameArena::~FrameArena() {
+    for (size_t i = 0; i < m_overflow.size(); i++) {
+        delete[] m_overflow[i];
+    }
+    delete[] m_block;
+}
+
+void FrameArena::Reset() {
+    size_t frame_bytes = m_used + m_overflow_bytes;
+    m_high_water = std::max(m_high_water, frame_bytes);
+
+    for (size_t i = 0; i < m_overflow.size(); i++) {
+        delete[] m_overflow[i];
+    }
+    m_overflow.clear();
+    m_overflow_bytes = 0;
+    m_used = 0;
+
+    //next frame of the same size fits in one block, rounded up to pages
+    if (frame_bytes > m_capacity) {
+        delete[] m_block;
+        m_capacity = (frame_bytes + 4095) & ~(size_t)4095;
+        m_block = new char[m_capacity];
+    }
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment) {
+    if (m_block != NULL) {
+        size_t offset = AlignedOffset(m_block, m_used, alignment);
+        if (offset + bytes <= m_capacity) {
+            m_used = offset + bytes;
+            return m_block + offset;
+        }
+    }
+
+    //doesn't fit, kept until Reset
+    char* block = new char[bytes + alignment];
+    m_overflow.push_back(block);
+    m_overflow_bytes += bytes + alignment;
+    return block + AlignedOffset(block, 0, alignment);
+}
+
+size_t FrameArena::Used() {
+    return m_used + m_overflow_bytes;
+}
+
+size_t FrameArena::Capacity() {
+    return m_capacity;
+}
+
+size_t FrameArena::HighWater() {
+    return std::max(m_high_water, Used());
+}
+
+WorkerArenas::WorkerArenas(int num_workers) {
+    for (int i = 0; i < num_workers; i++) {
+        m_arenas.push_back(new PaddedArena());
+    }
+}
+
+WorkerArenas::~WorkerArenas() {
+    for (size_t i = 0; i < m_arenas.size(); i++) {
+        delete m_arenas[i];
+    }
+}
+
+int WorkerArenas::NumWorkers() {
+    return m_arenas.size();
+}
+
+FrameArena& WorkerArenas::Get(int worker_id) {
+    return m_arenas[worker_id]->arena;
+}
+
+void WorkerArenas::Reset() {
+    for (size_t i = 0; i < m_arenas.size(); i++) {
+        m_arenas[i]->arena.Reset();
+    }
+}
+
+size_t WorkerArenas::HighWater() {
+    size_t total = 0;
+    for (size_t i = 0; i < m_arenas.size(); i++) {
+        total += m_arenas[i]->arena.HighWater();
+    }
+    return total;
+}
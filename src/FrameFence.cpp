@@ -0,0 +1,72 @@
+#include "FrameFence.h"
+
+#include <sched.h>
+
+//yields before the waiting thread goes to sleep, enough to catch a fence which is about to be signalled
+static const int SPIN_COUNT = 64;
+
+FrameFence::FrameFence()
+    : m_value(0)
+    , m_cancelled(0)
+    , m_num_sleeping(0) {
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+}
+
+FrameFence::~FrameFence() {
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void FrameFence::Signal(int value) {
+    int current;
+    do {
+        current = __sync_fetch_and_add(&m_value, 0);
+        if (value <= current) {
+            return;
+        }
+    } while (!__sync_bool_compare_and_swap(&m_value, current, value));
+
+    pthread_mutex_lock(&m_mutex);
+    if (m_num_sleeping > 0) {
+        pthread_cond_broadcast(&m_cond);
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+int FrameFence::Value() {
+    return __sync_fetch_and_add(&m_value, 0);
+}
+
+bool FrameFence::Reached(int value) {
+    return Value() >= value;
+}
+
+bool FrameFence::Wait(int value) {
+    for (int i = 0; i < SPIN_COUNT; i++) {
+        if (__sync_fetch_and_add(&m_cancelled, 0)) return false;
+        if (Reached(value)) return true;
+        sched_yield();
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    m_num_sleeping++;
+    while (!__sync_fetch_and_add(&m_cancelled, 0) && !Reached(value)) {
+        pthread_cond_wait(&m_cond, &m_mutex);
+    }
+    m_num_sleeping--;
+    pthread_mutex_unlock(&m_mutex);
+    return !__sync_fetch_and_add(&m_cancelled, 0);
+}
+
+void FrameFence::Cancel() {
+    __sync_lock_test_and_set(&m_cancelled, 1);
+    pthread_mutex_lock(&m_mutex);
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void FrameFence::Reset(int value) {
+    __sync_lock_test_and_set(&m_value, value);
+    __sync_lock_test_and_set(&m_cancelled, 0);
+}
@@ -0,0 +1,63 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "Timer.h"
+
+//with vsync frames start this much early, the swap waits for the rest
+static const double VSYNC_SLACK = 0.002;
+
+FramePacer::FramePacer()
+    : m_period(1.0 / 60.0)
+    , m_vsync(false)
+    , m_next(0) {}
+
+void FramePacer::SetTargetRate(double rate) {
+    m_period = (rate > 0) ? 1.0 / rate : 0.0;
+}
+
+double FramePacer::TargetRate() const {
+    return (m_period > 0) ? 1.0 / m_period : 0.0;
+}
+
+void FramePacer::SetVsync(bool vsync) {
+    m_vsync = vsync;
+}
+
+bool FramePacer::Vsync() const {
+    return m_vsync;
+}
+
+void FramePacer::FrameStarted(double now) {
+    m_next += m_period;
+    if (m_next + m_period < now) {
+        //behind by more than a frame, the missed ones are dropped
+        m_next = now + m_period;
+    }
+    m_next = std::max(m_next, now);
+}
+
+double FramePacer::Delay(double now) const {
+    double due = (m_vsync) ? m_next - VSYNC_SLACK : m_next;
+    return std::max(0.0, due - now);
+}
+
+void FramePacer::SleepUntilDue() const {
+    double delay;
+    while ((delay = Delay(TimeSeconds())) > 0) {
+#ifdef _WIN32
+        Sleep((DWORD)(delay * 1000.0));
+#else
+        struct timespec duration;
+        duration.tv_sec = (time_t)delay;
+        duration.tv_nsec = (long)((delay - duration.tv_sec) * 1e9);
+        nanosleep(&duration, NULL);
+#endif
+    }
+}
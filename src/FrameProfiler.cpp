@@ -0,0 +1,134 @@
+#include "FrameProfiler.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+FrameProfiler::FrameProfiler()
+    : m_frame_start(TimeSeconds())
+    , m_window_next(0) {
+    memset(&m_current, 0, sizeof(m_current));
+    m_window.reserve(WINDOW);
+}
+
+const char* FrameProfiler::StageName(int stage) {
+    switch (stage) {
+        case STAGE_UPDATE:   return "update";
+        case STAGE_POSE:     return "pose";
+        case STAGE_SKINNING: return "skinning";
+        case STAGE_BUFFERS:  return "buffers";
+        case STAGE_SUBMIT:   return "submit";
+        case STAGE_SWAP:     return "swap";
+        default:             return "frame";
+    }
+}
+
+void FrameProfiler::AddStageTime(int stage, double seconds) {
+    m_current.stages[stage] += seconds;
+}
+
+void FrameProfiler::EndFrame() {
+    double now = TimeSeconds();
+    m_current.stages[NUM_FRAME_STAGES] = now - m_frame_start;
+    m_frame_start = now;
+
+    if ((int)m_window.size() < WINDOW) {
+        m_window.push_back(m_current);
+    } else {
+        m_window[m_window_next] = m_current;
+    }
+    m_window_next = (m_window_next + 1) % WINDOW;
+
+    if ((int)m_log.size() < MAX_LOGGED_FRAMES) {
+        m_log.push_back(m_current);
+    }
+
+    memset(&m_current, 0, sizeof(m_current));
+}
+
+double FrameProfiler::Min(int stage) {
+    if (m_window.empty()) return 0;
+    double result = m_window[0].stages[stage];
+    for (size_t i = 1; i < m_window.size(); i++) {
+        result = std::min(result, (double)m_window[i].stages[stage]);
+    }
+    return result;
+}
+
+double FrameProfiler::Avg(int stage) {
+    if (m_window.empty()) return 0;
+    double sum = 0;
+    for (size_t i = 0; i < m_window.size(); i++) {
+        sum += m_window[i].stages[stage];
+    }
+    return sum / m_window.size();
+}
+
+double FrameProfiler::P99(int stage) {
+    if (m_window.empty()) return 0;
+    std::vector<float>& samples = m_scratch;
+    samples.resize(m_window.size());
+    for (size_t i = 0; i < m_window.size(); i++) {
+        samples[i] = m_window[i].stages[stage];
+    }
+    size_t rank = std::min(samples.size() - 1, (size_t)(samples.size() * 0.99));
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+std::vector<std::string> FrameProfiler::SummaryLines() {
+    std::vector<std::string> lines;
+    char line[128];
+    for (int stage = 0; stage <= NUM_FRAME_STAGES; stage++) {
+        snprintf(line, sizeof(line), "%-9s min %6.2f  avg %6.2f  p99 %6.2f ms", StageName(stage),
+                 Min(stage) * 1000, Avg(stage) * 1000, P99(stage) * 1000);
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+bool FrameProfiler::WriteLog(std::string filename) {
+    FILE* f = fopen(filename.c_str(), "w");
+    if (f == NULL) {
+        return false;
+    }
+
+    bool json = filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0;
+    if (json) {
+        //columns once, then one array of milliseconds per frame
+        fprintf(f, "{\n  \"unit\": \"ms\",\n  \"columns\": [");
+        for (int stage = 0; stage <= NUM_FRAME_STAGES; stage++) {
+            fprintf(f, "\"%s\"%s", StageName(stage), (stage < NUM_FRAME_STAGES) ? ", " : "");
+        }
+        fprintf(f, "],\n  \"frames\": [\n");
+        for (size_t i = 0; i < m_log.size(); i++) {
+            fprintf(f, "    [");
+            for (int stage = 0; stage <= NUM_FRAME_STAGES; stage++) {
+                fprintf(f, "%.4f%s", m_log[i].stages[stage] * 1000, (stage < NUM_FRAME_STAGES) ? ", " : "");
+            }
+            fprintf(f, "]%s\n", (i + 1 < m_log.size()) ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+    } else {
+        fprintf(f, "frame");
+        for (int stage = 0; stage <= NUM_FRAME_STAGES; stage++) {
+            fprintf(f, ",%s_ms", StageName(stage));
+        }
+        fprintf(f, "\n");
+        for (size_t i = 0; i < m_log.size(); i++) {
+            fprintf(f, "%d", (int)i);
+            for (int stage = 0; stage <= NUM_FRAME_STAGES; stage++) {
+                fprintf(f, ",%.4f", m_log[i].stages[stage] * 1000);
+            }
+            fprintf(f, "\n");
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+
+FrameProfiler& GlobalFrameProfiler() {
+    static FrameProfiler profiler;
+    return profiler;
+}
@@ -0,0 +1,52 @@
+#include "Frustum.h"
+
+#include <math.h>
+
+static Vector4 Plane(Vector3 normal, Vector3 point) {
+    normal = Vector3::Normalize(normal);
+    return Vector4(normal, -Vector3::Dot(normal, point));
+}
+
+Frustum::Frustum(Camera& camera, float aspect) {
+    Vector3 position = camera.GetPosition();
+    Vector3 forward = camera.GetDirection();
+    Vector3 right = Vector3::Normalize(Vector3::Cross(forward, Vector3(0, 1, 0)));
+    Vector3 up = Vector3::Cross(right, forward);
+
+    float tan_height = tan(camera.GetFOV() * 0.5f);
+    float tan_width = tan_height * aspect;
+
+    m_planes[0] = Plane(forward, position + forward * camera.GetNearClipPlane());
+    m_planes[1] = Plane(-forward, position + forward * camera.GetFarClipPlane());
+    m_planes[2] = Plane(forward * tan_width + right, position);
+    m_planes[3] = Plane(forward * tan_width - right, position);
+    m_planes[4] = Plane(forward * tan_height + up, position);
+    m_planes[5] = Plane(forward * tan_height - up, position);
+}
+
+bool Frustum::Intersects(const Aabb& box) const {
+    if (box.empty) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        const Vector4& plane = m_planes[i];
+        //corner furthest along the normal
+        Vector3 corner((plane.x >= 0) ? box.upper.x : box.lower.x,
+                       (plane.y >= 0) ? box.upper.y : box.lower.y,
+                       (plane.z >= 0) ? box.upper.z : box.lower.z);
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::Intersects(Vector3 center, float radius) const {
+    for (int i = 0; i < 6; i++) {
+        const Vector4& plane = m_planes[i];
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -23,18 +23,18 @@ Mesh::~Mesh() {
     delete[] m_triangles;
 }
 
-int Mesh::NumVertices() {
+int Mesh::NumVertices() const {
     return m_num_vertices;
 }
 
-int Mesh::NumTriangles() {
+int Mesh::NumTriangles() const {
     return m_num_triangles;
 }
 
-int Mesh::GetIndex(int i) {
+int Mesh::GetIndex(int i) const {
     return m_triangles[i];
 }
 
-Vertex Mesh::GetVertex(int i) {
+Vertex Mesh::GetVertex(int i) const {
     return m_vertices[i];
 }
@@ -0,0 +1,383 @@
+#include "JobSystem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <algorithm>
+
+#include "Timer.h"
+#include "Trace.h"
+
+JobGraph::JobGraph() {}
+
+void JobGraph::Clear() {
+    m_jobs.clear();
+    m_edges.clear();
+}
+
+int JobGraph::Add(RangeTask* task, int begin, int end, int node) {
+    Job job;
+    job.task = task;
+    job.begin = begin;
+    job.end = end;
+    job.node = node;
+    job.num_dependencies = 0;
+    m_jobs.push_back(job);
+    return (int)m_jobs.size() - 1;
+}
+
+void JobGraph::Depend(int job, int before) {
+    Edge edge;
+    edge.before = before;
+    edge.job = job;
+    m_edges.push_back(edge);
+    m_jobs[job].num_dependencies++;
+}
+
+int JobGraph::NumJobs() const {
+    return (int)m_jobs.size();
+}
+
+JobWorkerStats::JobWorkerStats()
+    : jobs(0)
+    , steals(0)
+    , busy_seconds(0.0) {}
+
+struct JobWorkerStart {
+    JobSystem* jobs;
+    int worker_id;
+};
+
+JobSystem::JobSystem(int num_threads, const NumaTopology* numa)
+    : m_num_threads(std::max(1, num_threads))
+    , m_generation(0)
+    , m_num_working(0)
+    , m_quit(false)
+    , m_num_nodes(1)
+    , m_caller_pinned(false)
+    , m_graph(NULL)
+    , m_num_done(0)
+    , m_run_seconds(0.0) {
+
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_start_cond, NULL);
+    pthread_cond_init(&m_done_cond, NULL);
+
+    for (int i = 0; i < m_num_threads; i++) {
+        WorkerQueue* queue = new WorkerQueue();
+        queue->top = 0;
+        queue->bottom = 0;
+        queue->lock = 0;
+        m_queues.push_back(queue);
+    }
+
+    //workers dealt out over the nodes, a node without workers has nobody to run its jobs
+    if (numa != NULL) {
+        m_num_nodes = std::max(1, std::min(numa->NumNodes(), m_num_threads));
+    }
+    //workers on nodes they can't be pinned to would place their memory anywhere anyway
+    if (m_num_nodes > 1 && !CanPinThreads(*numa)) {
+        printf("[WARNING]: Failed to pin threads to NUMA nodes, jobs run unpinned and unsharded.\n");
+        m_num_nodes = 1;
+    }
+    m_node_workers.resize(m_num_nodes);
+    m_next_worker.assign(m_num_nodes, 0);
+    for (int i = 0; i < m_num_threads; i++) {
+        m_worker_nodes.push_back(i % m_num_nodes);
+        m_node_workers[i % m_num_nodes].push_back(i);
+    }
+    if (m_num_nodes > 1) {
+        for (int node = 0; node < m_num_nodes; node++) {
+            m_node_cpus.push_back(numa->Cpus(node));
+        }
+    }
+
+    //worker 0 is the calling thread
+    m_threads.resize(m_num_threads - 1);
+    for (int i = 1; i < m_num_threads; i++) {
+        JobWorkerStart* start = new JobWorkerStart();
+        start->jobs = this;
+        start->worker_id = i;
+        if (pthread_create(&m_threads[i - 1], NULL, ThreadMain, start) != 0) {
+            printf("[ERROR]: Failed to create job worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+JobSystem::~JobSystem() {
+    pthread_mutex_lock(&m_mutex);
+    m_quit = true;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (size_t i = 0; i < m_threads.size(); i++) {
+        pthread_join(m_threads[i], NULL);
+    }
+    for (size_t i = 0; i < m_queues.size(); i++) {
+        delete m_queues[i];
+    }
+
+    pthread_cond_destroy(&m_done_cond);
+    pthread_cond_destroy(&m_start_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+int JobSystem::NumThreads() {
+    return m_num_threads;
+}
+
+int JobSystem::NumNodes() {
+    return m_num_nodes;
+}
+
+int JobSystem::WorkerNode(int worker_id) {
+    return m_worker_nodes[worker_id];
+}
+
+void* JobSystem::ThreadMain(void* arg) {
+    JobWorkerStart* start = (JobWorkerStart*)arg;
+    JobSystem* jobs = start->jobs;
+    int worker_id = start->worker_id;
+    delete start;
+    TRACE_THREAD_NAME("job worker");
+    if (jobs->m_num_nodes > 1 && !PinThread(jobs->m_node_cpus[jobs->m_worker_nodes[worker_id]])) {
+        //its jobs still run, only away from their memory
+        printf("[WARNING]: Failed to pin job worker %d to NUMA node %d.\n", worker_id, jobs->m_worker_nodes[worker_id]);
+    }
+
+    int seen_generation = 0;
+    pthread_mutex_lock(&jobs->m_mutex);
+    while (true) {
+        while (!jobs->m_quit && jobs->m_generation == seen_generation) {
+            pthread_cond_wait(&jobs->m_start_cond, &jobs->m_mutex);
+        }
+        if (jobs->m_quit) {
+            break;
+        }
+        seen_generation = jobs->m_generation;
+        pthread_mutex_unlock(&jobs->m_mutex);
+
+        jobs->Work(worker_id);
+
+        pthread_mutex_lock(&jobs->m_mutex);
+        jobs->m_num_working--;
+        if (jobs->m_num_working == 0) {
+            pthread_cond_signal(&jobs->m_done_cond);
+        }
+    }
+    pthread_mutex_unlock(&jobs->m_mutex);
+    return NULL;
+}
+
+static void LockQueue(volatile int* lock) {
+    while (__sync_lock_test_and_set(lock, 1)) {
+        while (__sync_fetch_and_add(lock, 0)) {
+            sched_yield();
+        }
+    }
+}
+
+static void UnlockQueue(volatile int* lock) {
+    __sync_lock_release(lock);
+}
+
+void JobSystem::Push(int worker_id, int job) {
+    WorkerQueue& queue = *m_queues[worker_id];
+    LockQueue(&queue.lock);
+    queue.jobs[queue.bottom++] = job;
+    UnlockQueue(&queue.lock);
+}
+
+bool JobSystem::Pop(int worker_id, int& job) {
+    WorkerQueue& queue = *m_queues[worker_id];
+    LockQueue(&queue.lock);
+    bool found = queue.bottom > queue.top;
+    if (found) {
+        job = queue.jobs[--queue.bottom];
+    }
+    UnlockQueue(&queue.lock);
+    return found;
+}
+
+//tries every other worker once, starting after this one so thieves spread over the victims.
+//Workers of the same node first, from the others only jobs which aren't bound to their node
+bool JobSystem::Steal(int worker_id, int& job) {
+    int node = m_worker_nodes[worker_id];
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 1; i < m_num_threads; i++) {
+            int victim_id = (worker_id + i) % m_num_threads;
+            bool local = (m_worker_nodes[victim_id] == node);
+            if (local != (pass == 0)) continue;
+            WorkerQueue& victim = *m_queues[victim_id];
+            LockQueue(&victim.lock);
+            bool found = victim.bottom > victim.top
+                      && (local || m_graph->m_jobs[victim.jobs[victim.top]].node < 0);
+            if (found) {
+                job = victim.jobs[victim.top++];
+            }
+            UnlockQueue(&victim.lock);
+            if (found) {
+                m_queues[worker_id]->stats.steals++;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void JobSystem::Execute(int job, int worker_id) {
+    const JobGraph::Job& info = m_graph->m_jobs[job];
+    WorkerQueue& queue = *m_queues[worker_id];
+    double start = TimeSeconds();
+    {
+        TRACE_SCOPE("job");
+        info.task->Run(info.begin, info.end, worker_id);
+    }
+    queue.stats.busy_seconds += TimeSeconds() - start;
+    queue.stats.jobs++;
+
+    //released jobs before the count, so nobody sees the run done while they are pending.
+    //A job of another node goes to one of its workers instead
+    for (int i = m_first_successor[job]; i < m_first_successor[job + 1]; i++) {
+        int successor = m_successors[i];
+        if (__sync_sub_and_fetch(&m_remaining[successor], 1) == 0) {
+            int node = m_graph->m_jobs[successor].node;
+            if (node < 0 || node % m_num_nodes == m_worker_nodes[worker_id]) {
+                Push(worker_id, successor);
+            } else {
+                const std::vector<int>& workers = m_node_workers[node % m_num_nodes];
+                Push(workers[successor % workers.size()], successor);
+            }
+        }
+    }
+    __sync_fetch_and_add(&m_num_done, 1);
+}
+
+void JobSystem::Work(int worker_id) {
+    int num_jobs = m_graph->NumJobs();
+    while (__sync_fetch_and_add(&m_num_done, 0) < num_jobs) {
+        int job;
+        if (Pop(worker_id, job) || Steal(worker_id, job)) {
+            Execute(job, worker_id);
+        } else {
+            //what is left waits for jobs running on other workers
+            sched_yield();
+        }
+    }
+}
+
+void JobSystem::Run(JobGraph& graph) {
+    int num_jobs = graph.NumJobs();
+    if (num_jobs == 0) {
+        return;
+    }
+    double start = TimeSeconds();
+    if (m_num_nodes > 1 && !(m_caller_pinned && pthread_equal(m_caller, pthread_self()))) {
+        if (!PinThread(m_node_cpus[0])) {
+            printf("[WARNING]: Failed to pin the calling thread to NUMA node 0.\n");
+        }
+        m_caller = pthread_self();
+        m_caller_pinned = true;
+    }
+
+    //successors of every job in one array, by job
+    m_first_successor.assign(num_jobs + 1, 0);
+    for (size_t i = 0; i < graph.m_edges.size(); i++) {
+        m_first_successor[graph.m_edges[i].before + 1]++;
+    }
+    for (int job = 0; job < num_jobs; job++) {
+        m_first_successor[job + 1] += m_first_successor[job];
+    }
+    m_successors.resize(graph.m_edges.size());
+    m_remaining.resize(num_jobs);
+    for (int job = 0; job < num_jobs; job++) {
+        m_remaining[job] = m_first_successor[job];
+    }
+    for (size_t i = 0; i < graph.m_edges.size(); i++) {
+        m_successors[m_remaining[graph.m_edges[i].before]++] = graph.m_edges[i].job;
+    }
+
+    //jobs without dependencies are dealt out round robin, over the workers of their node if they have
+    //one, the rest wait for their count to drop
+    int next_queue = 0;
+    for (int i = 0; i < m_num_threads; i++) {
+        WorkerQueue& queue = *m_queues[i];
+        if ((int)queue.jobs.size() < num_jobs) {
+            queue.jobs.resize(num_jobs);
+        }
+        queue.top = 0;
+        queue.bottom = 0;
+    }
+    for (int job = 0; job < num_jobs; job++) {
+        m_remaining[job] = graph.m_jobs[job].num_dependencies;
+        if (m_remaining[job] == 0) {
+            int node = graph.m_jobs[job].node;
+            int worker_id;
+            if (node >= 0) {
+                const std::vector<int>& workers = m_node_workers[node % m_num_nodes];
+                int& next_worker = m_next_worker[node % m_num_nodes];
+                worker_id = workers[next_worker];
+                next_worker = (next_worker + 1) % workers.size();
+            } else {
+                worker_id = next_queue;
+                next_queue = (next_queue + 1) % m_num_threads;
+            }
+            WorkerQueue& queue = *m_queues[worker_id];
+            queue.jobs[queue.bottom++] = job;
+        }
+    }
+    m_graph = &graph;
+    m_num_done = 0;
+
+    if (m_num_threads == 1) {
+        Work(0);
+    } else {
+        pthread_mutex_lock(&m_mutex);
+        m_num_working = m_num_threads - 1;
+        m_generation++;
+        pthread_cond_broadcast(&m_start_cond);
+        pthread_mutex_unlock(&m_mutex);
+
+        Work(0);
+
+        //workers leave once everything is done, the graph has to outlive all of them
+        pthread_mutex_lock(&m_mutex);
+        while (m_num_working > 0) {
+            pthread_cond_wait(&m_done_cond, &m_mutex);
+        }
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    m_graph = NULL;
+    m_run_seconds += TimeSeconds() - start;
+}
+
+void JobSystem::ParallelFor(int count, int chunk_size, RangeTask* task) {
+    chunk_size = std::max(1, chunk_size);
+    m_loop.Clear();
+    for (int begin = 0; begin < count; begin += chunk_size) {
+        m_loop.Add(task, begin, std::min(begin + chunk_size, count));
+    }
+    Run(m_loop);
+}
+
+JobWorkerStats JobSystem::WorkerStats(int worker_id) {
+    return m_queues[worker_id]->stats;
+}
+
+double JobSystem::RunSeconds() {
+    return m_run_seconds;
+}
+
+double JobSystem::Utilization(int worker_id) {
+    if (m_run_seconds <= 0.0) return 0.0;
+    return std::min(1.0, m_queues[worker_id]->stats.busy_seconds / m_run_seconds);
+}
+
+void JobSystem::ResetStats() {
+    for (int i = 0; i < m_num_threads; i++) {
+        m_queues[i]->stats = JobWorkerStats();
+    }
+    m_run_seconds = 0.0;
+}
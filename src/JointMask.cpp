@@ -0,0 +1,86 @@
+#include "JointMask.h"
+
+#include <math.h>
+
+JointMask::JointMask()
+    : m_topology(NULL) {}
+
+void JointMask::Reset(const SkeletonTopology* topology, bool all) {
+    m_topology = topology;
+    m_required.assign(topology->NumJoints(), all);
+    Update();
+}
+
+void JointMask::Require(int joint_id) {
+    bool changed = false;
+    while (joint_id != -1 && !m_required[joint_id]) {
+        m_required[joint_id] = true;
+        joint_id = m_topology->Parent(joint_id);
+        changed = true;
+    }
+    if (changed) {
+        Update();
+    }
+}
+
+void JointMask::Update() {
+    m_order.clear();
+    const std::vector<int>& order = m_topology->TraversalOrder();
+    for (size_t i = 0; i < order.size(); i++) {
+        if (m_required[order[i]]) {
+            m_order.push_back(order[i]);
+        }
+    }
+
+    m_ranges.clear();
+    for (int joint_id = 0; joint_id < NumJoints(); joint_id++) {
+        if (!m_required[joint_id]) continue;
+        if (!m_ranges.empty() && m_ranges.back().second == joint_id) {
+            m_ranges.back().second++;
+        } else {
+            m_ranges.push_back(std::make_pair(joint_id, joint_id + 1));
+        }
+    }
+}
+
+const SkeletonTopology* JointMask::Topology() const {
+    return m_topology;
+}
+
+int JointMask::NumJoints() const {
+    return m_required.size();
+}
+
+int JointMask::NumRequired() const {
+    return m_order.size();
+}
+
+bool JointMask::Required(int joint_id) const {
+    return m_required[joint_id];
+}
+
+const std::vector<int>& JointMask::Order() const {
+    return m_order;
+}
+
+const std::vector<std::pair<int, int> >& JointMask::Ranges() const {
+    return m_ranges;
+}
+
+void RequireSkinnedJoints(JointMask& mask, const Mesh* mesh) {
+    for (int i = 0; i < mesh->NumVertices(); i++) {
+        const Vertex& vertex = mesh->m_vertices[i];
+        for (int j = 0; j < 3; j++) {
+            int joint_id = (int)round(vertex.weight_ids[j]);
+            if (joint_id >= 0 && joint_id < mask.NumJoints()) {
+                mask.Require(joint_id);
+            }
+        }
+    }
+}
+
+void RequireSkeletonJoints(JointMask& mask) {
+    for (int joint_id = 0; joint_id < mask.NumJoints(); joint_id++) {
+        mask.Require(joint_id);
+    }
+}
@@ -0,0 +1,158 @@
+#include "LinearBlending.h"
+
+#include <math.h>
+
+SkinPoses::SkinPoses()
+    : num_poses(0) {}
+
+void SkinPoses::Add(const std::vector<Matrix_4x4>* pose_trans_gb, float weight) {
+    if (weight <= 0 || num_poses == MAX_SKIN_POSES) {
+        return;
+    }
+    trans_gb[num_poses] = pose_trans_gb;
+    weights[num_poses] = weight;
+    num_poses++;
+}
+
+//Normalise weights components to one, otherwise strange artifacts
+Vector3 NormSumToOne(Vector3 v) {
+    //assumes that all components of v are positive;
+    float sum = v.x + v.y + v.z;
+    return Vector3(v.x/sum, v.y/sum, v.z/sum);
+}
+
+//must be called after rest_trans_lc has been initialised
+Vertex LinearBlending(const Vertex& original, const std::vector<Matrix_4x4>& anim_trans_gb, const std::vector<Matrix_4x4>& rest_trans_lc, int output) {
+    Vector3 pos = Vector3::Zero();
+    Vector3 norm = Vector3::Zero();
+    Vector3 weight_amounts = NormSumToOne(original.weight_amounts);
+    for (int j = 0; j < 3; j++) {
+        int joint_id = (int)round(original.weight_ids[j]);
+        float weight = weight_amounts[j];
+        Matrix_4x4 trans =  anim_trans_gb[joint_id] * rest_trans_lc[joint_id];
+        if (output & SKIN_OUTPUT_POSITIONS) {
+            pos += (trans * original.position * weight);
+        }
+        if (output & SKIN_OUTPUT_NORMALS) {
+            Matrix_3x3 rot = Matrix_4x4::ToMatrix_3x3(trans);
+            norm += (rot * original.normal * weight);
+        }
+    }
+    return Vertex(pos, norm);
+}
+
+void SkinMesh(const Mesh* mesh, const std::vector<Matrix_4x4>& rest_trans_lc, const SkinPoses& poses, int output,
+              float* positions, float* normals) {
+    SkinMeshRange(mesh, rest_trans_lc, poses, output, positions, normals, 0, mesh->NumVertices());
+}
+
+void SkinMeshRange(const Mesh* mesh, const std::vector<Matrix_4x4>& rest_trans_lc, const SkinPoses& poses, int output,
+                   float* positions, float* normals, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        const Vertex& original = mesh->m_vertices[i];
+        Vector3 pos = Vector3::Zero();
+        Vector3 norm = Vector3::Zero();
+        for (int p = 0; p < poses.num_poses; p++) {
+            Vertex vrtx = LinearBlending(original, *poses.trans_gb[p], rest_trans_lc, output);
+            pos += vrtx.position * poses.weights[p];
+            norm += vrtx.normal * poses.weights[p];
+        }
+
+        if (output & SKIN_OUTPUT_POSITIONS) {
+            positions[(i*3)+0] = pos.x;
+            positions[(i*3)+1] = pos.y;
+            positions[(i*3)+2] = pos.z;
+        }
+        if (output & SKIN_OUTPUT_NORMALS) {
+            normals[(i*3)+0] = norm.x;
+            normals[(i*3)+1] = norm.y;
+            normals[(i*3)+2] = norm.z;
+        }
+    }
+}
+
+//weighted sum of the pose transforms of the joint times its rest local transform
+static Matrix_4x4 PaletteEntry(const SkinPoses& poses, const std::vector<Matrix_4x4>& rest_trans_lc, int joint_id) {
+    Matrix_4x4 blended = Matrix_4x4::Zero();
+    for (int p = 0; p < poses.num_poses; p++) {
+        blended = blended + (*poses.trans_gb[p])[joint_id] * poses.weights[p];
+    }
+    return blended * rest_trans_lc[joint_id];
+}
+
+void ComputeSkinPalette(const SkinPoses& poses, const std::vector<Matrix_4x4>& rest_trans_lc, Matrix_4x4* palette,
+                        const JointMask* mask) {
+    if (mask == NULL) {
+        for (size_t joint_id = 0; joint_id < rest_trans_lc.size(); joint_id++) {
+            palette[joint_id] = PaletteEntry(poses, rest_trans_lc, joint_id);
+        }
+        return;
+    }
+    const std::vector<int>& order = mask->Order();
+    for (size_t i = 0; i < order.size(); i++) {
+        palette[order[i]] = PaletteEntry(poses, rest_trans_lc, order[i]);
+    }
+}
+
+void SkinMeshPalette(const Mesh* mesh, const Matrix_4x4* palette, int output, float* positions, float* normals) {
+    SkinMeshPaletteRange(mesh, palette, output, positions, normals, 0, mesh->NumVertices());
+}
+
+void SkinMeshPaletteRange(const Mesh* mesh, const Matrix_4x4* palette, int output,
+                          float* positions, float* normals, int begin, int end, int num_influences) {
+    for (int i = begin; i < end; i++) {
+        const Vertex& original = mesh->m_vertices[i];
+        Vector3 pos = Vector3::Zero();
+        Vector3 norm = Vector3::Zero();
+        Vector3 weight_amounts = NormSumToOne(original.weight_amounts);
+        for (int j = 0; j < num_influences; j++) {
+            const Matrix_4x4& trans = palette[(int)round(original.weight_ids[j])];
+            float weight = weight_amounts[j];
+            if (output & SKIN_OUTPUT_POSITIONS) {
+                pos += (trans * original.position * weight);
+            }
+            if (output & SKIN_OUTPUT_NORMALS) {
+                norm += (Matrix_4x4::ToMatrix_3x3(trans) * original.normal * weight);
+            }
+        }
+
+        int out = (i - begin) * 3;
+        if (output & SKIN_OUTPUT_POSITIONS) {
+            positions[out+0] = pos.x;
+            positions[out+1] = pos.y;
+            positions[out+2] = pos.z;
+        }
+        if (output & SKIN_OUTPUT_NORMALS) {
+            normals[out+0] = norm.x;
+            normals[out+1] = norm.y;
+            normals[out+2] = norm.z;
+        }
+    }
+}
+
+//arguments of SkinMeshRange for the pool
+class SkinMeshTask : public RangeTask {
+    public:
+        SkinMeshTask(const Mesh* mesh, const std::vector<Matrix_4x4>& rest_trans_lc, const SkinPoses& poses, int output,
+                     float* positions, float* normals)
+            : mesh(mesh), rest_trans_lc(rest_trans_lc), poses(poses), output(output)
+            , positions(positions), normals(normals) {}
+
+        void Run(int begin, int end, int worker_id) {
+            SkinMeshRange(mesh, rest_trans_lc, poses, output, positions, normals, begin, end);
+        }
+
+        const Mesh* mesh;
+        const std::vector<Matrix_4x4>& rest_trans_lc;
+        const SkinPoses& poses;
+        int output;
+        float* positions;
+        float* normals;
+};
+
+void SkinMeshParallel(WorkerPool& pool, int chunk_size,
+                      const Mesh* mesh, const std::vector<Matrix_4x4>& rest_trans_lc, const SkinPoses& poses, int output,
+                      float* positions, float* normals) {
+    SkinMeshTask task(mesh, rest_trans_lc, poses, output, positions, normals);
+    pool.ParallelFor(mesh->NumVertices(), chunk_size, &task);
+}
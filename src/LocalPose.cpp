@@ -0,0 +1,263 @@
+#include "LocalPose.h"
+
+#include <math.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+LocalPose::LocalPose() {}
+
+int LocalPose::NumJoints() const {
+    return tx.size();
+}
+
+void LocalPose::Resize(int num_joints) {
+    tx.resize(num_joints);
+    ty.resize(num_joints);
+    tz.resize(num_joints);
+    qx.resize(num_joints);
+    qy.resize(num_joints);
+    qz.resize(num_joints);
+    qw.resize(num_joints);
+}
+
+void LocalPose::FromSkeleton(const Skeleton* skel) {
+    Resize(skel->NumJoints());
+    for (int i = 0; i < skel->NumJoints(); i++) {
+        const Joint& joint = skel->m_joints[i];
+        tx[i] = joint.position.x;
+        ty[i] = joint.position.y;
+        tz[i] = joint.position.z;
+
+        //largest of w, x, y, z is taken from the diagonal, the rest from off diagonal sums
+        const Matrix_4x4& m = joint.rotation;
+        float trace = m.xx + m.yy + m.zz;
+        float x, y, z, w;
+        if (trace > 0) {
+            float s = sqrtf(trace + 1.0f) * 2.0f;
+            w = 0.25f * s;
+            x = (m.zy - m.yz) / s;
+            y = (m.xz - m.zx) / s;
+            z = (m.yx - m.xy) / s;
+        } else if (m.xx > m.yy && m.xx > m.zz) {
+            float s = sqrtf(1.0f + m.xx - m.yy - m.zz) * 2.0f;
+            w = (m.zy - m.yz) / s;
+            x = 0.25f * s;
+            y = (m.xy + m.yx) / s;
+            z = (m.xz + m.zx) / s;
+        } else if (m.yy > m.zz) {
+            float s = sqrtf(1.0f + m.yy - m.xx - m.zz) * 2.0f;
+            w = (m.xz - m.zx) / s;
+            x = (m.xy + m.yx) / s;
+            y = 0.25f * s;
+            z = (m.yz + m.zy) / s;
+        } else {
+            float s = sqrtf(1.0f + m.zz - m.xx - m.yy) * 2.0f;
+            w = (m.yx - m.xy) / s;
+            x = (m.xz + m.zx) / s;
+            y = (m.yz + m.zy) / s;
+            z = 0.25f * s;
+        }
+        qx[i] = x;
+        qy[i] = y;
+        qz[i] = z;
+        qw[i] = w;
+    }
+}
+
+Matrix_4x4 LocalPose::LocalTransform(int i) const {
+    float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+    return Matrix_4x4(1 - 2 * (y * y + z * z), 2 * (x * y - z * w),     2 * (x * z + y * w),     tx[i],
+                      2 * (x * y + z * w),     1 - 2 * (x * x + z * z), 2 * (y * z - x * w),     ty[i],
+                      2 * (x * z - y * w),     2 * (y * z + x * w),     1 - 2 * (x * x + y * y), tz[i],
+                      0,                       0,                       0,                       1);
+}
+
+LocalPoses::LocalPoses()
+    : num_poses(0) {}
+
+void LocalPoses::Add(const LocalPose* pose, float weight) {
+    if (weight <= 0 || num_poses == MAX_SKIN_POSES) {
+        return;
+    }
+    poses[num_poses] = pose;
+    weights[num_poses] = weight;
+    num_poses++;
+}
+
+//joints blended into locals at a time, locals can't alias the poses so the loops vectorize
+//without runtime overlap checks
+static const int BLEND_BLOCK = 32;
+
+//N poses, the first one sets the hemisphere of the rotations. Joints [first, last) only
+template <int N>
+static void BlendN(const LocalPose* const* poses, const float* weights, LocalPose& out, int first, int last) {
+    float tx[BLEND_BLOCK], ty[BLEND_BLOCK], tz[BLEND_BLOCK];
+    float qx[BLEND_BLOCK], qy[BLEND_BLOCK], qz[BLEND_BLOCK], qw[BLEND_BLOCK];
+
+    for (int begin = first; begin < last; begin += BLEND_BLOCK) {
+        int count = std::min(BLEND_BLOCK, last - begin);
+        const LocalPose& a = *poses[0];
+        const float* aqx = &a.qx[begin]; const float* aqy = &a.qy[begin];
+        const float* aqz = &a.qz[begin]; const float* aqw = &a.qw[begin];
+
+        for (int i = 0; i < count; i++) {
+            tx[i] = weights[0] * a.tx[begin + i];
+            ty[i] = weights[0] * a.ty[begin + i];
+            tz[i] = weights[0] * a.tz[begin + i];
+            qx[i] = weights[0] * aqx[i];
+            qy[i] = weights[0] * aqy[i];
+            qz[i] = weights[0] * aqz[i];
+            qw[i] = weights[0] * aqw[i];
+        }
+        for (int p = 1; p < N; p++) {
+            const LocalPose& b = *poses[p];
+            float w = weights[p];
+            const float* btx = &b.tx[begin]; const float* bty = &b.ty[begin]; const float* btz = &b.tz[begin];
+            const float* bqx = &b.qx[begin]; const float* bqy = &b.qy[begin];
+            const float* bqz = &b.qz[begin]; const float* bqw = &b.qw[begin];
+            for (int i = 0; i < count; i++) {
+                tx[i] += w * btx[i];
+                ty[i] += w * bty[i];
+                tz[i] += w * btz[i];
+                float dot = aqx[i] * bqx[i] + aqy[i] * bqy[i] + aqz[i] * bqz[i] + aqw[i] * bqw[i];
+                float sw = (dot < 0) ? -w : w;
+                qx[i] += sw * bqx[i];
+                qy[i] += sw * bqy[i];
+                qz[i] += sw * bqz[i];
+                qw[i] += sw * bqw[i];
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            float inv_length = 1.0f / std::sqrt(qx[i] * qx[i] + qy[i] * qy[i] + qz[i] * qz[i] + qw[i] * qw[i]);
+            qx[i] *= inv_length;
+            qy[i] *= inv_length;
+            qz[i] *= inv_length;
+            qw[i] *= inv_length;
+        }
+
+        memcpy(&out.tx[begin], tx, count * sizeof(float));
+        memcpy(&out.ty[begin], ty, count * sizeof(float));
+        memcpy(&out.tz[begin], tz, count * sizeof(float));
+        memcpy(&out.qx[begin], qx, count * sizeof(float));
+        memcpy(&out.qy[begin], qy, count * sizeof(float));
+        memcpy(&out.qz[begin], qz, count * sizeof(float));
+        memcpy(&out.qw[begin], qw, count * sizeof(float));
+    }
+}
+
+//quaternions as (x, y, z, w), a * b rotates by b first as the matrices do
+struct Quat {
+    float x, y, z, w;
+};
+
+static Quat Multiply(const Quat& a, const Quat& b) {
+    Quat q;
+    q.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+    q.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+    q.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+    q.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+    return q;
+}
+
+static Quat Conjugate(const Quat& q) {
+    Quat c = {-q.x, -q.y, -q.z, q.w};
+    return c;
+}
+
+static Vector3 Rotate(const Quat& q, const Vector3& v) {
+    Quat p = {v.x, v.y, v.z, 0};
+    Quat r = Multiply(Multiply(q, p), Conjugate(q));
+    return Vector3(r.x, r.y, r.z);
+}
+
+static Quat Rotation(const LocalPose& pose, int joint_id) {
+    Quat q = {pose.qx[joint_id], pose.qy[joint_id], pose.qz[joint_id], pose.qw[joint_id]};
+    return q;
+}
+
+static Vector3 Translation(const LocalPose& pose, int joint_id) {
+    return Vector3(pose.tx[joint_id], pose.ty[joint_id], pose.tz[joint_id]);
+}
+
+//joint_id, a child of root, blended in model space and made local to the blended root in out
+static void BlendInModelSpace(const LocalPoses& poses, int root, int joint_id, LocalPose& out) {
+    Vector3 t = Vector3::Zero();
+    Quat q = {0, 0, 0, 0};
+    Quat first = {0, 0, 0, 1};
+    for (int p = 0; p < poses.num_poses; p++) {
+        const LocalPose& pose = *poses.poses[p];
+        Quat root_q = Rotation(pose, root);
+        Quat model_q = Multiply(root_q, Rotation(pose, joint_id));
+        Vector3 model_t = Translation(pose, root) + Rotate(root_q, Translation(pose, joint_id));
+        if (p == 0) {
+            first = model_q;
+        }
+        float w = poses.weights[p];
+        float dot = first.x * model_q.x + first.y * model_q.y + first.z * model_q.z + first.w * model_q.w;
+        float sw = (dot < 0) ? -w : w;
+        t += model_t * w;
+        q.x += sw * model_q.x;
+        q.y += sw * model_q.y;
+        q.z += sw * model_q.z;
+        q.w += sw * model_q.w;
+    }
+    float inv_length = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    q.x *= inv_length;
+    q.y *= inv_length;
+    q.z *= inv_length;
+    q.w *= inv_length;
+
+    Quat to_root = Conjugate(Rotation(out, root));
+    Quat local_q = Multiply(to_root, q);
+    Vector3 local_t = Rotate(to_root, t - Translation(out, root));
+    out.tx[joint_id] = local_t.x;
+    out.ty[joint_id] = local_t.y;
+    out.tz[joint_id] = local_t.z;
+    out.qx[joint_id] = local_q.x;
+    out.qy[joint_id] = local_q.y;
+    out.qz[joint_id] = local_q.z;
+    out.qw[joint_id] = local_q.w;
+}
+
+void BlendLocalPoses(const LocalPoses& poses, LocalPose& out, const JointMask* mask,
+                     const SkeletonTopology* topology) {
+    if (poses.num_poses == 0) {
+        return;
+    }
+    const LocalPose& first = *poses.poses[0];
+    out.Resize(first.NumJoints());
+
+    //a copy of whole arrays is cheaper than picking joints out of them
+    if (poses.num_poses == 1) {
+        out.tx = first.tx; out.ty = first.ty; out.tz = first.tz;
+        out.qx = first.qx; out.qy = first.qy; out.qz = first.qz; out.qw = first.qw;
+        return;
+    }
+
+    const LocalPose* padded[MAX_SKIN_POSES];
+    float weights[MAX_SKIN_POSES];
+    for (int p = 0; p < MAX_SKIN_POSES; p++) {
+        padded[p] = (p < poses.num_poses) ? poses.poses[p] : &first;
+        weights[p] = (p < poses.num_poses) ? poses.weights[p] : 0.0f;
+    }
+    int num_ranges = (mask != NULL) ? mask->Ranges().size() : 1;
+    for (int r = 0; r < num_ranges; r++) {
+        int begin = (mask != NULL) ? mask->Ranges()[r].first : 0;
+        int end = (mask != NULL) ? mask->Ranges()[r].second : first.NumJoints();
+        if (poses.num_poses == 2) {
+            BlendN<2>(poses.poses, poses.weights, out, begin, end);
+        } else {
+            BlendN<MAX_SKIN_POSES>(padded, weights, out, begin, end);
+        }
+    }
+
+    if (topology != NULL) {
+        for (int joint_id = 0; joint_id < topology->NumJoints(); joint_id++) {
+            int parent_id = topology->Parent(joint_id);
+            if (parent_id == -1 || topology->Parent(parent_id) != -1) continue;
+            if (mask != NULL && !mask->Required(joint_id)) continue;
+            BlendInModelSpace(poses, parent_id, joint_id, out);
+        }
+    }
+}
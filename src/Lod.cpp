@@ -0,0 +1,224 @@
+#include "Lod.h"
+
+#include <math.h>
+#include <algorithm>
+
+LodConfig::LodConfig()
+    : decimation_cells(24) {
+    distances[0] = 150.0f;
+    distances[1] = 350.0f;
+    influences[0] = 3;
+    influences[1] = 2;
+    influences[2] = 1;
+    update_intervals[0] = 1;
+    update_intervals[1] = 1;
+    update_intervals[2] = 4;
+}
+
+LodSet::LodSet()
+    : m_character(NULL)
+    , m_decimation_cells(0) {
+    m_influences[0] = m_influences[1] = m_influences[2] = 0;
+}
+
+LodSet::~LodSet() {
+    Clear();
+}
+
+void LodSet::Clear() {
+    for (size_t i = 0; i < m_meshes.size(); i++) {
+        delete m_meshes[i];
+    }
+    m_meshes.clear();
+    m_levels.clear();
+}
+
+const Mesh* LodSet::Own(Mesh* mesh) {
+    m_meshes.push_back(mesh);
+    return mesh;
+}
+
+const Mesh* LodSet::BuiltMesh(const LodSet* built, int level, int num_influences, int cells) const {
+    if (built == NULL || built->m_character != m_character || built->m_influences[level] != num_influences
+            || (level == 2 && built->m_decimation_cells != cells)) {
+        return NULL;
+    }
+    return built->m_levels[level].mesh;
+}
+
+void LodSet::Build(const Mesh* character, const LodConfig& config, bool copy_full, const LodSet* built) {
+    Clear();
+    m_character = character;
+    for (int level = 0; level < 3; level++) {
+        m_influences[level] = std::max(1, std::min(config.influences[level], 3));
+    }
+    m_decimation_cells = config.decimation_cells;
+
+    LodLevel full;
+    full.min_distance = 0;
+    full.mesh = (copy_full) ? Own(CopyMesh(character)) : character;
+    full.num_influences = m_influences[0];
+    full.update_interval = std::max(1, config.update_intervals[0]);
+    m_levels.push_back(full);
+
+    LodLevel middle;
+    middle.min_distance = config.distances[0];
+    middle.mesh = BuiltMesh(built, 1, m_influences[1], m_decimation_cells);
+    if (middle.mesh == NULL) {
+        middle.mesh = Own(ReduceInfluences(character, m_influences[1]));
+    } else if (copy_full) {
+        middle.mesh = Own(CopyMesh(middle.mesh));
+    }
+    middle.num_influences = m_influences[1];
+    middle.update_interval = std::max(1, config.update_intervals[1]);
+    m_levels.push_back(middle);
+
+    LodLevel far;
+    far.min_distance = config.distances[1];
+    far.mesh = BuiltMesh(built, 2, m_influences[2], m_decimation_cells);
+    if (far.mesh == NULL) {
+        Mesh* reduced_far = ReduceInfluences(character, m_influences[2]);
+        far.mesh = Own(DecimateMesh(reduced_far, m_decimation_cells));
+        delete reduced_far;
+    } else if (copy_full) {
+        far.mesh = Own(CopyMesh(far.mesh));
+    }
+    far.num_influences = m_influences[2];
+    far.update_interval = std::max(1, config.update_intervals[2]);
+    m_levels.push_back(far);
+}
+
+int LodSet::NumLevels() const {
+    return m_levels.size();
+}
+
+const LodLevel& LodSet::Level(int level) const {
+    return m_levels[level];
+}
+
+int LodSet::Select(float distance) const {
+    int level = 0;
+    while (level + 1 < NumLevels() && distance >= m_levels[level + 1].min_distance) {
+        level++;
+    }
+    return level;
+}
+
+Mesh* CopyMesh(const Mesh* mesh) {
+    Mesh* copy = new Mesh();
+    copy->m_num_vertices = mesh->NumVertices();
+    copy->m_num_triangles = mesh->NumTriangles();
+    copy->m_vertices = new Vertex[mesh->NumVertices()];
+    copy->m_triangles = new int[mesh->NumTriangles() * 3];
+    std::copy(mesh->m_vertices, mesh->m_vertices + mesh->NumVertices(), copy->m_vertices);
+    std::copy(mesh->m_triangles, mesh->m_triangles + mesh->NumTriangles() * 3, copy->m_triangles);
+    return copy;
+}
+
+Mesh* ReduceInfluences(const Mesh* mesh, int num_influences) {
+    num_influences = std::max(1, std::min(num_influences, 3));
+
+    Mesh* reduced = new Mesh();
+    reduced->m_num_vertices = mesh->NumVertices();
+    reduced->m_num_triangles = mesh->NumTriangles();
+    reduced->m_vertices = new Vertex[mesh->NumVertices()];
+    reduced->m_triangles = new int[mesh->NumTriangles() * 3];
+    std::copy(mesh->m_triangles, mesh->m_triangles + mesh->NumTriangles() * 3, reduced->m_triangles);
+
+    for (int i = 0; i < mesh->NumVertices(); i++) {
+        const Vertex& original = mesh->m_vertices[i];
+        std::pair<float, float> weights[3];
+        for (int j = 0; j < 3; j++) {
+            //biggest amount first
+            weights[j] = std::make_pair(-original.weight_amounts[j], original.weight_ids[j]);
+        }
+        std::sort(weights, weights + 3);
+
+        float sum = 0;
+        for (int j = 0; j < num_influences; j++) {
+            sum -= weights[j].first;
+        }
+        float amounts[3] = {0, 0, 0};
+        float ids[3] = {0, 0, 0};
+        for (int j = 0; j < num_influences; j++) {
+            amounts[j] = (sum > 0) ? -weights[j].first / sum : 1.0f / num_influences;
+            ids[j] = weights[j].second;
+        }
+
+        Vertex& vertex = reduced->m_vertices[i];
+        vertex = original;
+        vertex.weight_ids = Vector3(ids[0], ids[1], ids[2]);
+        vertex.weight_amounts = Vector3(amounts[0], amounts[1], amounts[2]);
+    }
+    return reduced;
+}
+
+Mesh* DecimateMesh(const Mesh* mesh, int cells) {
+    cells = std::max(1, cells);
+    int num_vertices = mesh->NumVertices();
+
+    Vector3 lower = (num_vertices > 0) ? mesh->m_vertices[0].position : Vector3::Zero();
+    Vector3 upper = lower;
+    for (int i = 0; i < num_vertices; i++) {
+        const Vector3& p = mesh->m_vertices[i].position;
+        lower = Vector3(std::min(lower.x, p.x), std::min(lower.y, p.y), std::min(lower.z, p.z));
+        upper = Vector3(std::max(upper.x, p.x), std::max(upper.y, p.y), std::max(upper.z, p.z));
+    }
+    float extent = std::max(upper.x - lower.x, std::max(upper.y - lower.y, upper.z - lower.z));
+    float cell_size = std::max(extent / cells, 1e-6f);
+
+    //cell of every vertex, cells numbered in the order of their sorted keys
+    std::vector<long long> keys(num_vertices);
+    for (int i = 0; i < num_vertices; i++) {
+        const Vector3& p = mesh->m_vertices[i].position;
+        long long cx = (long long)((p.x - lower.x) / cell_size);
+        long long cy = (long long)((p.y - lower.y) / cell_size);
+        long long cz = (long long)((p.z - lower.z) / cell_size);
+        keys[i] = (cx * (cells + 1) + cy) * (cells + 1) + cz;
+    }
+    std::vector<long long> sorted_keys(keys);
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    sorted_keys.erase(std::unique(sorted_keys.begin(), sorted_keys.end()), sorted_keys.end());
+    int num_cells = sorted_keys.size();
+
+    std::vector<int> cell_of(num_vertices);
+    std::vector<Vector3> centers(num_cells, Vector3::Zero());
+    std::vector<int> counts(num_cells, 0);
+    for (int i = 0; i < num_vertices; i++) {
+        cell_of[i] = std::lower_bound(sorted_keys.begin(), sorted_keys.end(), keys[i]) - sorted_keys.begin();
+        centers[cell_of[i]] += mesh->m_vertices[i].position;
+        counts[cell_of[i]]++;
+    }
+    std::vector<int> representative(num_cells, -1);
+    std::vector<float> best(num_cells, 0);
+    for (int i = 0; i < num_vertices; i++) {
+        int cell = cell_of[i];
+        float dist = Vector3::Distance(mesh->m_vertices[i].position, centers[cell] / (float)counts[cell]);
+        if (representative[cell] == -1 || dist < best[cell]) {
+            representative[cell] = i;
+            best[cell] = dist;
+        }
+    }
+
+    Mesh* decimated = new Mesh();
+    decimated->m_num_vertices = num_cells;
+    decimated->m_vertices = new Vertex[num_cells];
+    for (int cell = 0; cell < num_cells; cell++) {
+        decimated->m_vertices[cell] = mesh->m_vertices[representative[cell]];
+    }
+
+    std::vector<int> triangles;
+    for (int t = 0; t < mesh->NumTriangles(); t++) {
+        int a = cell_of[mesh->GetIndex(t * 3 + 0)];
+        int b = cell_of[mesh->GetIndex(t * 3 + 1)];
+        int c = cell_of[mesh->GetIndex(t * 3 + 2)];
+        if (a == b || b == c || a == c) continue;
+        triangles.push_back(a);
+        triangles.push_back(b);
+        triangles.push_back(c);
+    }
+    decimated->m_num_triangles = triangles.size() / 3;
+    decimated->m_triangles = new int[std::max((size_t)1, triangles.size())];
+    std::copy(triangles.begin(), triangles.end(), decimated->m_triangles);
+    return decimated;
+}
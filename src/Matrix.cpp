@@ -33,14 +33,14 @@ void Matrix_2x2::Print(Matrix_2x2 m) {
     printf("| %0.2f, %0.2f |\n", m.yx, m.yy);
 }
 
-Matrix_2x2 Matrix_2x2::operator*(Matrix_2x2 m) {
+Matrix_2x2 Matrix_2x2::operator*(Matrix_2x2 m) const {
     return Matrix_2x2(
                xx * m.xx + xy * m.yx, xx * m.xy + xy * m.yy,
                yx * m.xx + yy * m.yx, yx * m.xy + yy * m.yy
            );
 }
 
-Vector2 Matrix_2x2::operator*(Vector2 v) {
+Vector2 Matrix_2x2::operator*(Vector2 v) const {
     return Vector2( v.x * xx + v.y * xy , v.x * yx + v.y * yy);
 }
 
@@ -135,7 +135,7 @@ void Matrix_3x3::Print(Matrix_3x3 m) {
     printf("| %0.2f, %0.2f, %0.2f |\n", m.zx, m.zy, m.zz);
 }
 
-Matrix_3x3 Matrix_3x3::operator*(Matrix_3x3 m) {
+Matrix_3x3 Matrix_3x3::operator*(Matrix_3x3 m) const {
 
     return Matrix_3x3(
                (xx * m.xx) + (xy * m.yx) + (xz * m.zx),
@@ -153,7 +153,7 @@ Matrix_3x3 Matrix_3x3::operator*(Matrix_3x3 m) {
 
 }
 
-Vector3 Matrix_3x3::operator*(Vector3 v) {
+Vector3 Matrix_3x3::operator*(Vector3 v) const {
 
     return Vector3(
                (xx * v.x) + (xy * v.y) + (xz * v.z),
@@ -390,7 +390,7 @@ Matrix_3x3 Matrix_4x4::ToMatrix_3x3(Matrix_4x4 m) {
 
 }
 
-Matrix_4x4 Matrix_4x4::operator*(Matrix_4x4 m) {
+Matrix_4x4 Matrix_4x4::operator*(Matrix_4x4 m) const {
 
     return Matrix_4x4(
 
@@ -418,12 +418,12 @@ Matrix_4x4 Matrix_4x4::operator*(Matrix_4x4 m) {
 
 }
 
-Matrix_4x4 Matrix_4x4::operator*(Matrix_3x3 m) {
+Matrix_4x4 Matrix_4x4::operator*(Matrix_3x3 m) const {
     Matrix_4x4 m2 = Matrix_4x4::FromMatrix_3x3(m);
     return *this * m2;
 }
 
-Vector4 Matrix_4x4::operator*(Vector4 v) {
+Vector4 Matrix_4x4::operator*(Vector4 v) const {
     return Vector4(
                (xx * v.x) + (xy * v.y) + (xz * v.z) + (xw * v.w),
                (yx * v.x) + (yy * v.y) + (yz * v.z) + (yw * v.w),
@@ -432,7 +432,7 @@ Vector4 Matrix_4x4::operator*(Vector4 v) {
            );
 }
 
-Vector3 Matrix_4x4::operator*(Vector3 vec) {
+Vector3 Matrix_4x4::operator*(Vector3 vec) const {
 
     Vector4 v = Vector4::ToHomogeneous(vec);
 
@@ -503,7 +503,7 @@ Matrix_4x4 Matrix_4x4::Inverse(Matrix_4x4 m) {
 
 }
 
-Matrix_4x4 Matrix_4x4::operator*(float fac) {
+Matrix_4x4 Matrix_4x4::operator*(float fac) const {
     return Matrix_4x4(
                xx * fac, xy * fac, xz * fac, xw * fac,
                yx * fac, yy * fac, yz * fac, yw * fac,
@@ -512,7 +512,7 @@ Matrix_4x4 Matrix_4x4::operator*(float fac) {
            );
 }
 
-Matrix_4x4 Matrix_4x4::operator+(Matrix_4x4 m) {
+Matrix_4x4 Matrix_4x4::operator+(Matrix_4x4 m) const {
     return Matrix_4x4(
                xx + m.xx, xy + m.xy, xz + m.xz, xw + m.xw,
                yx + m.yx, yy + m.yy, yz + m.yz, yw + m.yw,
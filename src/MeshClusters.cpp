@@ -0,0 +1,368 @@
+#include "MeshClusters.h"
+
+#include <math.h>
+#include <algorithm>
+
+#include "Bounds.h"
+
+//how much normal direction counts against position when choosing where to split,
+//normals span up to 2, scaled by the size of the patch
+static const float NORMAL_WEIGHT = 2.0f;
+//extra opening of the posed cone in radians, faces between vertices of different weights
+//stretch a little past the rotations of their joints
+static const float CONE_MARGIN = 0.1f;
+
+ClusterCullStats::ClusterCullStats()
+    : visible(0)
+    , outside(0)
+    , back_facing(0)
+    , skinned_vertices(0)
+    , drawn_triangles(0) {}
+
+MeshClusters::MeshClusters()
+    : m_mesh(NULL) {}
+
+MeshClusters::~MeshClusters() {
+    delete m_mesh;
+}
+
+//joint of influence j of the vertex, -1 if it has no weight
+static int InfluenceJoint(const Vertex& vertex, int j, int num_joints) {
+    int joint_id = (int)round(vertex.weight_ids[j]);
+    if (vertex.weight_amounts[j] > 0 && joint_id >= 0 && joint_id < num_joints) {
+        return joint_id;
+    }
+    return -1;
+}
+
+//orders triangles by one of centroid xyz (0-2) or normal xyz (3-5)
+struct TriangleLess {
+    TriangleLess(const std::vector<Vector3>& centroids, const std::vector<Vector3>& normals, int axis)
+        : centroids(centroids), normals(normals), axis(axis) {}
+
+    bool operator()(int a, int b) const {
+        if (axis < 3) {
+            return centroids[a][axis] < centroids[b][axis];
+        }
+        return normals[a][axis - 3] < normals[b][axis - 3];
+    }
+
+    const std::vector<Vector3>& centroids;
+    const std::vector<Vector3>& normals;
+    int axis;
+};
+
+//halves [begin, end) at the median of the widest axis until every part fits, parts go into
+//ranges as offsets from base
+static void SplitTriangles(const std::vector<Vector3>& centroids, const std::vector<Vector3>& normals,
+                           int* base, int* begin, int* end, int max_triangles,
+                           std::vector<std::pair<int, int> >& ranges) {
+    int count = end - begin;
+    if (count <= max_triangles) {
+        ranges.push_back(std::make_pair((int)(begin - base), (int)(end - base)));
+        return;
+    }
+
+    Aabb positions, directions;
+    for (int* t = begin; t != end; t++) {
+        positions.Add(centroids[*t]);
+        directions.Add(normals[*t]);
+    }
+    Vector3 position_size = positions.upper - positions.lower;
+    Vector3 direction_size = directions.upper - directions.lower;
+    float extent = std::max(position_size.x, std::max(position_size.y, position_size.z));
+
+    int axis = 0;
+    float widest = -1;
+    for (int i = 0; i < 6; i++) {
+        float size = (i < 3) ? position_size[i] : direction_size[i - 3] * extent * NORMAL_WEIGHT;
+        if (size > widest) {
+            widest = size;
+            axis = i;
+        }
+    }
+
+    int* middle = begin + count / 2;
+    std::nth_element(begin, middle, end, TriangleLess(centroids, normals, axis));
+    SplitTriangles(centroids, normals, base, begin, middle, max_triangles, ranges);
+    SplitTriangles(centroids, normals, base, middle, end, max_triangles, ranges);
+}
+
+void MeshClusters::Build(const Mesh* mesh, int num_joints, int max_triangles) {
+    delete m_mesh;
+    m_mesh = NULL;
+    m_clusters.clear();
+    m_borrowed.clear();
+    m_joint_ids.clear();
+    m_joint_centers.clear();
+    m_joint_radii.clear();
+    max_triangles = std::max(1, max_triangles);
+
+    int num_triangles = mesh->NumTriangles();
+    std::vector<Vector3> centroids(num_triangles);
+    std::vector<Vector3> normals(num_triangles);
+    std::vector<int> dominant(num_triangles);
+    std::vector<float> joint_weights(num_joints, 0.0f);
+    for (int t = 0; t < num_triangles; t++) {
+        const Vertex* corners[3];
+        for (int k = 0; k < 3; k++) {
+            corners[k] = &mesh->m_vertices[mesh->GetIndex(t * 3 + k)];
+        }
+        Vector3 a = corners[0]->position;
+        Vector3 b = corners[1]->position;
+        Vector3 c = corners[2]->position;
+        centroids[t] = (a + b + c) / 3.0f;
+        //counter clockwise is the front, as GL culls
+        Vector3 normal = Vector3::Cross(b - a, c - a);
+        normals[t] = (Vector3::Length(normal) > 0) ? Vector3::Normalize(normal) : Vector3::Zero();
+
+        int best = 0;
+        for (int k = 0; k < 3; k++) {
+            for (int j = 0; j < 3; j++) {
+                int joint_id = InfluenceJoint(*corners[k], j, num_joints);
+                if (joint_id != -1) {
+                    joint_weights[joint_id] += corners[k]->weight_amounts[j];
+                    if (joint_weights[joint_id] > joint_weights[best]) {
+                        best = joint_id;
+                    }
+                }
+            }
+        }
+        dominant[t] = best;
+        for (int k = 0; k < 3; k++) {
+            for (int j = 0; j < 3; j++) {
+                int joint_id = InfluenceJoint(*corners[k], j, num_joints);
+                if (joint_id != -1) {
+                    joint_weights[joint_id] = 0.0f;
+                }
+            }
+        }
+    }
+
+    //triangles grouped by dominant joint, every group split on its own
+    std::vector<int> order(num_triangles);
+    std::vector<int> group_begin(num_joints + 1, 0);
+    for (int t = 0; t < num_triangles; t++) {
+        group_begin[dominant[t] + 1]++;
+    }
+    for (int joint_id = 0; joint_id < num_joints; joint_id++) {
+        group_begin[joint_id + 1] += group_begin[joint_id];
+    }
+    std::vector<int> group_fill(group_begin.begin(), group_begin.end() - 1);
+    for (int t = 0; t < num_triangles; t++) {
+        order[group_fill[dominant[t]]++] = t;
+    }
+    std::vector<std::pair<int, int> > ranges;
+    for (int joint_id = 0; joint_id < num_joints; joint_id++) {
+        if (group_begin[joint_id] < group_begin[joint_id + 1]) {
+            SplitTriangles(centroids, normals, &order[0], &order[group_begin[joint_id]],
+                           &order[group_begin[joint_id + 1]], max_triangles, ranges);
+        }
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<int> triangles;
+    //new index of every vertex and the last cluster which used it
+    std::vector<int> remap(mesh->NumVertices(), -1);
+    std::vector<int> last_use(mesh->NumVertices(), -1);
+    std::vector<int> used;
+    std::vector<Aabb> joint_boxes(num_joints);
+    std::vector<int> cluster_joints;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        MeshCluster cluster;
+        cluster.first_vertex = vertices.size();
+        cluster.first_triangle = triangles.size() / 3;
+        cluster.num_triangles = ranges[i].second - ranges[i].first;
+        cluster.first_borrowed = m_borrowed.size();
+        cluster.dominant_joint = dominant[order[ranges[i].first]];
+
+        Vector3 normal_sum = Vector3::Zero();
+        used.clear();
+        for (int r = ranges[i].first; r < ranges[i].second; r++) {
+            int t = order[r];
+            normal_sum += normals[t];
+            for (int k = 0; k < 3; k++) {
+                int index = mesh->GetIndex(t * 3 + k);
+                if (remap[index] == -1) {
+                    remap[index] = vertices.size();
+                    vertices.push_back(mesh->m_vertices[index]);
+                } else if (last_use[index] != (int)i && remap[index] < cluster.first_vertex) {
+                    m_borrowed.push_back(remap[index]);
+                }
+                if (last_use[index] != (int)i) {
+                    last_use[index] = i;
+                    used.push_back(remap[index]);
+                }
+                triangles.push_back(remap[index]);
+            }
+        }
+        cluster.num_vertices = vertices.size() - cluster.first_vertex;
+        cluster.num_borrowed = m_borrowed.size() - cluster.first_borrowed;
+
+        cluster.cone_axis = Vector3::Zero();
+        cluster.cone_cos = -1.0f;
+        if (Vector3::Length(normal_sum) > 0) {
+            cluster.cone_axis = Vector3::Normalize(normal_sum);
+            cluster.cone_cos = 1.0f;
+            for (int r = ranges[i].first; r < ranges[i].second; r++) {
+                //degenerate triangles have no side to face away with
+                if (Vector3::Length(normals[order[r]]) > 0) {
+                    cluster.cone_cos = std::min(cluster.cone_cos, Vector3::Dot(normals[order[r]], cluster.cone_axis));
+                }
+            }
+        }
+
+        //spheres of the joints around the rest vertices they move, the dominant one first
+        cluster_joints.clear();
+        cluster_joints.push_back(cluster.dominant_joint);
+        for (size_t u = 0; u < used.size(); u++) {
+            const Vertex& vertex = vertices[used[u]];
+            for (int j = 0; j < 3; j++) {
+                int joint_id = InfluenceJoint(vertex, j, num_joints);
+                if (joint_id == -1) continue;
+                if (joint_boxes[joint_id].empty && joint_id != cluster.dominant_joint) {
+                    cluster_joints.push_back(joint_id);
+                }
+                joint_boxes[joint_id].Add(vertex.position);
+            }
+        }
+        cluster.first_joint = m_joint_ids.size();
+        cluster.num_joints = cluster_joints.size();
+        for (size_t k = 0; k < cluster_joints.size(); k++) {
+            int joint_id = cluster_joints[k];
+            Aabb& box = joint_boxes[joint_id];
+            Vector3 center = (box.lower + box.upper) * 0.5f;
+            float radius = 0;
+            for (size_t u = 0; u < used.size(); u++) {
+                const Vertex& vertex = vertices[used[u]];
+                for (int j = 0; j < 3; j++) {
+                    if (InfluenceJoint(vertex, j, num_joints) == joint_id) {
+                        radius = std::max(radius, Vector3::Distance(vertex.position, center));
+                    }
+                }
+            }
+            m_joint_ids.push_back(joint_id);
+            m_joint_centers.push_back(center);
+            m_joint_radii.push_back(radius);
+            box = Aabb();
+        }
+
+        m_clusters.push_back(cluster);
+    }
+
+    m_mesh = new Mesh();
+    m_mesh->m_num_vertices = vertices.size();
+    m_mesh->m_num_triangles = triangles.size() / 3;
+    m_mesh->m_vertices = new Vertex[vertices.size()];
+    std::copy(vertices.begin(), vertices.end(), m_mesh->m_vertices);
+    m_mesh->m_triangles = new int[triangles.size()];
+    std::copy(triangles.begin(), triangles.end(), m_mesh->m_triangles);
+}
+
+const Mesh* MeshClusters::ClusteredMesh() const {
+    return m_mesh;
+}
+
+int MeshClusters::NumClusters() const {
+    return m_clusters.size();
+}
+
+const MeshCluster& MeshClusters::Cluster(int i) const {
+    return m_clusters[i];
+}
+
+int MeshClusters::NumBorrowed() const {
+    return m_borrowed.size();
+}
+
+//whether some run skins the vertex, runs are ordered by vertex
+static bool InRuns(const ClusterRun* runs, int num_runs, int vertex) {
+    int lower = 0;
+    int upper = num_runs;
+    while (lower < upper) {
+        int middle = (lower + upper) / 2;
+        if (runs[middle].first_vertex + runs[middle].num_vertices <= vertex) {
+            lower = middle + 1;
+        } else {
+            upper = middle;
+        }
+    }
+    return lower < num_runs && runs[lower].first_vertex <= vertex;
+}
+
+void MeshClusters::Cull(const Matrix_4x4* palette, const Frustum& frustum, Vector3 eye,
+                        ClusterSelection& selection, ClusterCullStats* stats) const {
+    ClusterCullStats counts;
+    ClusterRun* runs = selection.runs;
+    int num_runs = 0;
+    int num_borrowed = 0;
+    bool previous_visible = false;
+    for (size_t i = 0; i < m_clusters.size(); i++) {
+        const MeshCluster& cluster = m_clusters[i];
+        const Matrix_4x4& dominant = palette[cluster.dominant_joint];
+
+        //a skinned vertex is a weighted average of its rest position moved by each of its joints,
+        //so it stays within the sphere around the posed joint spheres
+        Vector3 center = dominant * m_joint_centers[cluster.first_joint];
+        float radius = m_joint_radii[cluster.first_joint];
+        for (int k = 1; k < cluster.num_joints; k++) {
+            int joint = cluster.first_joint + k;
+            Vector3 joint_center = palette[m_joint_ids[joint]] * m_joint_centers[joint];
+            radius = std::max(radius, Vector3::Distance(joint_center, center) + m_joint_radii[joint]);
+        }
+
+        bool visible = frustum.Intersects(center, radius);
+        if (!visible) {
+            counts.outside++;
+        } else if (cluster.cone_cos > 0) {
+            Vector3 axis = Matrix_4x4::ToMatrix_3x3(dominant) * cluster.cone_axis;
+            //the other joints turn their faces up to as far as they turn the axis
+            float spread_cos = 1.0f;
+            for (int k = 1; k < cluster.num_joints; k++) {
+                Vector3 joint_axis = Matrix_4x4::ToMatrix_3x3(palette[m_joint_ids[cluster.first_joint + k]]) * cluster.cone_axis;
+                spread_cos = std::min(spread_cos, Vector3::Dot(joint_axis, axis));
+            }
+            float angle = acos(cluster.cone_cos) + acos(std::max(-1.0f, std::min(spread_cos, 1.0f))) + CONE_MARGIN;
+            if (angle < M_PI * 0.5) {
+                //every direction from the eye into the sphere is within 90 - angle degrees of the axis
+                float sine = sin(angle);
+                Vector3 to_center = center - eye;
+                if (Vector3::Dot(axis, to_center) >= sine * Vector3::Length(to_center) + radius * (1.0f + sine)) {
+                    visible = false;
+                    counts.back_facing++;
+                }
+            }
+        }
+
+        if (visible) {
+            counts.visible++;
+            counts.skinned_vertices += cluster.num_vertices;
+            counts.drawn_triangles += cluster.num_triangles;
+            //owners come first, so whether they were kept is known already
+            for (int k = 0; k < cluster.num_borrowed; k++) {
+                int vertex = m_borrowed[cluster.first_borrowed + k];
+                if (!InRuns(runs, num_runs, vertex)) {
+                    selection.borrowed[num_borrowed++] = vertex;
+                    counts.skinned_vertices++;
+                }
+            }
+            if (previous_visible) {
+                runs[num_runs - 1].num_vertices += cluster.num_vertices;
+                runs[num_runs - 1].num_triangles += cluster.num_triangles;
+            } else {
+                ClusterRun& run = runs[num_runs++];
+                run.first_vertex = cluster.first_vertex;
+                run.num_vertices = cluster.num_vertices;
+                run.first_triangle = cluster.first_triangle;
+                run.num_triangles = cluster.num_triangles;
+            }
+        }
+        previous_visible = visible;
+    }
+
+    selection.num_runs = num_runs;
+    selection.num_borrowed = num_borrowed;
+    if (stats != NULL) {
+        *stats = counts;
+    }
+}
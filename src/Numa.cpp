@@ -0,0 +1,191 @@
+#include "Numa.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+NumaTopology::NumaTopology() {
+    m_cpus.resize(1);
+    for (int cpu = 0; cpu < WorkerPool::HardwareThreads(); cpu++) {
+        m_cpus[0].push_back(cpu);
+    }
+}
+
+//"0-3,8-11" into the cpu numbers
+static std::vector<int> ParseCpuList(const char* list) {
+    std::vector<int> cpus;
+    const char* c = list;
+    while (*c != '\0' && *c != '\n') {
+        char* next;
+        int first = strtol(c, &next, 10);
+        if (next == c) break;
+        int last = first;
+        c = next;
+        if (*c == '-') {
+            last = strtol(c + 1, &next, 10);
+            c = next;
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+        if (*c == ',') c++;
+    }
+    return cpus;
+}
+
+void NumaTopology::Detect() {
+#ifdef __linux__
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir == NULL) {
+        return;
+    }
+    std::vector<int> node_ids;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int id;
+        char rest;
+        if (sscanf(entry->d_name, "node%d%c", &id, &rest) == 1) {
+            node_ids.push_back(id);
+        }
+    }
+    closedir(dir);
+    std::sort(node_ids.begin(), node_ids.end());
+
+    std::vector<std::vector<int> > nodes;
+    for (size_t i = 0; i < node_ids.size(); i++) {
+        char path[128];
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", node_ids[i]);
+        FILE* f = fopen(path, "r");
+        if (f == NULL) continue;
+        char line[4096];
+        if (fgets(line, sizeof(line), f) != NULL) {
+            std::vector<int> cpus = ParseCpuList(line);
+            //nodes with memory only have nobody to run on them
+            if (!cpus.empty()) {
+                nodes.push_back(cpus);
+            }
+        }
+        fclose(f);
+    }
+    if (!nodes.empty()) {
+        m_cpus = nodes;
+    }
+#endif
+}
+
+void NumaTopology::Emulate(int num_nodes) {
+    num_nodes = std::max(1, num_nodes);
+    std::vector<int> all;
+    for (size_t node = 0; node < m_cpus.size(); node++) {
+        all.insert(all.end(), m_cpus[node].begin(), m_cpus[node].end());
+    }
+    m_cpus.assign(num_nodes, std::vector<int>());
+    for (size_t i = 0; i < all.size(); i++) {
+        m_cpus[i % num_nodes].push_back(all[i]);
+    }
+    //fewer cpus than nodes, some share
+    for (int node = 0; node < num_nodes; node++) {
+        if (m_cpus[node].empty()) {
+            m_cpus[node].push_back(all[node % all.size()]);
+        }
+    }
+}
+
+int NumaTopology::NumNodes() const {
+    return m_cpus.size();
+}
+
+const std::vector<int>& NumaTopology::Cpus(int node) const {
+    return m_cpus[node];
+}
+
+std::string NumaTopology::Describe() const {
+    char text[64];
+    sprintf(text, "%d node%s:", NumNodes(), (NumNodes() == 1) ? "" : "s");
+    std::string description = text;
+    for (int node = 0; node < NumNodes(); node++) {
+        const std::vector<int>& cpus = m_cpus[node];
+        description += " ";
+        //runs of consecutive cpus as first-last
+        for (size_t i = 0; i < cpus.size(); ) {
+            size_t last = i;
+            while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1) last++;
+            if (last == i) {
+                sprintf(text, "%s%d", (i > 0) ? "," : "", cpus[i]);
+            } else {
+                sprintf(text, "%s%d-%d", (i > 0) ? "," : "", cpus[i], cpus[last]);
+            }
+            description += text;
+            i = last + 1;
+        }
+    }
+    return description;
+}
+
+bool PinThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+struct NodeRunStart {
+    const std::vector<int>* cpus;
+    RangeTask* task;
+    int begin;
+    int end;
+    bool pinned;
+};
+
+static void* NodeRunMain(void* arg) {
+    NodeRunStart* start = (NodeRunStart*)arg;
+    start->pinned = PinThread(*start->cpus);
+    if (start->pinned) {
+        start->task->Run(start->begin, start->end, 0);
+    }
+    return NULL;
+}
+
+bool RunOnNode(const NumaTopology& numa, int node, RangeTask* task, int begin, int end) {
+    NodeRunStart start;
+    start.cpus = &numa.Cpus(node);
+    start.task = task;
+    start.begin = begin;
+    start.end = end;
+    start.pinned = false;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, NodeRunMain, &start) != 0) {
+        return false;
+    }
+    pthread_join(thread, NULL);
+    return start.pinned;
+}
+
+class NoTask : public RangeTask {
+    public:
+        void Run(int begin, int end, int worker_id) {}
+};
+
+bool CanPinThreads(const NumaTopology& numa) {
+    NoTask task;
+    for (int node = 0; node < numa.NumNodes(); node++) {
+        if (!RunOnNode(numa, node, &task, 0, 0)) {
+            return false;
+        }
+    }
+    return true;
+}
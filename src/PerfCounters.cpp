@@ -0,0 +1,130 @@
+#include "PerfCounters.h"
+
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+PerfCounters::PerfCounters()
+    : m_error("not opened") {
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        m_fds[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (m_fds[i] != -1) {
+            close(m_fds[i]);
+        }
+    }
+#endif
+}
+
+const char* PerfCounters::Name(int counter) {
+    switch (counter) {
+        case PERF_CYCLES:        return "cycles";
+        case PERF_INSTRUCTIONS:  return "instructions";
+        case PERF_L1D_MISSES:    return "L1D misses";
+        case PERF_LLC_MISSES:    return "LLC misses";
+        case PERF_BRANCH_MISSES: return "branch misses";
+        default:                 return "unknown";
+    }
+}
+
+const char* PerfCounters::Error() {
+    return m_error;
+}
+
+bool PerfCounters::Available(int counter) {
+    return m_fds[counter] != -1;
+}
+
+#ifdef __linux__
+
+static int OpenCounter(unsigned int type, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    //calling thread on any cpu
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+bool PerfCounters::Open() {
+    unsigned long long l1d_read_miss = PERF_COUNT_HW_CACHE_L1D
+                                     | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                     | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    m_fds[PERF_CYCLES]        = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    m_fds[PERF_INSTRUCTIONS]  = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    m_fds[PERF_L1D_MISSES]    = OpenCounter(PERF_TYPE_HW_CACHE, l1d_read_miss);
+    m_fds[PERF_LLC_MISSES]    = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    m_fds[PERF_BRANCH_MISSES] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (m_fds[i] != -1) {
+            m_error = "";
+            return true;
+        }
+    }
+    m_error = (errno == EACCES || errno == EPERM) ? "not permitted, see /proc/sys/kernel/perf_event_paranoid"
+            : (errno == ENOENT || errno == EOPNOTSUPP) ? "no hardware counters (virtual machine?)"
+            : "perf_event_open failed";
+    return false;
+}
+
+void PerfCounters::Start() {
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (m_fds[i] != -1) {
+            ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void PerfCounters::Stop() {
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (m_fds[i] != -1) {
+            ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+double PerfCounters::Value(int counter) {
+    if (m_fds[counter] == -1) {
+        return 0;
+    }
+    //value, time enabled, time running
+    unsigned long long values[3];
+    if (read(m_fds[counter], values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+        return 0;
+    }
+    return (double)values[0] * values[1] / values[2];
+}
+
+#else
+
+bool PerfCounters::Open() {
+    m_error = "only supported on Linux";
+    return false;
+}
+
+void PerfCounters::Start() {}
+void PerfCounters::Stop() {}
+
+double PerfCounters::Value(int counter) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include "Pose.h"
+
+#include <algorithm>
+
+#include "PoseBatch.h"
+
+/*
+ * Global transforms per frame for given animation.
+ * Using vectors to alleviate problems with memory leaks.
+ * Using this signature because it is c++98 and in that it won't be copying values twice as
+ * c++98 doesn't have move constructor.
+ */
+void ComputeTransPerFrameGB(std::vector<std::vector<Matrix_4x4> >& trans_per_frame_gb, const Animation* anim,
+                            const JointMask* mask) {
+    trans_per_frame_gb.resize(anim->NumFrames());
+    if (anim->NumFrames() == 0) {
+        return;
+    }
+    //frames of a clip share the topology, so they are composed SKIN_POSE_LANES at a time
+    PoseBatch batch(anim->Topology(), mask);
+    for (int first = 0; first < anim->NumFrames(); first += SKIN_POSE_LANES) {
+        int num_lanes = std::min(SKIN_POSE_LANES, anim->NumFrames() - first);
+        for (int lane = 0; lane < num_lanes; lane++) {
+            batch.SetLocal(lane, anim->GetFrame(first + lane));
+        }
+        batch.Compose();
+        for (int lane = 0; lane < num_lanes; lane++) {
+            batch.GetGlobal(lane, trans_per_frame_gb[first + lane]);
+        }
+    }
+}
+
+void ComputeTransGB(std::vector<Matrix_4x4>& trans_gb, const Skeleton* skel) {
+    trans_gb.resize(skel->NumJoints());
+    //parents come first, so every joint is one multiplication away from its parent
+    const std::vector<int>& order = skel->Topology()->TraversalOrder();
+    for (size_t i = 0; i < order.size(); i++) {
+        int joint_id = order[i];
+        int parent_id = skel->Topology()->Parent(joint_id);
+        if (parent_id == -1) {
+            trans_gb[joint_id] = skel->LocalTransform(joint_id);
+        } else {
+            trans_gb[joint_id] = trans_gb[parent_id] * skel->LocalTransform(joint_id);
+        }
+    }
+}
+
+void ComputeTransGB(std::vector<Matrix_4x4>& trans_gb, const SkeletonTopology* topology, const LocalPose& pose,
+                    const JointMask* mask) {
+    trans_gb.resize(topology->NumJoints(), Matrix_4x4::Id());
+    const std::vector<int>& order = (mask != NULL) ? mask->Order() : topology->TraversalOrder();
+    for (size_t i = 0; i < order.size(); i++) {
+        int joint_id = order[i];
+        int parent_id = topology->Parent(joint_id);
+        if (parent_id == -1) {
+            trans_gb[joint_id] = pose.LocalTransform(joint_id);
+        } else {
+            trans_gb[joint_id] = trans_gb[parent_id] * pose.LocalTransform(joint_id);
+        }
+    }
+}
+
+void ComputeLocalPoses(std::vector<LocalPose>& local_poses, const Animation* anim) {
+    local_poses.resize(anim->NumFrames());
+    for (int frame_id = 0; frame_id < anim->NumFrames(); frame_id++) {
+        local_poses[frame_id].FromSkeleton(anim->GetFrame(frame_id));
+    }
+}
+
+/*
+ * Compute local transforms (needed for Rest pose)
+ */
+void ComputeRestTransLC(std::vector<Matrix_4x4>& rest_trans_lc, const Skeleton* rest_skel) {
+    rest_trans_lc.resize(rest_skel->NumJoints());
+    for (int joint_id = 0; joint_id < rest_skel->NumJoints(); joint_id++) {
+        rest_trans_lc[joint_id] = Matrix_4x4::Inverse(rest_skel->JointTransform(joint_id));
+    }
+}
@@ -0,0 +1,113 @@
+#include "PoseBatch.h"
+
+#include <string.h>
+
+static void StoreLane(TransformLanes& lanes, int lane, const Matrix_4x4& t) {
+    lanes.m[0][lane] = t.xx;  lanes.m[1][lane] = t.xy;  lanes.m[2][lane] = t.xz;  lanes.m[3][lane] = t.xw;
+    lanes.m[4][lane] = t.yx;  lanes.m[5][lane] = t.yy;  lanes.m[6][lane] = t.yz;  lanes.m[7][lane] = t.yw;
+    lanes.m[8][lane] = t.zx;  lanes.m[9][lane] = t.zy;  lanes.m[10][lane] = t.zz; lanes.m[11][lane] = t.zw;
+}
+
+static Matrix_4x4 LoadLane(const TransformLanes& lanes, int lane) {
+    return Matrix_4x4(lanes.m[0][lane], lanes.m[1][lane], lanes.m[2][lane],  lanes.m[3][lane],
+                      lanes.m[4][lane], lanes.m[5][lane], lanes.m[6][lane],  lanes.m[7][lane],
+                      lanes.m[8][lane], lanes.m[9][lane], lanes.m[10][lane], lanes.m[11][lane],
+                      0, 0, 0, 1);
+}
+
+//global = parent * local in every lane. Same order of operations as Matrix_4x4::operator*,
+//so lanes match the scalar composition exactly. The result goes through a local, which
+//can't alias the inputs, so the lane loop vectorizes without runtime overlap checks
+static void ComposeLanes(const TransformLanes& parent, const TransformLanes& local, TransformLanes& global) {
+    TransformLanes result;
+    for (int lane = 0; lane < SKIN_POSE_LANES; lane++) {
+        for (int row = 0; row < 3; row++) {
+            float p0 = parent.m[row * 4 + 0][lane];
+            float p1 = parent.m[row * 4 + 1][lane];
+            float p2 = parent.m[row * 4 + 2][lane];
+            float p3 = parent.m[row * 4 + 3][lane];
+            result.m[row * 4 + 0][lane] = p0 * local.m[0][lane] + p1 * local.m[4][lane] + p2 * local.m[8][lane];
+            result.m[row * 4 + 1][lane] = p0 * local.m[1][lane] + p1 * local.m[5][lane] + p2 * local.m[9][lane];
+            result.m[row * 4 + 2][lane] = p0 * local.m[2][lane] + p1 * local.m[6][lane] + p2 * local.m[10][lane];
+            result.m[row * 4 + 3][lane] = p0 * local.m[3][lane] + p1 * local.m[7][lane] + p2 * local.m[11][lane] + p3;
+        }
+    }
+    memcpy(&global, &result, sizeof(TransformLanes));
+}
+
+PoseBatch::PoseBatch(const SkeletonTopology* topology, const JointMask* mask)
+    : m_topology(topology)
+    , m_mask(mask)
+    , m_local(topology->NumJoints())
+    , m_global(topology->NumJoints()) {
+    //unused lanes compose identities
+    for (int joint_id = 0; joint_id < NumJoints(); joint_id++) {
+        for (int lane = 0; lane < SKIN_POSE_LANES; lane++) {
+            StoreLane(m_local[joint_id], lane, Matrix_4x4::Id());
+        }
+    }
+}
+
+const SkeletonTopology* PoseBatch::Topology() const {
+    return m_topology;
+}
+
+int PoseBatch::NumJoints() const {
+    return m_local.size();
+}
+
+const std::vector<int>& PoseBatch::Order() const {
+    return (m_mask != NULL) ? m_mask->Order() : m_topology->TraversalOrder();
+}
+
+void PoseBatch::SetLocal(int lane, int joint_id, const Matrix_4x4& local) {
+    StoreLane(m_local[joint_id], lane, local);
+}
+
+void PoseBatch::SetLocal(int lane, const Skeleton* skel) {
+    //Translation(position) * rotation without the multiplication, rotations have no translation part
+    const std::vector<int>& order = Order();
+    for (size_t i = 0; i < order.size(); i++) {
+        int joint_id = order[i];
+        const Joint& joint = skel->m_joints[joint_id];
+        Matrix_4x4 local = joint.rotation;
+        local.xw = joint.position.x;
+        local.yw = joint.position.y;
+        local.zw = joint.position.z;
+        StoreLane(m_local[joint_id], lane, local);
+    }
+}
+
+void PoseBatch::SetLocal(int lane, const LocalPose& pose) {
+    const std::vector<int>& order = Order();
+    for (size_t i = 0; i < order.size(); i++) {
+        int joint_id = order[i];
+        StoreLane(m_local[joint_id], lane, pose.LocalTransform(joint_id));
+    }
+}
+
+void PoseBatch::Compose() {
+    const std::vector<int>& order = Order();
+    for (size_t i = 0; i < order.size(); i++) {
+        int joint_id = order[i];
+        int parent_id = m_topology->Parent(joint_id);
+        if (parent_id == -1) {
+            memcpy(&m_global[joint_id], &m_local[joint_id], sizeof(TransformLanes));
+        } else {
+            ComposeLanes(m_global[parent_id], m_local[joint_id], m_global[joint_id]);
+        }
+    }
+}
+
+Matrix_4x4 PoseBatch::Global(int lane, int joint_id) const {
+    return LoadLane(m_global[joint_id], lane);
+}
+
+void PoseBatch::GetGlobal(int lane, std::vector<Matrix_4x4>& trans_gb) const {
+    trans_gb.resize(NumJoints(), Matrix_4x4::Id());
+    const std::vector<int>& order = Order();
+    for (size_t i = 0; i < order.size(); i++) {
+        int joint_id = order[i];
+        trans_gb[joint_id] = LoadLane(m_global[joint_id], lane);
+    }
+}
@@ -0,0 +1,177 @@
+#include "SMDLoader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <vector>
+
+#include "Skeleton.h"
+
+void LoadSMDAnimation(std::string filename, Animation** animation, SkeletonPool* pool) {
+
+    int state = SMD_STATE_EMPTY;
+
+    Animation* anim = new Animation(pool);
+
+    //hierarchy of the nodes section, every frame starts from the default joints
+    std::vector<std::string> names = std::vector<std::string>();
+    std::vector<int> parents = std::vector<int>();
+    std::vector<Joint> joints = std::vector<Joint>();
+    SkeletonTopology* topology = NULL;
+    //frame of the current time block
+    Skeleton* frame = NULL;
+
+    std::ifstream f(filename.c_str());
+
+    if (f == NULL) {
+        printf("Failed to read file %s\n", filename.c_str());
+        fflush(stdout);
+        exit(EXIT_FAILURE);
+    }
+
+    char line[1024];
+
+    while (!f.eof()) {
+
+        f.getline(line, sizeof(line));
+
+        if (strstr(line, "end"))   {
+            state = SMD_STATE_EMPTY;
+            continue;
+        }
+        if (strstr(line, "nodes")) {
+            state = SMD_STATE_NODES;
+            continue;
+        }
+
+        if (strstr(line, "skeleton")) {
+            state = SMD_STATE_SKEL;
+            int cycle = SkeletonTopology::FindCycle(parents);
+            if (cycle != -1) {
+                printf("Joint hierarchy of %s has a cycle through joint %s\n", filename.c_str(), names[cycle].c_str());
+                fflush(stdout);
+                exit(EXIT_FAILURE);
+            }
+            delete topology;
+            topology = new SkeletonTopology(names, parents);
+            joints.resize(names.size());
+            continue;
+        }
+
+        if (strstr(line, "time") && !joints.empty()) {
+            //constructed in place in the pool
+            frame = anim->AddFrame(topology, &joints[0]);
+        }
+
+        if (state == SMD_STATE_NODES) {
+            char name[256];
+            int id, parent;
+            if (sscanf(line, "%i \"%[^\"]\" %i", &id, name, &parent) == 3) {
+                names.push_back(name);
+                parents.push_back(parent);
+            }
+        }
+
+        if (state == SMD_STATE_SKEL) {
+            int id;
+            float x, y, z, rx, ry, rz;
+            if (sscanf(line, "%i %f %f %f %f %f %f", &id, &x, &y, &z, &rx, &ry, &rz) == 7 && frame != NULL) {
+
+                /* Swap y and z */
+                frame->m_joints[id].position = Vector3(x, z, y);
+
+                Matrix_4x4 rotation = Matrix_4x4::RotationEuler(rx, ry, rz);
+                Matrix_4x4 handedflip = Matrix_4x4(1,0,0,0,  0,0,1,0,  0,1,0,0,  0,0,0,1);
+
+                rotation = handedflip * rotation;
+                rotation = rotation * handedflip;
+
+                frame->m_joints[id].rotation = Matrix_4x4::Transpose(rotation);
+            }
+        }
+
+    }
+
+    //the animation keeps the copy of its pool
+    delete topology;
+
+    (*animation) = anim;
+
+}
+
+void LoadSMDCharacter(std::string filename, Mesh** character) {
+
+    int state = SMD_STATE_EMPTY;
+
+    std::vector<Vertex> verts = std::vector<Vertex>();
+    std::vector<int> tris = std::vector<int>();
+
+    std::ifstream f(filename.c_str());
+
+    if (f == NULL) {
+        printf("Failed to read file %s\n", filename.c_str());
+        fflush(stdout);
+        exit(EXIT_FAILURE);
+    }
+
+    char line[1024];
+
+    while (!f.eof()) {
+
+        f.getline(line, sizeof(line));
+
+        if (strstr(line, "end")) {
+            state = SMD_STATE_EMPTY;
+            continue;
+        }
+        if (strstr(line, "triangles")) {
+            state = SMD_STATE_MESH;
+            continue;
+        }
+
+        if (state == SMD_STATE_MESH) {
+
+            int id = 0, l1_id = 0, l2_id = 0, l3_id = 0;
+            int num_links = 0;
+            float x, y, z, nx, ny, nz, u, v, l1_amount = 0, l2_amount = 0, l3_amount = 0;
+
+            if (sscanf(line, "%i %f %f %f %f %f %f %f %f %i %i %f %i %f %i %f",
+                       &id, &x, &y, &z, &nx, &ny, &nz, &u, &v, &num_links,
+                       &l1_id, &l1_amount, &l2_id, &l2_amount, &l3_id, &l3_amount) > 10) {
+
+                /* Swap y and z axis */
+                Vertex vert;
+                vert.position = Vector3(x, z, y);
+                vert.normal = Vector3(nx, nz, ny);
+                vert.weight_ids = Vector3(l1_id, l2_id, l3_id);
+                vert.weight_amounts = Vector3(l1_amount, l2_amount, l3_amount);
+
+                verts.push_back(vert);
+                tris.push_back(verts.size()-1);
+            }
+        }
+
+    }
+
+    f.close();
+
+    Mesh* mesh = new Mesh();
+    mesh->m_num_vertices = verts.size();
+    mesh->m_num_triangles = tris.size() / 3;
+    mesh->m_vertices = new Vertex[mesh->m_num_vertices];
+    mesh->m_triangles = new int[mesh->m_num_triangles * 3];
+
+    for(int i = 0; i < mesh->m_num_vertices; i++) {
+        mesh->m_vertices[i] = verts[i];
+    }
+
+    for(int i = 0; i < mesh->m_num_triangles; i++) {
+        mesh->m_triangles[i*3+0] = tris[i*3+2];
+        mesh->m_triangles[i*3+1] = tris[i*3+1];
+        mesh->m_triangles[i*3+2] = tris[i*3+0];
+    }
+
+    (*character) = mesh;
+
+}
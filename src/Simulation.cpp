@@ -0,0 +1,491 @@
+#include "Simulation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "Frustum.h"
+#include "Timer.h"
+#include "Trace.h"
+
+//vertices per job when the character is skinned
+static const int SKIN_CHUNK_SIZE = 2048;
+
+/*limits of animation speed*/
+static const float MAX_FRAMES_PER_SECOND = 40.0f;
+static const float MIN_FRAMES_PER_SECOND = 1.0f;
+
+SimCommand::SimCommand(int type, int value, float amount)
+    : type(type)
+    , value(value)
+    , amount(amount) {}
+
+SimDrawItem::SimDrawItem()
+    : position(Vector3::Zero())
+    , heading(0.0f)
+    , mesh(NULL)
+    , first_vertex(0)
+    , has_normals(false)
+    , first_range(0)
+    , num_ranges(0)
+    , first_line(0)
+    , num_lines(0)
+    , first_axis(0)
+    , num_axes(0) {}
+
+SimFrame::SimFrame()
+    : serial(0)
+    , show(0)
+    , animating(true)
+    , num_vertices(0)
+    , clusters_culled(false)
+    , hint_serial(0)
+    , steals(0) {
+    hint[0] = '\0';
+    for (int stage = 0; stage < NUM_FRAME_STAGES; stage++) {
+        stage_seconds[stage] = 0.0;
+    }
+}
+
+//adds its lifetime to a stage of the frame being made, the global profiler belongs to the render thread
+class SimStageTimer {
+    public:
+        SimStageTimer(SimFrame& frame, int stage) : m_frame(frame), m_stage(stage), m_start(TimeSeconds()) {}
+        ~SimStageTimer() { m_frame.stage_seconds[m_stage] += TimeSeconds() - m_start; }
+    private:
+        SimFrame& m_frame;
+        int m_stage;
+        double m_start;
+};
+
+static float Clamp(float n, float lower, float upper) {
+    return std::max(lower, std::min(n, upper));
+}
+
+Simulation::Simulation(const AnimationSet* assets, CharacterContext* character, Crowd* crowd,
+                       JobSystem* jobs, const Camera& camera, float aspect)
+    : m_assets(assets)
+    , m_character(character)
+    , m_crowd(crowd)
+    , m_jobs(jobs)
+    , m_camera(camera)
+    , m_aspect(aspect)
+    , m_show(SIM_SHOW_MESH | SIM_SHOW_NORMALS)
+    , m_chunk_size(SKIN_CHUNK_SIZE)
+    , m_serial(0)
+    , m_last_time(-1.0)
+    , m_hint_serial(0)
+    , m_running(false) {
+
+    m_hint[0] = '\0';
+}
+
+Simulation::~Simulation() {
+    Stop();
+}
+
+void Simulation::SetChunkSize(int chunk_size) {
+    m_chunk_size = std::max(1, chunk_size);
+}
+
+bool Simulation::Push(const SimCommand& command) {
+    return m_commands.Push(command);
+}
+
+void Simulation::SetView(const Camera& camera) {
+    m_views.Back() = camera;
+    m_views.Publish();
+}
+
+bool Simulation::AcquireFrame() {
+    if (!m_frames.Acquire()) {
+        return false;
+    }
+    //lets the thread start on the next frame while this one is drawn
+    m_consumed.Signal(m_frames.Front().serial);
+    return true;
+}
+
+const SimFrame& Simulation::Frame() {
+    return m_frames.Front();
+}
+
+void Simulation::Start() {
+    if (m_running) {
+        return;
+    }
+    //nothing made so far is waited for
+    m_consumed.Reset(m_serial);
+    if (pthread_create(&m_thread, NULL, ThreadMain, this) != 0) {
+        printf("[ERROR]: Failed to create simulation thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    m_running = true;
+}
+
+void Simulation::Stop() {
+    if (!m_running) {
+        return;
+    }
+    m_consumed.Cancel();
+    pthread_join(m_thread, NULL);
+    m_running = false;
+}
+
+bool Simulation::Running() {
+    return m_running;
+}
+
+void* Simulation::ThreadMain(void* arg) {
+    Simulation* simulation = (Simulation*)arg;
+    TRACE_THREAD_NAME("simulation");
+
+    do {
+        simulation->Step();
+        //the next frame starts as soon as the render side takes this one, Stop cancels the wait
+    } while (simulation->m_consumed.Wait(simulation->m_serial));
+    return NULL;
+}
+
+void Simulation::Step() {
+    TRACE_SCOPE("simulation frame");
+
+    SimCommand command;
+    while (m_commands.Pop(command)) {
+        Apply(command);
+    }
+    if (m_views.Acquire()) {
+        m_camera = m_views.Front();
+    }
+
+    //time since the previous frame, whatever rate frames are made at
+    double now = TimeSeconds();
+    float seconds = (m_last_time < 0.0) ? 0.0f : (float)(now - m_last_time);
+    m_last_time = now;
+    m_character->Advance(seconds);
+    if (m_crowd != NULL) {
+        m_crowd->Advance(seconds);
+    }
+
+    SimFrame& frame = m_frames.Back();
+    frame.serial = ++m_serial;
+    frame.show = m_show;
+    frame.animating = (m_crowd != NULL) || !m_character->playback.frame_mode;
+    frame.items.clear();
+    frame.num_vertices = 0;
+    frame.ranges.clear();
+    frame.lines.clear();
+    frame.axes.clear();
+    frame.clusters_culled = false;
+    frame.lod_stats.clear();
+    for (int stage = 0; stage < NUM_FRAME_STAGES; stage++) {
+        frame.stage_seconds[stage] = 0.0;
+    }
+
+    if (m_crowd != NULL) {
+        MakeCrowdFrame(frame);
+    } else {
+        MakeCharacterFrame(frame);
+    }
+
+    frame.worker_utilization.clear();
+    frame.steals = 0;
+    for (int worker = 0; worker < m_jobs->NumThreads(); worker++) {
+        frame.worker_utilization.push_back((float)m_jobs->Utilization(worker));
+        frame.steals += m_jobs->WorkerStats(worker).steals;
+    }
+    m_jobs->ResetStats();
+
+    memcpy(frame.hint, m_hint, sizeof(m_hint));
+    frame.hint_serial = m_hint_serial;
+    m_frames.Publish();
+}
+
+void Simulation::SetHint(const char* text) {
+    snprintf(m_hint, sizeof(m_hint), "%s", text);
+    m_hint_serial++;
+}
+
+void Simulation::Apply(const SimCommand& command) {
+    Playback& playback = m_character->playback;
+    char text[128];
+
+    switch (command.type) {
+        case SIM_CLIP:
+            playback.clip = command.value;
+            if (playback.clip == CLIP_WALK) {
+                SetHint("Current Animation: Walk");
+            } else if (playback.clip == CLIP_RUN) {
+                SetHint("Current Animation: Run");
+            } else {
+                SetHint("Current Animation: Walk/Run Mixture");
+            }
+            break;
+        //current frame in frame mode, speed otherwise
+        case SIM_CHANGE_FRAMES:
+            if (playback.frame_mode) {
+                int max_frames = m_assets->NumFrames(playback.clip) - 1;
+                playback.selected_frame = std::max(0, std::min(playback.selected_frame + command.value, max_frames));
+                snprintf(text, sizeof(text), "Current Frame: %d", playback.selected_frame);
+            } else {
+                playback.frames_per_second = Clamp(playback.frames_per_second + command.value,
+                                                   MIN_FRAMES_PER_SECOND, MAX_FRAMES_PER_SECOND);
+                snprintf(text, sizeof(text), "Animation Speed (Frames per Second): %d", (int)playback.frames_per_second);
+            }
+            SetHint(text);
+            break;
+        case SIM_TOGGLE_INTERPOLATION:
+            playback.time_interpolation = !playback.time_interpolation;
+            SetHint((playback.time_interpolation) ? "Time Interpolation: ON" : "Time Interpolation: OFF");
+            break;
+        case SIM_TOGGLE_LOCAL_BLEND:
+            playback.local_blend = !playback.local_blend;
+            if (!playback.local_blend) {
+                SetHint("Pose Blending: Global");
+            } else if (!m_assets->LocalMixBlend()) {
+                SetHint("Pose Blending: Local (nlerp), Global for Walk/Run Mixture");
+            } else {
+                SetHint("Pose Blending: Local (nlerp)");
+            }
+            break;
+        case SIM_TOGGLE_FRAME_MODE:
+            playback.frame_mode = !playback.frame_mode;
+            SetHint((playback.frame_mode) ? "Frame Mode: ON" : "Frame Mode: OFF");
+            break;
+        case SIM_CHANGE_MIX:
+            playback.walk_run_mix_rate = Clamp(playback.walk_run_mix_rate + command.amount, 0, 1);
+            snprintf(text, sizeof(text), "Walk/Run Mix Ratio (0 - Walk, 100 - Run): %d",
+                     (int)(playback.walk_run_mix_rate * 100));
+            SetHint(text);
+            break;
+        case SIM_DISPLAY:
+            m_show = command.value;
+            break;
+    }
+}
+
+//vertex ranges of the character, skinned straight into the frame buffers
+class SimSkinTask : public RangeTask {
+    public:
+        SimSkinTask(Simulation& simulation)
+            : simulation(simulation) {}
+
+        void Run(int begin, int end, int worker_id) {
+            for (int i = begin; i < end; i++) {
+                const Simulation::SkinRange& range = simulation.m_skin_ranges[i];
+                simulation.m_character->SkinRange(range.begin, range.end);
+            }
+        }
+
+        Simulation& simulation;
+};
+
+//skinned (or interpolated) vertices of crowd instances into the frame buffers, one item per index
+class SimCopyTask : public RangeTask {
+    public:
+        SimCopyTask(Simulation& simulation, SimFrame& frame)
+            : simulation(simulation), frame(frame) {}
+
+        void Run(int begin, int end, int worker_id) {
+            Crowd& crowd = *simulation.m_crowd;
+            for (int i = begin; i < end; i++) {
+                const SimDrawItem& item = frame.items[i];
+                if (item.mesh == NULL) continue;
+                int instance = simulation.m_copy_instances[i];
+                int num_floats = item.mesh->NumVertices() * 3;
+                memcpy(&frame.positions[item.first_vertex * 3], crowd.Positions(instance), sizeof(float) * num_floats);
+                if (item.has_normals) {
+                    memcpy(&frame.normals[item.first_vertex * 3], crowd.Normals(instance), sizeof(float) * num_floats);
+                }
+            }
+        }
+
+        Simulation& simulation;
+        SimFrame& frame;
+};
+
+//skeleton and skin are made from the same blended poses of the current time
+void Simulation::MakeCharacterFrame(SimFrame& frame) {
+    CharacterContext* character = m_character;
+
+    SimDrawItem item;
+
+    {
+        SimStageTimer timer(frame, STAGE_POSE);
+        TRACE_SCOPE(FrameProfiler::StageName(STAGE_POSE));
+        character->BeginFrame();
+        if (m_show & SIM_SHOW_MESH) {
+            character->Palette();
+        }
+        if (m_show & SIM_SHOW_SKELETON) {
+            AddSkeleton(frame, item, character->Poses());
+        }
+    }
+
+    if (m_show & SIM_SHOW_MESH) {
+        SimStageTimer timer(frame, STAGE_SKINNING);
+        TRACE_SCOPE(FrameProfiler::StageName(STAGE_SKINNING));
+
+        //normals are only consumed by the lighting
+        int output = (m_show & SIM_SHOW_NORMALS) ? SKIN_OUTPUT_ALL : SKIN_OUTPUT_POSITIONS;
+        const Mesh* mesh = m_assets->Character();
+        ClusterSelection selection;
+        bool culled = (m_show & SIM_CULL_CLUSTERS) != 0;
+        if (culled) {
+            //cluster bounds posed with the palette against the view first, only what survives is skinned
+            const MeshClusters& clusters = m_assets->Clusters();
+            FrameArena& scratch = character->Scratch();
+            selection.runs = scratch.AllocArray<ClusterRun>(clusters.NumClusters());
+            selection.borrowed = scratch.AllocArray<int>(clusters.NumBorrowed());
+
+            Frustum frustum(m_camera, m_aspect);
+            clusters.Cull(character->Palette(), frustum, m_camera.GetPosition(), selection, &frame.cluster_stats);
+            frame.clusters_culled = true;
+            mesh = clusters.ClusteredMesh();
+        }
+
+        bool with_normals = (output & SKIN_OUTPUT_NORMALS) != 0;
+        AddMesh(frame, item, mesh, with_normals, (culled) ? &selection : NULL);
+        character->PrepareSkin(output, mesh, 3, &frame.positions[item.first_vertex * 3],
+                               (with_normals) ? &frame.normals[item.first_vertex * 3] : NULL);
+
+        m_skin_ranges.clear();
+        if (culled) {
+            for (int i = 0; i < selection.num_runs; i++) {
+                const ClusterRun& run = selection.runs[i];
+                AddSkinRanges(run.first_vertex, run.first_vertex + run.num_vertices);
+            }
+            for (int i = 0; i < selection.num_borrowed; i++) {
+                AddSkinRanges(selection.borrowed[i], selection.borrowed[i] + 1);
+            }
+        } else {
+            AddSkinRanges(0, mesh->NumVertices());
+        }
+        SimSkinTask task(*this);
+        m_jobs->ParallelFor(m_skin_ranges.size(), 1, &task);
+    }
+
+    frame.items.push_back(item);
+}
+
+//every instance is posed and skinned as one job graph first, then copied into the frame at its place.
+//Far instances give the mesh of their level of detail
+void Simulation::MakeCrowdFrame(SimFrame& frame) {
+    int output = (m_show & SIM_SHOW_NORMALS) ? SKIN_OUTPUT_ALL : SKIN_OUTPUT_POSITIONS;
+    {
+        SimStageTimer timer(frame, STAGE_SKINNING);
+        TRACE_SCOPE(FrameProfiler::StageName(STAGE_SKINNING));
+        //instances outside of the view are neither skinned nor drawn
+        Frustum frustum(m_camera, m_aspect);
+        m_crowd->Evaluate(*m_jobs, output, m_camera.GetPosition(), &frustum, m_chunk_size);
+    }
+
+    SimStageTimer timer(frame, STAGE_BUFFERS);
+    TRACE_SCOPE(FrameProfiler::StageName(STAGE_BUFFERS));
+    //room for every visible instance first, then the copies run as jobs
+    m_copy_instances.clear();
+    for (int i = 0; i < m_crowd->NumInstances(); i++) {
+        if (!m_crowd->Visible(i)) continue;
+
+        SimDrawItem item;
+        item.position = m_crowd->Position(i);
+        item.heading = m_crowd->Heading(i);
+        if (m_show & SIM_SHOW_SKELETON) {
+            AddSkeleton(frame, item, m_crowd->Instance(i).Poses());
+        }
+        if (m_show & SIM_SHOW_MESH) {
+            bool with_normals = (m_crowd->Normals(i) != NULL) && (m_show & SIM_SHOW_NORMALS);
+            AddMesh(frame, item, m_crowd->InstanceMesh(i), with_normals, NULL);
+        }
+        frame.items.push_back(item);
+        m_copy_instances.push_back(i);
+    }
+    SimCopyTask task(*this, frame);
+    m_jobs->ParallelFor(frame.items.size(), 1, &task);
+
+    for (int level = 0; level < m_crowd->Lods().NumLevels(); level++) {
+        frame.lod_stats.push_back(m_crowd->LodStats(level));
+    }
+}
+
+//bones of the blended pose, joint positions are blended the same way the skin is.
+//Axes of every joint are added when the pose isn't blended
+void Simulation::AddSkeleton(SimFrame& frame, SimDrawItem& item, const SkinPoses& poses) {
+    const SkeletonTopology* topology = m_assets->RestAnimation()->Topology();
+    int num_joints = topology->NumJoints();
+
+    m_joint_positions.resize(num_joints);
+    for (int i = 0; i < num_joints; i++) {
+        m_joint_positions[i] = Vector3::Zero();
+        for (int p = 0; p < poses.num_poses; p++) {
+            m_joint_positions[i] += ((*poses.trans_gb[p])[i] * Vector3::Zero()) * poses.weights[p];
+        }
+    }
+
+    //two line vertices per bone
+    item.first_line = (int)frame.lines.size() / 3;
+    for (int i = 0; i < num_joints; i++) {
+        int parent_id = topology->Parent(i);
+        if (parent_id == -1) continue;
+
+        const Vector3& bone_pos = m_joint_positions[i];
+        const Vector3& parent_pos = m_joint_positions[parent_id];
+        frame.lines.push_back(bone_pos.x);
+        frame.lines.push_back(bone_pos.y);
+        frame.lines.push_back(bone_pos.z);
+        frame.lines.push_back(parent_pos.x);
+        frame.lines.push_back(parent_pos.y);
+        frame.lines.push_back(parent_pos.z);
+    }
+    item.num_lines = (int)frame.lines.size() / 3 - item.first_line;
+
+    item.first_axis = (int)frame.axes.size();
+    if (poses.num_poses == 1) {
+        for (int i = 0; i < num_joints; i++) {
+            frame.axes.push_back((*poses.trans_gb[0])[i]);
+        }
+    }
+    item.num_axes = (int)frame.axes.size() - item.first_axis;
+}
+
+//room for the vertices of mesh in the frame buffers and the triangle ranges to draw: the whole
+//mesh, or with a selection only the kept runs (which with the borrowed vertices is all they index)
+void Simulation::AddMesh(SimFrame& frame, SimDrawItem& item, const Mesh* mesh, bool with_normals,
+                         const ClusterSelection* selection) {
+    item.mesh = mesh;
+    item.first_vertex = frame.num_vertices;
+    item.has_normals = with_normals;
+    frame.num_vertices += mesh->NumVertices();
+    if ((int)frame.positions.size() < frame.num_vertices * 3) {
+        frame.positions.resize(frame.num_vertices * 3);
+    }
+    if (with_normals && (int)frame.normals.size() < frame.num_vertices * 3) {
+        frame.normals.resize(frame.num_vertices * 3);
+    }
+
+    item.first_range = (int)frame.ranges.size();
+    if (selection == NULL) {
+        ClusterRun whole;
+        whole.first_vertex = 0;
+        whole.num_vertices = mesh->NumVertices();
+        whole.first_triangle = 0;
+        whole.num_triangles = mesh->NumTriangles();
+        frame.ranges.push_back(whole);
+    } else {
+        for (int i = 0; i < selection->num_runs; i++) {
+            frame.ranges.push_back(selection->runs[i]);
+        }
+    }
+    item.num_ranges = (int)frame.ranges.size() - item.first_range;
+}
+
+//[begin, end) in chunks, so a large run keeps several workers busy
+void Simulation::AddSkinRanges(int begin, int end) {
+    for (int chunk = begin; chunk < end; chunk += m_chunk_size) {
+        SkinRange range;
+        range.begin = chunk;
+        range.end = std::min(chunk + m_chunk_size, end);
+        m_skin_ranges.push_back(range);
+    }
+}
@@ -9,28 +9,23 @@
 #include "Skeleton.h"
 
 Joint::Joint()
-    : id(0)
-    , parent_id(-1)
-    , position(Vector3::Zero())
+    : position(Vector3::Zero())
     , rotation(Matrix_4x4::Id()) {}
 
-Joint::Joint(int id, int parent_id)
-    : id(id)
-    , parent_id(parent_id) {}
-
 Skeleton::Skeleton()
     : m_joints(NULL)
-    , m_num_joints(0) {}
+    , m_num_joints(0)
+    , m_topology(NULL) {}
 
 Skeleton::~Skeleton() {
     delete[] m_joints;
 }
 
-int Skeleton::NumJoints() {
+int Skeleton::NumJoints() const {
     return m_num_joints;
 }
 
-Joint Skeleton::GetJoint(int i) {
+Joint Skeleton::GetJoint(int i) const {
     return m_joints[i];
 }
 
@@ -38,10 +33,18 @@ void Skeleton::SetJoint(int i, Joint j) {
     m_joints[i] = j;
 }
 
+const SkeletonTopology* Skeleton::Topology() const {
+    return m_topology;
+}
+
+Matrix_4x4 Skeleton::LocalTransform(int i) const {
+    return Matrix_4x4::Translation(m_joints[i].position) * m_joints[i].rotation;
+}
+
 /*
 ** TODO: Implement. This method must return the global transform of a joint
 */
-Matrix_4x4 Skeleton::JointTransform(int i) {
+Matrix_4x4 Skeleton::JointTransform(int i) const {
 	/* This can be optimised further by storing transforms and then
 	 * check if joint transform has been already calculated for this joint
 	 * or any of its parents. But our skeleton is not big and joint path to the root is relatively short.
@@ -49,21 +52,20 @@ Matrix_4x4 Skeleton::JointTransform(int i) {
 	 * Moreover I store these global transforms in the skinning.cpp code
 	 * in order to avoid computing them again in each frame
 	 */
-	Joint joint = this->GetJoint(i);
-	Matrix_4x4 trans = Matrix_4x4::Translation(joint.position) * joint.rotation;
-	Matrix_4x4 result = trans;
-	while (joint.parent_id != -1) {
-		joint = this->GetJoint(joint.parent_id);
-		trans = Matrix_4x4::Translation(joint.position) * joint.rotation;
-		result = trans * result;
+	Matrix_4x4 result = LocalTransform(i);
+	int parent_id = m_topology->Parent(i);
+	while (parent_id != -1) {
+		result = LocalTransform(parent_id) * result;
+		parent_id = m_topology->Parent(parent_id);
 	}
 	return result;
 }
 
-Skeleton* Skeleton::Copy() {
+Skeleton* Skeleton::Copy() const {
 
     Skeleton* copy = new Skeleton();
     copy->m_num_joints = m_num_joints;
+    copy->m_topology = m_topology;
     copy->m_joints = new Joint[copy->m_num_joints];
 
     for(int i = 0; i < copy->m_num_joints; i++) {
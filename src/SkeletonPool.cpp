@@ -0,0 +1,86 @@
+#include "SkeletonPool.h"
+
+#include <algorithm>
+
+//skeleton objects are small, a block holds this many
+static const int SKELETONS_PER_BLOCK = 256;
+
+SkeletonPool::SkeletonPool(int joints_per_block)
+    : m_joints_per_block(std::max(1, joints_per_block))
+    , m_joint_block_size(0)
+    , m_joint_block_used(0)
+    , m_skeleton_block_used(SKELETONS_PER_BLOCK)
+    , m_num_skeletons(0)
+    , m_num_joints(0) {}
+
+SkeletonPool::~SkeletonPool() {
+    //joints belong to the joint blocks, skeletons must not free them
+    for (size_t b = 0; b < m_skeleton_blocks.size(); b++) {
+        for (int i = 0; i < SKELETONS_PER_BLOCK; i++) {
+            m_skeleton_blocks[b][i].m_joints = NULL;
+        }
+        delete[] m_skeleton_blocks[b];
+    }
+    for (size_t b = 0; b < m_joint_blocks.size(); b++) {
+        delete[] m_joint_blocks[b];
+    }
+    for (size_t t = 0; t < m_topologies.size(); t++) {
+        delete m_topologies[t];
+    }
+}
+
+Skeleton* SkeletonPool::NewSkeleton(const SkeletonTopology* topology) {
+    int num_joints = topology->NumJoints();
+    if (m_skeleton_block_used == SKELETONS_PER_BLOCK) {
+        m_skeleton_blocks.push_back(new Skeleton[SKELETONS_PER_BLOCK]);
+        m_skeleton_block_used = 0;
+    }
+    Skeleton* skel = &m_skeleton_blocks.back()[m_skeleton_block_used++];
+
+    //a skeleton never spans two blocks, the rest of the old block is left unused
+    if (m_joint_block_used + num_joints > m_joint_block_size) {
+        m_joint_block_size = std::max(m_joints_per_block, num_joints);
+        m_joint_blocks.push_back(new Joint[m_joint_block_size]);
+        m_joint_block_used = 0;
+    }
+    skel->m_joints = &m_joint_blocks.back()[m_joint_block_used];
+    skel->m_num_joints = num_joints;
+    skel->m_topology = topology;
+    m_joint_block_used += num_joints;
+
+    m_num_skeletons++;
+    m_num_joints += num_joints;
+    return skel;
+}
+
+const SkeletonTopology* SkeletonPool::Intern(const SkeletonTopology& topology) {
+    //already ours, every frame of a clip comes through here
+    for (size_t t = 0; t < m_topologies.size(); t++) {
+        if (m_topologies[t] == &topology) {
+            return m_topologies[t];
+        }
+    }
+    for (size_t t = 0; t < m_topologies.size(); t++) {
+        if (m_topologies[t]->Equals(topology)) {
+            return m_topologies[t];
+        }
+    }
+    m_topologies.push_back(new SkeletonTopology(topology));
+    return m_topologies.back();
+}
+
+int SkeletonPool::NumTopologies() {
+    return m_topologies.size();
+}
+
+int SkeletonPool::NumSkeletons() {
+    return m_num_skeletons;
+}
+
+int SkeletonPool::NumJoints() {
+    return m_num_joints;
+}
+
+int SkeletonPool::NumBlocks() {
+    return m_joint_blocks.size() + m_skeleton_blocks.size();
+}
@@ -0,0 +1,90 @@
+#include "SkeletonTopology.h"
+
+#include <algorithm>
+
+SkeletonTopology::SkeletonTopology(const std::vector<std::string>& names, const std::vector<int>& parents)
+    : m_names(names)
+    , m_parents(parents) {
+    int num_joints = m_parents.size();
+    m_names.resize(num_joints);
+
+    //depth first from the roots, parents out of range are treated as roots
+    std::vector<std::vector<int> > children(num_joints);
+    std::vector<int> stack;
+    for (int i = num_joints - 1; i >= 0; i--) {
+        int parent = m_parents[i];
+        if (parent < 0 || parent >= num_joints || parent == i) {
+            m_parents[i] = -1;
+            stack.push_back(i);
+        } else {
+            children[parent].push_back(i);
+        }
+    }
+
+    //joints on a cycle are never reached from a root: the cycle is cut at one of them, which becomes
+    //a root, until every joint is in the order
+    m_order.reserve(num_joints);
+    std::vector<bool> visited(num_joints, false);
+    while (true) {
+        while (!stack.empty()) {
+            int joint = stack.back();
+            stack.pop_back();
+            visited[joint] = true;
+            m_order.push_back(joint);
+            for (int c = (int)children[joint].size() - 1; c >= 0; c--) {
+                stack.push_back(children[joint][c]);
+            }
+        }
+        if ((int)m_order.size() == num_joints) break;
+
+        std::vector<int> unvisited_parents(m_parents);
+        for (int i = 0; i < num_joints; i++) {
+            if (visited[i]) unvisited_parents[i] = -1;
+        }
+        int root = FindCycle(unvisited_parents);
+        std::vector<int>& siblings = children[m_parents[root]];
+        siblings.erase(std::find(siblings.begin(), siblings.end(), root));
+        m_parents[root] = -1;
+        stack.push_back(root);
+    }
+}
+
+int SkeletonTopology::FindCycle(const std::vector<int>& parents) {
+    int num_joints = parents.size();
+    for (int i = 0; i < num_joints; i++) {
+        //a chain longer than there are joints repeats one
+        int joint = i;
+        for (int steps = 0; steps <= num_joints; steps++) {
+            int parent = parents[joint];
+            if (parent < 0 || parent >= num_joints || parent == joint) {
+                joint = -1;
+                break;
+            }
+            joint = parent;
+        }
+        if (joint != -1) {
+            return joint;
+        }
+    }
+    return -1;
+}
+
+int SkeletonTopology::NumJoints() const {
+    return m_parents.size();
+}
+
+int SkeletonTopology::Parent(int joint_id) const {
+    return m_parents[joint_id];
+}
+
+const std::string& SkeletonTopology::Name(int joint_id) const {
+    return m_names[joint_id];
+}
+
+const std::vector<int>& SkeletonTopology::TraversalOrder() const {
+    return m_order;
+}
+
+bool SkeletonTopology::Equals(const SkeletonTopology& other) const {
+    return m_parents == other.m_parents && m_names == other.m_names;
+}
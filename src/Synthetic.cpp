@@ -0,0 +1,115 @@
+#include "Synthetic.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "Matrix.h"
+#include "Vector.h"
+
+Skeleton* GenerateSkeleton(SkeletonPool& pool, int num_joints, int max_depth, unsigned int seed) {
+    SyntheticRandom random(seed);
+    num_joints = std::max(1, num_joints);
+    max_depth = std::max(1, max_depth);
+
+    std::vector<std::string> names(num_joints);
+    std::vector<int> parents(num_joints, -1);
+    std::vector<Joint> joints(num_joints);
+
+    std::vector<int> depth(num_joints, 1);
+    names[0] = "joint_0";
+
+    for (int i = 1; i < num_joints; i++) {
+        //prefer continuing the last chain, so depth actually gets used
+        int parent = i - 1;
+        if (depth[parent] >= max_depth || random.Uniform() < 0.3f) {
+            do {
+                parent = random.Index(i);
+            } while (depth[parent] >= max_depth);
+        }
+        depth[i] = depth[parent] + 1;
+
+        char name[32];
+        sprintf(name, "joint_%d", i);
+        names[i] = name;
+        parents[i] = parent;
+        joints[i].position = random.Direction() * random.Range(1.0f, 3.0f);
+        joints[i].rotation = Matrix_4x4::RotationAngleAxis(random.Direction(), random.Range(-0.3f, 0.3f));
+    }
+
+    Skeleton* skel = pool.NewSkeleton(pool.Intern(SkeletonTopology(names, parents)));
+    for (int i = 0; i < num_joints; i++) {
+        skel->m_joints[i] = joints[i];
+    }
+    return skel;
+}
+
+Animation* GenerateAnimation(const Skeleton* rest, int num_frames, unsigned int seed) {
+    SyntheticRandom random(seed);
+    int num_joints = rest->NumJoints();
+
+    std::vector<Vector3> axes(num_joints);
+    std::vector<float> amplitudes(num_joints);
+    std::vector<float> phases(num_joints);
+    for (int j = 0; j < num_joints; j++) {
+        axes[j] = random.Direction();
+        amplitudes[j] = random.Range(0.1f, 0.8f);
+        phases[j] = random.Range(0.0f, 6.283f);
+    }
+
+    Animation* anim = new Animation();
+    for (int f = 0; f < num_frames; f++) {
+        Skeleton* frame = anim->AddFrame(rest);
+        float t = 6.283f * f / num_frames;
+        for (int j = 0; j < num_joints; j++) {
+            float angle = amplitudes[j] * sin(t + phases[j]);
+            frame->m_joints[j].rotation = rest->m_joints[j].rotation * Matrix_4x4::RotationAngleAxis(axes[j], angle);
+        }
+    }
+    return anim;
+}
+
+Mesh* GenerateMesh(const Skeleton* rest, int num_vertices, int num_influences, unsigned int seed) {
+    SyntheticRandom random(seed);
+    int num_joints = rest->NumJoints();
+    num_influences = std::max(1, std::min(num_influences, 3));
+    int num_triangles = std::max(1, num_vertices / 3);
+
+    std::vector<Vector3> joint_pos(num_joints);
+    for (int j = 0; j < num_joints; j++) {
+        joint_pos[j] = rest->JointTransform(j) * Vector3::Zero();
+    }
+
+    Mesh* mesh = new Mesh();
+    mesh->m_num_vertices = num_triangles * 3;
+    mesh->m_num_triangles = num_triangles;
+    mesh->m_vertices = new Vertex[mesh->m_num_vertices];
+    mesh->m_triangles = new int[mesh->m_num_triangles * 3];
+
+    for (int t = 0; t < num_triangles; t++) {
+        //triangle around one joint, influenced by it and its ancestors
+        int joint = random.Index(num_joints);
+        Vector3 center = joint_pos[joint] + random.Direction() * random.Range(0.1f, 0.5f);
+
+        int ids[3] = {joint, joint, joint};
+        for (int k = 1; k < num_influences; k++) {
+            int parent = rest->Topology()->Parent(ids[k - 1]);
+            ids[k] = (parent == -1) ? ids[k - 1] : parent;
+        }
+
+        for (int k = 0; k < 3; k++) {
+            Vertex vert;
+            vert.position = center + random.Direction() * 0.1f;
+            vert.normal = random.Direction();
+            vert.weight_ids = Vector3(ids[0], ids[1], ids[2]);
+            vert.weight_amounts = Vector3(random.Range(0.5f, 1.0f),
+                                          (num_influences > 1) ? random.Range(0.1f, 0.5f) : 0.0f,
+                                          (num_influences > 2) ? random.Range(0.0f, 0.3f) : 0.0f);
+            mesh->m_vertices[t * 3 + k] = vert;
+            mesh->m_triangles[t * 3 + k] = t * 3 + k;
+        }
+    }
+
+    return mesh;
+}
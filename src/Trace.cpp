@@ -0,0 +1,130 @@
+#include "Trace.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "Timer.h"
+
+struct TraceEvent {
+    const char* name;
+    double timestamp;   //seconds since TraceStart
+    char phase;         //'B' or 'E'
+};
+
+//Events of one thread. When full, the thread starts another chunk
+struct TraceBuffer {
+    static const int CAPACITY = 1 << 16;
+
+    int tid;
+    const char* thread_name;
+    TraceEvent events[CAPACITY];
+    //events below count are complete
+    volatile int count;
+    TraceBuffer* next;
+};
+
+static volatile bool trace_enabled = false;
+static double trace_start_time = 0;
+static TraceBuffer* volatile trace_buffers = NULL;
+static volatile int trace_next_tid = 0;
+
+static __thread TraceBuffer* thread_buffer = NULL;
+static __thread int thread_tid = -1;
+static __thread const char* thread_name = NULL;
+
+static TraceBuffer* NewBuffer() {
+    if (thread_tid == -1) {
+        thread_tid = __sync_fetch_and_add(&trace_next_tid, 1);
+    }
+
+    TraceBuffer* buffer = new TraceBuffer();
+    buffer->tid = thread_tid;
+    buffer->thread_name = thread_name;
+    buffer->count = 0;
+
+    //push front into the global list
+    TraceBuffer* head;
+    do {
+        head = trace_buffers;
+        buffer->next = head;
+    } while (!__sync_bool_compare_and_swap(&trace_buffers, head, buffer));
+
+    return buffer;
+}
+
+static void Record(const char* name, char phase) {
+    if (!trace_enabled) {
+        return;
+    }
+    if (thread_buffer == NULL || thread_buffer->count == TraceBuffer::CAPACITY) {
+        thread_buffer = NewBuffer();
+    }
+    TraceEvent& event = thread_buffer->events[thread_buffer->count];
+    event.name = name;
+    event.timestamp = TimeSeconds() - trace_start_time;
+    event.phase = phase;
+    //publish the event only after it is written
+    __sync_synchronize();
+    thread_buffer->count++;
+}
+
+void TraceStart() {
+    trace_start_time = TimeSeconds();
+    __sync_synchronize();
+    trace_enabled = true;
+}
+
+bool TraceEnabled() {
+    return trace_enabled;
+}
+
+void TraceSetThreadName(const char* name) {
+    thread_name = name;
+    if (thread_buffer != NULL) {
+        thread_buffer->thread_name = name;
+    }
+}
+
+void TraceBegin(const char* name) {
+    Record(name, 'B');
+}
+
+void TraceEnd(const char* name) {
+    Record(name, 'E');
+}
+
+bool TraceWrite(std::string filename) {
+    FILE* f = fopen(filename.c_str(), "w");
+    if (f == NULL) {
+        return false;
+    }
+
+    int pid = getpid();
+    bool first = true;
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    for (TraceBuffer* buffer = trace_buffers; buffer != NULL; buffer = buffer->next) {
+        if (buffer->thread_name != NULL) {
+            fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                    (first) ? "" : ",\n", pid, buffer->tid, buffer->thread_name);
+            first = false;
+        }
+        int count = buffer->count;
+        for (int i = 0; i < count; i++) {
+            TraceEvent& event = buffer->events[i];
+            fprintf(f, "%s{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d}",
+                    (first) ? "" : ",\n", event.name, event.phase, event.timestamp * 1e6, pid, buffer->tid);
+            first = false;
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return true;
+}
@@ -63,7 +63,7 @@ void Vector2::Print(Vector2 v) {
     printf("Vector2(%0.2f, %0.2f)", v.x, v.y);
 }
 
-float Vector2::operator[](int i) {
+float Vector2::operator[](int i) const {
     if(i == 0) {
         return x;
     } else if (i == 1) {
@@ -74,15 +74,15 @@ float Vector2::operator[](int i) {
     }
 }
 
-bool Vector2::operator==(Vector2 v) {
+bool Vector2::operator==(Vector2 v) const {
     return (x == v.x) && (y == v.y);
 }
 
-bool Vector2::operator!=(Vector2 v) {
+bool Vector2::operator!=(Vector2 v) const {
     return (x != v.x) || (y != v.y);
 }
 
-Vector2 Vector2::operator*(float factor) {
+Vector2 Vector2::operator*(float factor) const {
     return Vector2( x * factor, y * factor );
 }
 
@@ -92,7 +92,7 @@ Vector2 Vector2::operator*=(float factor) {
     return *this;
 }
 
-Vector2 Vector2::operator*(Vector2 v) {
+Vector2 Vector2::operator*(Vector2 v) const {
     return Vector2( x * v.x, y * v.y );
 }
 
@@ -102,19 +102,19 @@ Vector2 Vector2::operator*=(Vector2 v) {
     return *this;
 }
 
-Vector2 Vector2::operator/(float factor) {
+Vector2 Vector2::operator/(float factor) const {
     return Vector2( x / factor, y / factor );
 }
 
-Vector2 Vector2::operator/(Vector2 v) {
+Vector2 Vector2::operator/(Vector2 v) const {
     return Vector2( x / v.x, y / v.y );
 }
 
-Vector2 Vector2::operator+(float factor) {
+Vector2 Vector2::operator+(float factor) const {
     return Vector2( x + factor, y + factor);
 }
 
-Vector2 Vector2::operator+(Vector2 v) {
+Vector2 Vector2::operator+(Vector2 v) const {
     return Vector2( x + v.x, y + v.y);
 }
 
@@ -124,7 +124,7 @@ Vector2 Vector2::operator+=(Vector2 v) {
     return *this;
 }
 
-Vector2 Vector2::operator-(Vector2 v) {
+Vector2 Vector2::operator-(Vector2 v) const {
     return Vector2( x - v.x, y - v.y);
 }
 
@@ -140,7 +140,7 @@ Vector2 Vector2::operator-=(float factor) {
     return *this;
 }
 
-Vector2 Vector2::operator-() {
+Vector2 Vector2::operator-() const {
     return Vector2(-x, -y);
 }
 
@@ -164,15 +164,15 @@ Vector3 Vector3::Zero() {
     return Vector3(0.0, 0.0, 0.0);
 }
 
-float Vector3::r() {
+float Vector3::r() const {
     return x;
 }
 
-float Vector3::g() {
+float Vector3::g() const {
     return y;
 }
 
-float Vector3::b() {
+float Vector3::b() const {
     return z;
 }
 
@@ -228,7 +228,7 @@ void Vector3::Print(Vector3 v) {
     printf("Vector3(%0.2f, %0.2f, %0.2f)", v.x, v.y, v.z);
 }
 
-float Vector3::operator[](int i) {
+float Vector3::operator[](int i) const {
     if(i == 0) {
         return x;
     } else if (i == 1) {
@@ -241,15 +241,15 @@ float Vector3::operator[](int i) {
     }
 }
 
-bool Vector3::operator==(Vector3 v) {
+bool Vector3::operator==(Vector3 v) const {
     return (x == v.x) && (y == v.y) && (z == v.z);
 }
 
-bool Vector3::operator!=(Vector3 v) {
+bool Vector3::operator!=(Vector3 v) const {
     return (x != v.x) || (y != v.y) || (z != v.z);
 }
 
-Vector3 Vector3::operator*(float factor) {
+Vector3 Vector3::operator*(float factor) const {
     return Vector3( x * factor, y * factor, z * factor );
 }
 
@@ -260,7 +260,7 @@ Vector3 Vector3::operator*=(float factor) {
     return *this;
 }
 
-Vector3 Vector3::operator*(Vector3 v) {
+Vector3 Vector3::operator*(Vector3 v) const {
     return Vector3( x * v.x, y * v.y, z * v.z );
 }
 
@@ -271,19 +271,19 @@ Vector3 Vector3::operator*=(Vector3 v) {
     return *this;
 }
 
-Vector3 Vector3::operator/(float factor) {
+Vector3 Vector3::operator/(float factor) const {
     return Vector3( x / factor, y / factor, z / factor );
 }
 
-Vector3 Vector3::operator/(Vector3 v) {
+Vector3 Vector3::operator/(Vector3 v) const {
     return Vector3( x / v.x, y / v.y, z / v.z );
 }
 
-Vector3 Vector3::operator+(Vector3 v) {
+Vector3 Vector3::operator+(Vector3 v) const {
     return Vector3( x + v.x, y + v.y, z + v.z);
 }
 
-Vector3 Vector3::operator+(float factor) {
+Vector3 Vector3::operator+(float factor) const {
     return Vector3( x + factor, y + factor, z + factor);
 }
 
@@ -294,7 +294,7 @@ Vector3 Vector3::operator+=(Vector3 v) {
     return *this;
 }
 
-Vector3 Vector3::operator-(Vector3 v) {
+Vector3 Vector3::operator-(Vector3 v) const {
     return Vector3( x - v.x, y - v.y, z - v.z);
 }
 
@@ -312,11 +312,11 @@ Vector3 Vector3::operator-=(float factor) {
     return *this;
 }
 
-Vector3 Vector3::operator-() {
+Vector3 Vector3::operator-() const {
     return Vector3(-x, -y, -z);
 }
 
-Vector2 Vector3::xy() {
+Vector2 Vector3::xy() const {
     return Vector2(x, y);
 }
 
@@ -372,27 +372,27 @@ void Vector4::Print(Vector4 v) {
     printf("Vector4(%0.2f, %0.2f, %0.2f, %0.2f)", v.x, v.y, v.z, v.w);
 }
 
-float Vector4::r() {
+float Vector4::r() const {
     return x;
 }
 
-float Vector4::g() {
+float Vector4::g() const {
     return y;
 }
 
-float Vector4::b() {
+float Vector4::b() const {
     return z;
 }
 
-float Vector4::a() {
+float Vector4::a() const {
     return w;
 }
 
-Vector3 Vector4::xyz() {
+Vector3 Vector4::xyz() const {
     return Vector3(x, y, z);
 }
 
-Vector3 Vector4::rgb() {
+Vector3 Vector4::rgb() const {
     return Vector3(x, y, z);
 }
 
@@ -429,7 +429,7 @@ Vector4 Vector4::ToHomogeneous(Vector3 v) {
     return Vector4(v.x, v.y, v.z, 1.0);
 }
 
-float Vector4::operator[](int i) {
+float Vector4::operator[](int i) const {
     if(i == 0) {
         return x;
     } else if (i == 1) {
@@ -444,15 +444,15 @@ float Vector4::operator[](int i) {
     }
 }
 
-bool Vector4::operator==(Vector4 v) {
+bool Vector4::operator==(Vector4 v) const {
     return (x == v.x) && (y == v.y) && (z == v.z) && (w == v.w);
 }
 
-bool Vector4::operator!=(Vector4 v) {
+bool Vector4::operator!=(Vector4 v) const {
     return (x != v.x) || (y != v.y) || (z != v.z) || (w != v.w);
 }
 
-Vector4 Vector4::operator*(float factor) {
+Vector4 Vector4::operator*(float factor) const {
     return Vector4( x * factor, y * factor, z * factor, w * factor );
 }
 
@@ -464,7 +464,7 @@ Vector4 Vector4::operator*=(float factor) {
     return *this;
 }
 
-Vector4 Vector4::operator*(Vector4 v) {
+Vector4 Vector4::operator*(Vector4 v) const {
     return Vector4( x * v.x, y * v.y, z * v.z, w * v.w );
 }
 
@@ -476,19 +476,19 @@ Vector4 Vector4::operator*=(Vector4 v) {
     return *this;
 }
 
-Vector4 Vector4::operator/(float factor) {
+Vector4 Vector4::operator/(float factor) const {
     return Vector4( x / factor, y / factor, z / factor, w / factor );
 }
 
-Vector4 Vector4::operator/(Vector4 v) {
+Vector4 Vector4::operator/(Vector4 v) const {
     return Vector4( x / v.x, y / v.y, z / v.z, w / v.w );
 }
 
-Vector4 Vector4::operator+(float factor) {
+Vector4 Vector4::operator+(float factor) const {
     return Vector4( x + factor, y + factor, z + factor, w + factor);
 }
 
-Vector4 Vector4::operator+(Vector4 v) {
+Vector4 Vector4::operator+(Vector4 v) const {
     return Vector4( x + v.x, y + v.y, z + v.z, w + v.w);
 }
 
@@ -500,7 +500,7 @@ Vector4 Vector4::operator+=(Vector4 v) {
     return *this;
 }
 
-Vector4 Vector4::operator-(Vector4 v) {
+Vector4 Vector4::operator-(Vector4 v) const {
     return Vector4( x - v.x, y - v.y, z - v.z, w - v.w);
 }
 
@@ -520,6 +520,6 @@ Vector4 Vector4::operator-=(float factor) {
     return *this;
 }
 
-Vector4 Vector4::operator-() {
+Vector4 Vector4::operator-() const {
     return Vector4(-x, -y, -z, -w);
 }
@@ -0,0 +1,121 @@
+#include "WalkRunBlending.h"
+
+#include <stdio.h>
+
+#include "Vector.h"
+
+//compute distance between two character postures.
+//relies on the fact that two postures have the same root transform
+float ComputeDistSkel(const std::vector<Matrix_4x4>& trans_gb_1, const std::vector<Matrix_4x4>& trans_gb_2) {
+    if (trans_gb_1.size() != trans_gb_2.size()) {
+        printf("The sizes of joints don't match");
+        return 1000000000000;
+    }
+
+    float distance = 0;
+    for (size_t joint_id = 0; joint_id < trans_gb_1.size(); joint_id++) {
+        Vector3 bone_pos1 = trans_gb_1[joint_id] * Vector3::Zero();
+        Vector3 bone_pos2 = trans_gb_2[joint_id] * Vector3::Zero();
+        distance += Vector3::Distance(bone_pos1, bone_pos2);
+    }
+    return distance;
+}
+
+//Create distance table between different frames of Walking/Running animation
+//dists: first index - walk frame, second index - run frame
+void ComputeWalkRunDists(std::vector<std::vector<float> >& dists,
+                         const std::vector<std::vector<Matrix_4x4> >& walk_tpf_gb,
+                         const std::vector<std::vector<Matrix_4x4> >& run_tpf_gb) {
+    int num_run  = run_tpf_gb.size();
+    int num_walk = walk_tpf_gb.size();
+
+    dists.resize(num_walk);
+
+    for (int walk_id = 0; walk_id < num_walk; walk_id++) {
+        dists[walk_id].resize(num_run);
+        for (int run_id = 0; run_id < num_run; run_id++) {
+            dists[walk_id][run_id] = ComputeDistSkel(run_tpf_gb[run_id], walk_tpf_gb[walk_id]);
+        }
+    }
+}
+
+//Compute raw best matches between frames of walking and running animations.
+//This raw matches must be pruned in order to find sequence which forms animation loop.
+//matches: in pairs first is walk frame, second is run frame
+//dists: table computed in ComputeWalkRunDists
+//anim_length: number of frames in initial raw sequence. Must be big enough in order to find animation loop within it
+void ComputeWalkRunMatches(std::vector<std::pair<int, int> >& matches, const std::vector<std::vector<float> >& dists, int anim_length) {
+    int num_walk = dists.size();
+    int num_run  = dists[0].size();
+    //find best initial frames
+    int walk_id = 0;
+    int run_id  = 9;
+    float min_run_dist = 1000000000000;
+    //find the best match between first frame of walk and running animation
+    for (int j = 0; j < num_run; j++) {
+        float dist = dists[walk_id][j];
+        if (dist < min_run_dist) {
+            run_id = j;
+            min_run_dist = dist;
+        }
+    }
+
+    //calculate matches
+    //due to prev_step this algorithm is using
+    //Slope Limit = 2 (for clarification see paper mentioned above)
+    int prev_step = 0;// 1 - horiz, 2 - vert, 3 - diag
+    //saving initial point
+    matches.push_back(std::make_pair(walk_id, run_id));
+    for (int i = 1; i < anim_length; i++) {
+        float dist01 = dists[(walk_id) % num_walk][(run_id + 1) % num_run]; //horiz
+        float dist10 = dists[(walk_id + 1) % num_walk][(run_id) % num_run]; //vert
+        float dist11 = dists[(walk_id + 1) % num_walk][(run_id + 1) % num_run];// diag
+
+        //if dist 01 is smallest
+        if        (dist01 < dist10 && dist01 < dist11 && prev_step != 1) {
+            walk_id = (walk_id) % num_walk;
+            run_id  = (run_id + 1) % num_run;
+            prev_step = 1; //horiz
+
+        } else if (dist10 < dist01 && dist10 < dist11 && prev_step != 2) {
+            walk_id = (walk_id + 1) % num_walk;
+            run_id  = (run_id) % num_run;
+            prev_step = 2; //vert
+        } else {
+            //no choices left going diagonal
+            walk_id = (walk_id + 1) % num_walk;
+            run_id  = (run_id + 1) % num_run;
+            prev_step = 3;//diag
+        }
+        matches.push_back(std::make_pair(walk_id, run_id));
+    }
+}
+
+//Prune raw_matches sequence found in ComputeWalkRunMatches in order to form animation loop (stored in matches).
+//If it doesn't find loop animation then return original raw_matches
+void ComputeWalkRunLoop(const std::vector<std::pair<int, int> >& raw_matches, std::vector<std::pair<int, int> >& matches) {
+    int run_frame = -1;
+    int prev_mix_frame = -1;
+    int T = -1; //period
+    for (int mix_frame=0; mix_frame < (int)raw_matches.size(); mix_frame++) {
+        if (raw_matches[mix_frame].first != 0) {
+            continue;
+        }
+        if (run_frame == raw_matches[mix_frame].second) {
+            T = mix_frame - prev_mix_frame;
+            break;
+        } else {
+            run_frame = raw_matches[mix_frame].second;
+            prev_mix_frame = mix_frame;
+        }
+    }
+    if (T == -1) {
+        printf("\n Haven't found loop for mixed animation, just copy raw mixed animation. Try more frames of raw animation\n");
+        matches = raw_matches;
+    } else {
+        printf("\n Have found loop for mixed walk/run animation with period %d \n", T);
+        for (int mix_frame = prev_mix_frame; mix_frame < (prev_mix_frame + T); mix_frame++) {
+            matches.push_back(raw_matches[mix_frame]);
+        }
+    }
+}
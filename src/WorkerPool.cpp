@@ -0,0 +1,153 @@
+#include "WorkerPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Trace.h"
+
+RangeTask::~RangeTask() {}
+
+struct WorkerStart {
+    WorkerPool* pool;
+    int worker_id;
+};
+
+WorkerPool::WorkerPool(int num_threads)
+    : m_num_threads(std::max(1, num_threads))
+    , m_task(NULL)
+    , m_count(0)
+    , m_chunk_size(1)
+    , m_next_chunk(0)
+    , m_generation(0)
+    , m_num_working(0)
+    , m_quit(false) {
+
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_start_cond, NULL);
+    pthread_cond_init(&m_done_cond, NULL);
+
+    //worker 0 is the calling thread
+    m_threads.resize(m_num_threads - 1);
+    for (int i = 1; i < m_num_threads; i++) {
+        WorkerStart* start = new WorkerStart();
+        start->pool = this;
+        start->worker_id = i;
+        if (pthread_create(&m_threads[i - 1], NULL, ThreadMain, start) != 0) {
+            printf("[ERROR]: Failed to create worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    pthread_mutex_lock(&m_mutex);
+    m_quit = true;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (size_t i = 0; i < m_threads.size(); i++) {
+        pthread_join(m_threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&m_done_cond);
+    pthread_cond_destroy(&m_start_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+int WorkerPool::NumThreads() {
+    return m_num_threads;
+}
+
+int WorkerPool::HardwareThreads() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return std::max(1, (int)info.dwNumberOfProcessors);
+#else
+    return std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+}
+
+void* WorkerPool::ThreadMain(void* arg) {
+    WorkerStart* start = (WorkerStart*)arg;
+    WorkerPool* pool = start->pool;
+    int worker_id = start->worker_id;
+    delete start;
+    TRACE_THREAD_NAME("worker");
+
+    int seen_generation = 0;
+    pthread_mutex_lock(&pool->m_mutex);
+    while (true) {
+        while (!pool->m_quit && pool->m_generation == seen_generation) {
+            pthread_cond_wait(&pool->m_start_cond, &pool->m_mutex);
+        }
+        if (pool->m_quit) {
+            break;
+        }
+        seen_generation = pool->m_generation;
+        pthread_mutex_unlock(&pool->m_mutex);
+
+        pool->RunChunks(worker_id);
+
+        pthread_mutex_lock(&pool->m_mutex);
+        pool->m_num_working--;
+        if (pool->m_num_working == 0) {
+            pthread_cond_signal(&pool->m_done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->m_mutex);
+    return NULL;
+}
+
+void WorkerPool::RunChunks(int worker_id) {
+    int num_chunks = (m_count + m_chunk_size - 1) / m_chunk_size;
+    while (true) {
+        int chunk = __sync_fetch_and_add(&m_next_chunk, 1);
+        if (chunk >= num_chunks) {
+            break;
+        }
+        int begin = chunk * m_chunk_size;
+        int end = std::min(begin + m_chunk_size, m_count);
+        TRACE_SCOPE("chunk");
+        m_task->Run(begin, end, worker_id);
+    }
+}
+
+void WorkerPool::ParallelFor(int count, int chunk_size, RangeTask* task) {
+    if (count <= 0) {
+        return;
+    }
+    chunk_size = std::max(1, chunk_size);
+
+    //nothing to share, don't wake anybody up
+    if (m_num_threads == 1 || count <= chunk_size) {
+        task->Run(0, count, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    m_task = task;
+    m_count = count;
+    m_chunk_size = chunk_size;
+    m_next_chunk = 0;
+    m_num_working = m_num_threads - 1;
+    m_generation++;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    RunChunks(0);
+
+    pthread_mutex_lock(&m_mutex);
+    while (m_num_working > 0) {
+        pthread_cond_wait(&m_done_cond, &m_mutex);
+    }
+    m_task = NULL;
+    pthread_mutex_unlock(&m_mutex);
+}